@@ -0,0 +1,66 @@
+/**
+* Simple application validating the binary columnar dose file (.dose, see DoseFile)
+* and converting it to the CSV layout of the CsvRunAnalysis
+*/
+
+#include <fstream>
+#include <iostream>
+#include "cxxopts.h"
+#include "DoseFile.hh"
+
+int main(int argc, const char *argv[]) {
+  cxxopts::Options options(argv[0], "Validate the binary dose file and convert it to CSV");
+  options.add_options()
+      ("help", "Print help")
+      ("f,File", "Binary dose file (.dose)", cxxopts::value<std::string>(), "FILE")
+      ("c,Csv", "Output CSV file, '-' for the standard output", cxxopts::value<std::string>(), "CSV");
+
+  auto cmdopts = options.parse(argc, argv);
+  if (cmdopts.count("help") || !cmdopts.count("f")) {
+    std::cout << options.help() << std::endl;
+    return cmdopts.count("help") ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+  auto dose_file = cmdopts["f"].as<std::string>();
+
+  try {
+    DoseFile::Reader reader(dose_file);
+    auto problems = reader.Validate();
+    if (!problems.empty()) {
+      for (const auto& problem : problems)
+        std::cerr << dose_file << ": " << problem << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    const auto& header = reader.GetHeader();
+    auto csv_to_stdout = cmdopts.count("c") && cmdopts["c"].as<std::string>() == "-";
+    auto& info = csv_to_stdout ? std::cerr : std::cout;
+    info << "Collection:    " << header.m_collection << " (" << header.m_scoring_type << ")" << std::endl;
+    info << "Control point: " << header.m_cp_id << " (rotation " << header.m_rotation << " deg)" << std::endl;
+    info << "Histories:     " << header.m_n_histories << std::endl;
+    info << "Cells:         " << header.m_cell_shape[0] << " x " << header.m_cell_shape[1] << " x " << header.m_cell_shape[2] << std::endl;
+    if (header.m_voxelised)
+      info << "Voxels:        " << header.m_voxel_shape[0] << " x " << header.m_voxel_shape[1] << " x " << header.m_voxel_shape[2] << std::endl;
+    info << "Origin [mm]:   " << header.m_origin[0] << ", " << header.m_origin[1] << ", " << header.m_origin[2] << std::endl;
+    info << "Pitch [mm]:    " << header.m_pitch[0] << ", " << header.m_pitch[1] << ", " << header.m_pitch[2] << std::endl;
+    info << "Entries:       " << header.m_n_entries << std::endl;
+    for (std::size_t i = 0; i < header.m_n_columns; ++i) {
+      const auto& column = reader.GetColumn(i);
+      info << "  [" << i << "] " << column.m_name << " (type " << column.m_dtype << ", offset " << column.m_offset << ")" << std::endl;
+    }
+
+    if (csv_to_stdout) {
+      reader.ToCsv(std::cout);
+    } else if (cmdopts.count("c")) {
+      std::ofstream csv(cmdopts["c"].as<std::string>());
+      reader.ToCsv(csv);
+      if (!csv) {
+        std::cerr << "Writing the CSV file failed" << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
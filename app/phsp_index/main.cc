@@ -0,0 +1,43 @@
+/**
+* Simple application building the .IAEAindex history index sidecar of the IAEA phase-space file
+*/
+
+#include <cstdio>
+#include <iostream>
+#include "cxxopts.h"
+#include "G4IAEAphspReader.hh"
+#include "G4IAEAphspIndex.hh"
+
+int main(int argc, const char *argv[]) {
+  cxxopts::Options options(argv[0], "Build the history index of the IAEA phase-space file");
+  options.add_options()
+      ("help", "Print help")
+      ("f,File", "Phase-space file, without the .IAEAphsp extension", cxxopts::value<std::string>(), "FILE")
+      ("k,Stride", "Index every Kth history", cxxopts::value<int>()->default_value("1024"), "K");
+
+  auto cmdopts = options.parse(argc, argv);
+  if (cmdopts.count("help") || !cmdopts.count("f")) {
+    std::cout << options.help() << std::endl;
+    return cmdopts.count("help") ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+  auto phsp_file = cmdopts["f"].as<std::string>();
+  auto stride = cmdopts["k"].as<int>();
+  if (stride < 1) {
+    std::cerr << "The stride must be positive" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // the existing sidecar is always rebuilt
+  std::remove((phsp_file + ".IAEAindex").c_str());
+
+  G4IAEAphspReader reader(phsp_file);
+  reader.UseHistoryIndex(stride);
+
+  auto index = reader.GetHistoryIndex();
+  std::cout << "Histories:          " << index->GetNumberOfHistories() << std::endl;
+  std::cout << "Original histories: " << index->GetOriginalHistories() << " (header: " << reader.GetOriginalHistories()
+            << ")" << std::endl;
+  std::cout << "Index entries:      " << index->GetNumberOfEntries() << " (every " << index->GetStride()
+            << " histories)" << std::endl;
+  return EXIT_SUCCESS;
+}
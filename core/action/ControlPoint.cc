@@ -12,10 +12,17 @@
     #include "G4Threading.hh"
     #include "G4MTRunManager.hh"
 #endif
-#include <random>
 #include "VMlc.hh"
+#include "FieldMaskRaster.hh"
 #include "Services.hh"
 #include <numeric> 
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <chrono>
 
 double ControlPoint::FIELD_MASK_POINTS_DISTANCE = 0.50 * mm;
 std::string ControlPoint::m_sim_dir = "sim";
@@ -24,6 +31,67 @@ std::map<G4String,std::vector<G4String>> ControlPoint::m_run_collections = std::
 
 namespace {
     G4Mutex CPMutex = G4MUTEX_INITIALIZER;
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// Persistent threads reducing the worker scorings (see ControlPointRun::Merge),
+    /// started with the first job and kept for the following control points
+    class ScoringReductionPool {
+      private:
+        std::vector<std::thread> m_threads;
+        std::mutex m_mutex;
+        std::condition_variable m_job_added;
+        std::deque<std::function<void()>> m_queue;
+        bool m_stop = false;
+
+        ///
+        void Process(){
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while(true){
+                m_job_added.wait(lock, [&]{ return m_stop || !m_queue.empty(); });
+                if(m_queue.empty()) // stopped
+                    return;
+                auto job = std::move(m_queue.front());
+                m_queue.pop_front();
+                lock.unlock();
+                job();
+                lock.lock();
+            }
+        }
+
+        ScoringReductionPool() = default;
+
+        ~ScoringReductionPool(){
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stop = true;
+            }
+            m_job_added.notify_all();
+            for(auto& thread : m_threads)
+                thread.join();
+        }
+
+      public:
+        ///
+        static ScoringReductionPool* GetInstance(){
+            static ScoringReductionPool instance;
+            return &instance;
+        }
+
+        ///
+        std::size_t Size() const { return std::max(1u, std::thread::hardware_concurrency()); }
+
+        ///
+        void Submit(std::function<void()> job){
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if(m_threads.empty())
+                    for(std::size_t i = 0; i < Size(); ++i)
+                        m_threads.emplace_back(&ScoringReductionPool::Process, this);
+                m_queue.emplace_back(std::move(job));
+            }
+            m_job_added.notify_one();
+        }
+    };
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -47,7 +115,7 @@ void ControlPointRun::InitializeScoringCollection(){
             }
             auto& scoring_collection = m_hashed_scoring_map.at(run_collection_name);
             // Try to get scoring collection from any scoring volume in the world..
-            std::map<std::size_t, VoxelHit> sc; 
+            VoxelHitMap sc; 
             if(Service<GeoSvc>()->Patient())
                 sc = Service<GeoSvc>()->Patient()->GetScoringHashedMap(run_collection_name,scoring_type);
             if(sc.empty()){
@@ -76,50 +144,113 @@ void ControlPointRun::InitializeScoringCollection(){
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-///
+/// Note: G4MTRunManager calls it sequentially for each worker (under the lock), hence
+/// the worker scoring buffer is only handed over here; it's reduced pairwise with the other
+/// workers ones in the background (see ScheduleReduction), meanwhile the remaining workers run.
 void ControlPointRun::Merge(const G4Run* worker_run){
     LOGSVC_INFO("Run-{} merging...",worker_run->GetRunID());
-    auto cell_size = D3DCell::SIZE;
-    auto cell_volume = cell_size*cell_size*cell_size;
-    auto merge = [&](ScoringMap& left, const ScoringMap& right){
-        for(auto& scoring : left){
-            G4double total_dose(0);
-            auto& type = scoring.first;
-            bool isVoxel = type == Scoring::Type::Voxel ? true : false;
-            // LOGSVC_INFO("Scoring type: {}",Scoring::to_string(type));
-            auto& hashed_scoring_left = scoring.second;
-            const auto& hashed_scoring_right = right.at(type);
-            for(auto& hashed_voxel : hashed_scoring_left){
-                hashed_voxel.second.Cumulate(hashed_scoring_right.at(hashed_voxel.first),isVoxel); // VoxelHit+=VoxelHit
-                auto voxel_volume = hashed_voxel.second.GetVolume();
-                if(isVoxel && voxel_volume < cell_volume){
-                    //LOGSVC_INFO("Voxel / Cell volume: {} / {}",voxel_volume,cell_volume);
-                    total_dose += hashed_voxel.second.GetDose()*voxel_volume/cell_volume;
-                } else {
-                    total_dose += hashed_voxel.second.GetDose();
-                }
-            }
-            // LOGSVC_INFO("Total dose: {}",total_dose);
-        } 
-    };
-
-    for(auto& scoring : m_hashed_scoring_map){
-        auto scoring_name = scoring.first;
-        // LOGSVC_INFO("Merging collection: {}",scoring_name);
-        auto& master_scoring = scoring.second;
-        // LOGSVC_DEBUG("Master scoring #types: {}",master_scoring.size());
-        const auto& worker_scoring = dynamic_cast<const ControlPointRun*>(worker_run)->m_hashed_scoring_map.at(scoring_name);
-        // LOGSVC_DEBUG("Worker scoring #types: {}",worker_scoring.size());
-        merge(master_scoring,worker_scoring);
+    G4Run::Merge(worker_run); // number of events (histories)
+    auto cp_worker_run = dynamic_cast<const ControlPointRun*>(worker_run);
+    if(!cp_worker_run->m_hashed_scoring_map.empty()){
+        std::lock_guard<std::mutex> lock(m_reduction_mutex);
+        m_pending_scoring_buffers.emplace_back(std::move(cp_worker_run->m_hashed_scoring_map));
+        ++m_merged_workers;
+        ScheduleReduction();
     }
+    cp_worker_run->m_hashed_scoring_map.clear();
 
-    // Realease memory after merging... we don't need this anymore.
-    dynamic_cast<const ControlPointRun*>(worker_run)->m_hashed_scoring_map.clear();
-    auto& w_sim_mask_points = dynamic_cast<const ControlPointRun*>(worker_run)->m_sim_mask_points;
+    auto& w_sim_mask_points = cp_worker_run->m_sim_mask_points;
     for(const auto& pos : w_sim_mask_points){
         m_sim_mask_points.push_back(pos);
     }
     w_sim_mask_points.clear();
+
+    m_accepted_primaries += cp_worker_run->m_accepted_primaries;
+    m_rejected_primaries += cp_worker_run->m_rejected_primaries;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// Note: to be called with the m_reduction_mutex locked
+void ControlPointRun::ScheduleReduction(){
+    auto& pending = m_pending_scoring_buffers;
+    while(pending.size() > 1){
+        auto pair = std::make_shared<std::pair<std::map<G4String,ScoringMap>,std::map<G4String,ScoringMap>>>(
+                        std::move(pending[pending.size()-2]), std::move(pending.back()));
+        pending.resize(pending.size()-2);
+        ++m_reductions_in_flight;
+        ScoringReductionPool::GetInstance()->Submit([this, pair](){
+            auto start = std::chrono::steady_clock::now();
+            CumulateScoring(pair->first, pair->second);
+            pair->second.clear(); // release memory, we don't need this anymore
+            auto wall_time = std::chrono::duration<G4double>(std::chrono::steady_clock::now() - start).count();
+            {
+                std::lock_guard<std::mutex> lock(m_reduction_mutex);
+                m_merge_wall_time += wall_time;
+                m_pending_scoring_buffers.emplace_back(std::move(pair->first));
+                --m_reductions_in_flight;
+                ScheduleReduction();
+                m_reduction_done.notify_all(); // under the lock, the run may be gone right after
+            }
+        });
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+void ControlPointRun::ReduceWorkerScoring(){
+    std::unique_lock<std::mutex> lock(m_reduction_mutex);
+    m_reduction_done.wait(lock, [&]{ return m_reductions_in_flight == 0 && m_pending_scoring_buffers.size() < 2; });
+    if(m_pending_scoring_buffers.empty())
+        return;
+    auto workers_scoring = std::move(m_pending_scoring_buffers.front());
+    m_pending_scoring_buffers.clear();
+    lock.unlock();
+
+    // The final one into this run, the slots are striped over the pool threads
+    auto start = std::chrono::steady_clock::now();
+    auto pool = ScoringReductionPool::GetInstance();
+    auto nStripes = pool->Size();
+    std::mutex stripes_mutex;
+    std::condition_variable stripes_done;
+    std::size_t nDone = 0;
+    for(std::size_t stripe = 0; stripe < nStripes; ++stripe){
+        pool->Submit([&, stripe](){
+            CumulateScoring(m_hashed_scoring_map, workers_scoring, stripe, nStripes);
+            std::lock_guard<std::mutex> stripes_lock(stripes_mutex);
+            ++nDone;
+            stripes_done.notify_all();
+        });
+    }
+    std::unique_lock<std::mutex> stripes_lock(stripes_mutex);
+    stripes_done.wait(stripes_lock, [&]{ return nDone == nStripes; });
+    m_merge_wall_time += std::chrono::duration<G4double>(std::chrono::steady_clock::now() - start).count();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+void ControlPointRun::CumulateScoring(std::map<G4String,ScoringMap>& left, const std::map<G4String,ScoringMap>& right,
+                                      std::size_t stripe, std::size_t nStripes){
+    for(auto& scoring : left){
+        auto right_scoring = right.find(scoring.first);
+        if(right_scoring == right.end())
+            continue;
+        for(auto& typed_scoring : scoring.second){
+            bool isVoxel = typed_scoring.first == Scoring::Type::Voxel;
+            auto& left_hits = typed_scoring.second;
+            const auto& right_hits = right_scoring->second.at(typed_scoring.first);
+            // Both are copies of the same scoring template, hence typically the slots are matching
+            bool same_layout = left_hits.HasSameLayout(right_hits);
+            auto size = left_hits.size();
+            auto stripe_size = nStripes > 1 ? (size + nStripes - 1) / nStripes : size;
+            auto begin = std::min(size, stripe * stripe_size);
+            auto end = std::min(size, begin + stripe_size);
+            for(std::size_t slot = begin; slot < end; ++slot){
+                const auto& other_voxel = same_layout ? right_hits[slot]
+                                                      : right_hits.at(left_hits.GetKey(slot));
+                left_hits[slot].Cumulate(other_voxel,isVoxel); // VoxelHit+=VoxelHit
+            }
+        }
+    }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -133,6 +264,15 @@ ScoringMap& ControlPointRun::GetScoringCollection(const G4String& name){
 ////////////////////////////////////////////////////////////////////////////////
 ///
 void ControlPointRun::EndOfRun(){
+    auto nFiltered = m_accepted_primaries + m_rejected_primaries;
+    if(nFiltered > 0)
+        LOGSVC_INFO("ControlPointRun:: CP-{} phsp pre-filter: {} accepted / {} rejected ({:.2f}% accepted)",
+                    Service<RunSvc>()->CurrentControlPoint()->GetId(), m_accepted_primaries, m_rejected_primaries,
+                    100. * m_accepted_primaries / nFiltered);
+    ReduceWorkerScoring();
+    if(m_merged_workers > 0)
+        LOGSVC_INFO("ControlPointRun:: CP-{} scoring of #{} workers merged in {} s",
+                    Service<RunSvc>()->CurrentControlPoint()->GetId(), m_merged_workers, m_merge_wall_time);
     if(m_hashed_scoring_map.size()>0){
         LOGSVC_INFO("ControlPointRun::EndOfRun...");
         FillMlcFieldScalingFactor();
@@ -178,10 +318,10 @@ void ControlPointRun::FillMlcFieldScalingFactor(){
             G4double max = -10000.;
             G4double min =  10000.;
             for(auto& hit : scoring.second){
-                // hit.second.SetFieldScalingFactor(current_cp->GetMlcFieldScalingFactor(hit.second.GetCentre()));
-                auto fsf = current_cp->GetMlcWeightedInfluenceFactor(hit.second.GetCentre());
+                // hit.SetFieldScalingFactor(current_cp->GetMlcFieldScalingFactor(hit.GetCentre()));
+                auto fsf = current_cp->GetMlcWeightedInfluenceFactor(hit.GetCentre());
                 fsf = fsf/patientNormalizationFactor;
-                hit.second.SetFieldScalingFactor(fsf);
+                hit.SetFieldScalingFactor(fsf);
                 if (fsf > max) max = fsf;
                 if (fsf < min) min = fsf;
             } 
@@ -190,9 +330,9 @@ void ControlPointRun::FillMlcFieldScalingFactor(){
             G4double max_new = 0.98;
             G4double min_new = 0.02;
             for(auto& hit : scoring.second){
-                auto hit_fsf = hit.second.GetFieldScalingFactor();
+                auto hit_fsf = hit.GetFieldScalingFactor();
                 auto new_fsf = (hit_fsf-min)/(max-min) * (max_new-min_new) + min_new;
-                hit.second.SetFieldScalingFactor(new_fsf);
+                hit.SetFieldScalingFactor(new_fsf);
             } 
         }
     }
@@ -363,16 +503,22 @@ void ControlPoint::FillPlanFieldMask(){
     LOGSVC_DEBUG("Using the {} field shape and {} deg rotation",m_config.FieldType,GetDegreeRotation());
 
     double z_position = configSvc->GetValue<G4ThreeVector>("WorldConstruction", "Isocentre").getZ();
+    auto pitch = configSvc->GetValue<double>("RunSvc", "FieldMaskResolution") * mm;
+    if(pitch <= 0){
+        G4String msg = "The RunSvc::FieldMaskResolution has to be positive";
+        LOGSVC_CRITICAL(msg.data());
+        G4Exception("ControlPoint", "FillPlanFieldMask", FatalErrorInArgument, msg);
+    }
     
     // NOTE: The MLC instance takes care for being set for the current
     //       control point configuration!
 
     if( m_config.FieldType.compare("Rectangular")==0 ||
         m_config.FieldType.compare("Elipsoidal")==0){
-        FillPlanFieldMaskForRegularShapes(z_position);
+        FillPlanFieldMaskForRegularShapes(z_position,pitch);
     }
     if(m_config.FieldType.compare("RTPlan")==0 || m_config.FieldType.compare("CustomPlan")==0){
-        FillPlanFieldMaskForInputPlan(z_position);
+        FillPlanFieldMaskForInputPlan(z_position,pitch);
     }
     if(m_plan_mask_points.empty()){
         G4String msg = "Field Mask not filled! Verify job configuration!";
@@ -384,74 +530,67 @@ void ControlPoint::FillPlanFieldMask(){
 
 ////////////////////////////////////////////////////////////////////////////////
 ///
-void ControlPoint::FillPlanFieldMaskForRegularShapes(double current_z){
-    double current_x,current_y;
-    double x_range, y_range;
-
-    auto rotate = [&](const G4ThreeVector& position) -> G4ThreeVector {
-        return m_rotation ? *m_rotation * position : position;
-    };
-    x_range = m_config.FieldSizeA;
-    y_range = m_config.FieldSizeB;
+void ControlPoint::FillPlanFieldMaskForRegularShapes(double current_z, double pitch){
+    double x_range = m_config.FieldSizeA;
+    double y_range = m_config.FieldSizeB;
     if(x_range < 0 || y_range < 0){
         G4String msg = "Field size is not correct";
         LOGSVC_CRITICAL("Field size is not correct: A {}, B {}",x_range,y_range);
         G4Exception("ControlPoint", "FillPlanFieldMask", FatalErrorInArgument, msg);
     }
+    double half_x = x_range / 2.;
+    double half_y = y_range / 2.;
 
-    double min_x = - x_range / 2.;
-    double max_x = + x_range / 2.;
-    double dx = FIELD_MASK_POINTS_DISTANCE;
-    int n_x = (max_x - min_x ) / dx ;
-    double min_y = - y_range / 2.;
-    double max_y = + y_range / 2.;
-    double dy = FIELD_MASK_POINTS_DISTANCE;
-    int n_y = (max_y - min_y ) / dy;
-    current_x = min_x + (0.5 * FIELD_MASK_POINTS_DISTANCE);
-    current_y = min_y + (0.5 * FIELD_MASK_POINTS_DISTANCE);
-    for(int i = 0; i<n_x; i++){
-        current_y = min_y + (0.5 * FIELD_MASK_POINTS_DISTANCE);
-        for(int j = 0; j<n_y; j++){
-            if(m_config.FieldType.compare("Elipsoidal")==0){
-                if ((pow(current_x,2)/ pow((x_range / 2.),2) + pow(current_y,2)/pow((y_range / 2.),2)) < 1 ){
-                    m_plan_mask_points.push_back(rotate(G4ThreeVector(current_x,current_y,current_z)));
-                } 
-            } else { // Rectangular
-                m_plan_mask_points.push_back(rotate(G4ThreeVector(current_x,current_y,current_z)));
-            }
-            current_y += dy;
-        }
-        current_x += dx ;
+    std::vector<FieldMaskRaster::Point2D> pixels;
+    if(m_config.FieldType.compare("Elipsoidal")==0){
+        pixels = FieldMaskRaster::Rasterize(-half_y, half_y, pitch, [&](double y, FieldMaskRaster::Spans& spans){
+            auto t = 1. - pow(y,2) / pow(half_y,2);
+            if(t > 0)
+                spans.emplace_back(-half_x * sqrt(t), half_x * sqrt(t));
+        });
+    } else { // Rectangular
+        pixels = FieldMaskRaster::Rasterize({{-half_x,-half_y},{half_x,-half_y},{half_x,half_y},{-half_x,half_y}}, pitch);
     }
+    FillPlanFieldMaskPoints(pixels, current_z);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-///
-void ControlPoint::FillPlanFieldMaskForInputPlan(double current_z){
-    auto rotate = [&](const G4ThreeVector& position) -> G4ThreeVector {
-        return m_rotation ? *m_rotation * position : position;
-    };
+/// The aperture polygon of the MLC is rasterized, once it's not provided (e.g. the MLC
+/// not being modelled as polygon) each pixel of the +/-200 mm area is tested with IsInField
+void ControlPoint::FillPlanFieldMaskForInputPlan(double current_z, double pitch){
+    if(!MLC()->Initialized(this)){
+        G4String msg = "The plan field mask is requested before MLC initialization for #CP "+std::to_string(GetId());
+        LOGSVC_CRITICAL(msg.data());
+        G4Exception("ControlPoint", "FillPlanFieldMask", FatalErrorInArgument, msg);
+    }
+    auto polygon = MLC()->GetFieldPolygon();
+    if(!polygon.empty()){
+        FillPlanFieldMaskPoints(FieldMaskRaster::Rasterize(polygon, pitch), current_z);
+        return;
+    }
+    double half_size = 200*mm;
+    auto pixels = FieldMaskRaster::Rasterize(-half_size, half_size, pitch, [&](double, FieldMaskRaster::Spans& spans){
+        spans.emplace_back(-half_size, half_size);
+    });
+    pixels.erase(std::remove_if(pixels.begin(), pixels.end(), [&](const FieldMaskRaster::Point2D& pixel){
+        return !MLC()->IsInField(G4ThreeVector(pixel.first,pixel.second,current_z));
+    }), pixels.end());
+    FillPlanFieldMaskPoints(pixels, current_z);
+}
 
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<double> dis_x(-200*mm, 200*mm);
-    std::uniform_real_distribution<double> dis_y(-200*mm, 200*mm);
-
-    for (int i = 0; i < 10000000; ++i) {
-        auto x = dis_x(gen);
-        auto y = dis_y(gen);
-        auto in_field = MLC()->IsInField(G4ThreeVector(x,y,current_z));
-        // std::cout << x << " " << y << " " << current_z << " inField "<< in_field <<  std::endl;
-        if(in_field){
-            m_plan_mask_points.push_back(rotate(G4ThreeVector(x,y,current_z)));
-        }
-        if(m_plan_mask_points.size()>=100000) break;
+////////////////////////////////////////////////////////////////////////////////
+///
+void ControlPoint::FillPlanFieldMaskPoints(const std::vector<std::pair<double,double>>& pixels, double current_z){
+    m_plan_mask_points.reserve(pixels.size());
+    for(const auto& pixel : pixels){
+        G4ThreeVector position(pixel.first,pixel.second,current_z);
+        m_plan_mask_points.push_back(m_rotation ? *m_rotation * position : position);
     }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 ///
-void ControlPoint::DumpVolumeMaskToFile(std::string scoring_vol_name, const std::map<std::size_t, VoxelHit>& volume_scoring) const { // TODEL? 
+void ControlPoint::DumpVolumeMaskToFile(std::string scoring_vol_name, const VoxelHitMap& volume_scoring) const { // TODEL? 
     auto output_dir = Service<ConfigSvc>()->GetValue<std::string>("RunSvc", "OutputDir");
     const std::string file = output_dir+"/cp-"+std::to_string(GetId())+"_scoring_volume"+scoring_vol_name+"mask.csv";
     std::string header = "X [mm],Y [mm],Z [mm],mX [mm],mY [mm],mZ [mm],inFieldTag";
@@ -459,9 +598,9 @@ void ControlPoint::DumpVolumeMaskToFile(std::string scoring_vol_name, const std:
     c_outFile.open(file.c_str(), std::ios::out);
     c_outFile << header << std::endl;
     for(auto& vol : volume_scoring){
-        auto pos = vol.second.GetCentre();
+        auto pos = vol.GetCentre();
         auto trans_pos = VMlc::GetPositionInMaskPlane(pos);
-        auto inFieldTag = vol.second.GetFieldScalingFactor();
+        auto inFieldTag = vol.GetFieldScalingFactor();
         // std::cout << "z: " << pos.getZ() << "  trans z: "<< trans_pos.getZ() << std::endl;
         c_outFile << pos.getX() << "," << pos.getY() << "," << pos.getZ();
         c_outFile << "," << trans_pos.getX() << "," << trans_pos.getY() << "," << trans_pos.getZ() << "," << inFieldTag << std::endl;
@@ -529,7 +668,7 @@ G4double ControlPoint::GetMlcWeightedInfluenceFactor(const G4ThreeVector& positi
 
 ////////////////////////////////////////////////////////////////////////////////
 /// 
-void ControlPoint::FillEventCollections(G4HCofThisEvent* evtHC){
+void ControlPoint::FillEventCollections(G4HCofThisEvent* evtHC, G4int eventId){
     for(const auto& run_collection: ControlPoint::m_run_collections){
         // LOGSVC_DEBUG("RunAnalysis::EndOfEvent: RunColllection {}",run_collection.first);
         for(const auto& hc: run_collection.second){
@@ -543,7 +682,7 @@ void ControlPoint::FillEventCollections(G4HCofThisEvent* evtHC){
             else {
                 auto thisHitsCollPtr = evtHC->GetHC(collID);
                 if(thisHitsCollPtr) // The particular collection is stored at the current event.
-                    FillEventCollection(run_collection.first,dynamic_cast<VoxelHitsCollection*>(thisHitsCollPtr));
+                    FillEventCollection(run_collection.first,dynamic_cast<VoxelHitsCollection*>(thisHitsCollPtr),eventId);
             }
         }
     }
@@ -551,7 +690,7 @@ void ControlPoint::FillEventCollections(G4HCofThisEvent* evtHC){
 
 ////////////////////////////////////////////////////////////////////////////////
 ///
-void ControlPoint::FillEventCollection(const G4String& run_collection, VoxelHitsCollection* hitsColl){
+void ControlPoint::FillEventCollection(const G4String& run_collection, VoxelHitsCollection* hitsColl, G4int eventId){
     int nHits = hitsColl->entries();
     auto hc_name = hitsColl->GetName();
     if(nHits==0){
@@ -563,20 +702,20 @@ void ControlPoint::FillEventCollection(const G4String& run_collection, VoxelHits
         for(auto& sc : scoring_collection ){
             const auto& current_scoring_type = sc.first;
             auto& current_scoring_collection = sc.second;
-            std::size_t hashed_id;
+            Scoring::Key packed_id = 0;
             bool exact_volume_match = true;
             switch (current_scoring_type){
                 case Scoring::Type::Cell:
-                    hashed_id = hit->GetGlobalHashedStrId();
+                    packed_id = hit->GetGlobalPackedId();
                     exact_volume_match = false;
                     break;
                 case Scoring::Type::Voxel:
-                    hashed_id = hit->GetHashedStrId();
+                    packed_id = hit->GetPackedId();
                     break;
                 default:
                     break;
             }
-            current_scoring_collection.at(hashed_id).Cumulate(*hit,exact_volume_match);
+            current_scoring_collection.at(packed_id).CumulateHistory(*hit,eventId,exact_volume_match);
         }
     }
 }
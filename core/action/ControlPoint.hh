@@ -14,9 +14,9 @@
 #include "G4Cache.hh"
 #include "VPatient.hh"
 #include "G4Run.hh"
-#include "VoxelHit.hh"
-
-typedef std::map<Scoring::Type, std::map<std::size_t, VoxelHit>> ScoringMap;
+#include "VoxelHitMap.hh"
+#include <condition_variable>
+#include <mutex>
 
 class ControlPoint;
 class VMlc;
@@ -41,10 +41,36 @@ class ControlPointRun : public G4Run {
     mutable std::map<G4String,ScoringMap> m_hashed_scoring_map;
 
     mutable std::vector<G4ThreeVector> m_sim_mask_points;
+
+    /// Number of the worker scorings handed over in Merge
+    G4int m_merged_workers = 0;
+
+    /// Wall time of the worker scoring reduction, summed over the reduction jobs [s]
+    G4double m_merge_wall_time = 0.;
+
+    /// Worker scorings (or the partial sums of them) waiting for the pairwise reduction
+    std::vector<std::map<G4String,ScoringMap>> m_pending_scoring_buffers;
+    G4int m_reductions_in_flight = 0;
+    std::mutex m_reduction_mutex;
+    std::condition_variable m_reduction_done;
+
+    /// Phase-space particles accepted/rejected by the reader pre-filter (see PhspFieldFilter)
+    G4long m_accepted_primaries = 0;
+    G4long m_rejected_primaries = 0;
     
     ///
     void InitializeScoringCollection();
 
+    /// Reduce the pending buffers pairwise in the background (the m_reduction_mutex is locked by the caller)
+    void ScheduleReduction();
+
+    /// Wait for the pairwise reduction and cumulate its result into this run scoring
+    void ReduceWorkerScoring();
+
+    /// Cumulate right into left, the given stripe (of nStripes) of the slots of each scoring map only
+    static void CumulateScoring(std::map<G4String,ScoringMap>& left, const std::map<G4String,ScoringMap>& right,
+                                std::size_t stripe = 0, std::size_t nStripes = 1);
+
     ///
     void FillMlcFieldScalingFactor();
     
@@ -56,6 +82,9 @@ class ControlPointRun : public G4Run {
     };
 
     ~ControlPointRun(){
+      // the reduction jobs refer to this run
+      std::unique_lock<std::mutex> lock(m_reduction_mutex);
+      m_reduction_done.wait(lock, [&]{ return m_reductions_in_flight == 0; });
       G4cout << "DESTRUCOTOR OF ControlPointRun..." << G4endl;
     };
 
@@ -72,6 +101,17 @@ class ControlPointRun : public G4Run {
     std::vector<G4ThreeVector>& GetSimMaskPoints() {return m_sim_mask_points;}
     const std::vector<G4ThreeVector>& GetSimMaskPoints() const {return m_sim_mask_points;}
 
+    ///
+    G4double GetMergeWallTime() const {return m_merge_wall_time;}
+
+    ///
+    void CountFilteredPrimaries(G4long accepted, G4long rejected) {
+      m_accepted_primaries += accepted;
+      m_rejected_primaries += rejected;
+    }
+    G4long GetAcceptedPrimaries() const {return m_accepted_primaries;}
+    G4long GetRejectedPrimaries() const {return m_rejected_primaries;}
+
     ///
     void EndOfRun();
 };
@@ -93,7 +133,7 @@ class ControlPoint {
 
     const std::vector<G4ThreeVector>& GetFieldMask(const std::string& type="Plan");
     
-    void DumpVolumeMaskToFile(std::string scoring_vol_name, const std::map<std::size_t, VoxelHit>& volume_scoring) const;
+    void DumpVolumeMaskToFile(std::string scoring_vol_name, const VoxelHitMap& volume_scoring) const;
     std::string GetSimOutputTFileName(bool workerMT = false) const;
 
     static std::string GetOutputDir();
@@ -115,7 +155,8 @@ class ControlPoint {
 
     const std::vector<std::string>& DataTypes() const { return m_data_types; }
 
-    void FillEventCollections(G4HCofThisEvent* evtHC);
+    /// The event ID identifies the history for the dose uncertainty estimation
+    void FillEventCollections(G4HCofThisEvent* evtHC, G4int eventId);
 
     void FillSimFieldMask(const std::vector<G4PrimaryVertex*>& p_vrtx);
 
@@ -163,9 +204,11 @@ class ControlPoint {
     static void RegisterRunHCollection(const G4String& collection_name, const G4String& hc_name);
 
     static double FIELD_MASK_POINTS_DISTANCE;
-    void FillPlanFieldMaskForRegularShapes(double current_z);
-    void FillPlanFieldMaskForInputPlan(double current_z);
-    void FillEventCollection(const G4String& run_collection, VoxelHitsCollection* hitsColl);
+    /// The plan field mask is rasterized (see FieldMaskRaster) with the RunSvc::FieldMaskResolution pitch
+    void FillPlanFieldMaskForRegularShapes(double current_z, double pitch);
+    void FillPlanFieldMaskForInputPlan(double current_z, double pitch);
+    void FillPlanFieldMaskPoints(const std::vector<std::pair<double,double>>& pixels, double current_z);
+    void FillEventCollection(const G4String& run_collection, VoxelHitsCollection* hitsColl, G4int eventId);
 
 };
 
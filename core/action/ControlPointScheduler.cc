@@ -0,0 +1,108 @@
+#include "ControlPointScheduler.hh"
+#include "ControlPoint.hh"
+#include "Services.hh"
+#include "Randomize.hh"
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <unistd.h>
+#include <sys/wait.h>
+
+////////////////////////////////////////////////////////////////////////////////
+///
+ControlPointScheduler::ControlPointScheduler(int nPools)
+: m_nPools(std::max(1,nPools)){}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+std::vector<std::vector<std::size_t>> ControlPointScheduler::Balance(const std::vector<G4int>& nEvts, int nPools){
+    nPools = std::max(1, std::min(nPools, static_cast<int>(nEvts.size())));
+    std::vector<std::size_t> order(nEvts.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b){ return nEvts[a] > nEvts[b]; });
+
+    std::vector<std::vector<std::size_t>> pools(nPools);
+    std::vector<G4long> load(nPools, 0);
+    for(auto idx : order){
+        auto pool = std::distance(load.begin(), std::min_element(load.begin(), load.end()));
+        pools[pool].emplace_back(idx);
+        load[pool] += nEvts[idx];
+    }
+    for(auto& pool : pools)
+        std::sort(pool.begin(), pool.end());
+    return pools;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+int ControlPointScheduler::Fork(const std::vector<ControlPoint>& controlPoints){
+    std::vector<G4int> nEvts;
+    for(const auto& cp : controlPoints)
+        nEvts.emplace_back(cp.GetNEvts());
+    m_pools = Balance(nEvts, m_nPools);
+    for(std::size_t pool = 0; pool < m_pools.size(); ++pool){
+        G4long poolEvts = 0;
+        for(auto idx : m_pools[pool])
+            poolEvts += nEvts[idx];
+        LOGSVC_INFO("ControlPointScheduler:: pool {}: #{} control points, {} events", pool, m_pools[pool].size(), poolEvts);
+    }
+
+    std::cout.flush();
+    std::cerr.flush();
+    for(std::size_t pool = 1; pool < m_pools.size(); ++pool){
+        auto pid = fork();
+        if(pid < 0){
+            G4String msg = "Couldn't fork the control points pool process";
+            LOGSVC_CRITICAL(msg.data());
+            G4Exception("ControlPointScheduler", "Fork", FatalException, msg);
+        }
+        if(pid == 0){ // child process
+            m_children.clear();
+            return static_cast<int>(pool);
+        }
+        m_children.emplace_back(pid);
+    }
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+void ControlPointScheduler::Wait(){
+    G4int nFailed = 0;
+    for(auto pid : m_children){
+        int status = 0;
+        if(waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0){
+            LOGSVC_ERROR("ControlPointScheduler:: the pool process {} has failed (status {})", pid, status);
+            ++nFailed;
+        }
+    }
+    m_children.clear();
+    if(nFailed > 0){
+        G4String msg = std::to_string(nFailed)+" of the control points pool processes failed";
+        LOGSVC_CRITICAL(msg.data());
+        G4Exception("ControlPointScheduler", "Wait", FatalException, msg);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// Note: the static destructors are not executed, they belong to the parent process state
+void ControlPointScheduler::Exit(){
+    G4cout << G4endl;
+    std::cout.flush();
+    LogSvc::ShutDown();
+    _exit(EXIT_SUCCESS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+void ControlPointScheduler::SeedControlPoint(const ControlPoint& cp){
+    auto userSeed = Service<ConfigSvc>()->GetValue<long>("RunSvc", "RNGSeed");
+    std::seed_seq seq{static_cast<std::uint32_t>(userSeed), static_cast<std::uint32_t>(cp.GetId())};
+    std::uint32_t derived[2];
+    seq.generate(derived, derived + 2);
+    long seeds[2] = {static_cast<long>(derived[0] & 0x7fffffff) | 1, static_cast<long>(derived[1] & 0x7fffffff) | 1};
+    G4Random::setTheSeeds(seeds);
+    LOGSVC_DEBUG("ControlPointScheduler:: CP-{} RNG seeds: {} {}", cp.GetId(), seeds[0], seeds[1]);
+}
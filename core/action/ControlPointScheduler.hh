@@ -0,0 +1,49 @@
+#ifndef Dose3D_ControlPointScheduler_H
+#define Dose3D_ControlPointScheduler_H
+
+#include "globals.hh"
+#include <vector>
+#include <sys/types.h>
+
+class ControlPoint;
+
+////////////////////////////////////////////////////////////////////////////////
+///\brief Distribution of the control points over independent processes (RunSvc::ControlPointProcesses).
+/// Geant4 allows single run manager per process, hence each pool of control points is run by its own
+/// process (with its own G4 kernel, MLC configuration and NumberOfThreads workers). The processes are
+/// forked before the G4 kernel initialization, the calling process runs the pool 0 and waits for the others.
+/// Each control point writes its own output files, merged into the pool output (RunSvc::MergeControlPointOutput),
+/// the pools outputs are merged together in RunSvc::MergeOutput.
+class ControlPointScheduler {
+  public:
+    ///
+    ControlPointScheduler(int nPools);
+
+    /// Longest processing time first partition of the control points by their NEvts,
+    /// returns the control point indexes of each pool (in the plan order)
+    static std::vector<std::vector<std::size_t>> Balance(const std::vector<G4int>& nEvts, int nPools);
+
+    /// Fork the processes of the pools 1..N-1, returns the pool of the calling process
+    int Fork(const std::vector<ControlPoint>& controlPoints);
+
+    /// The control points indexes of the given pool
+    const std::vector<std::size_t>& GetPool(int pool) const { return m_pools.at(pool); }
+
+    /// To be called by the parent (pool 0) process, G4Exception if any of the pools has failed
+    void Wait();
+
+    /// To be called by the forked process once its pool is done
+    [[noreturn]] static void Exit();
+
+    /// Re-seed the RNG with the seeds derived from the RNGSeed and the control point ID.
+    /// Together with the phsp chunks rewound before each run of the pool (IaeaPrimaryGenerator::SetUpChunks)
+    /// the control point results don't depend on the pool it has been assigned to
+    static void SeedControlPoint(const ControlPoint& cp);
+
+  private:
+    int m_nPools = 1;
+    std::vector<std::vector<std::size_t>> m_pools;
+    std::vector<pid_t> m_children;
+};
+
+#endif //Dose3D_ControlPointScheduler_H
@@ -10,16 +10,23 @@
 #include "Services.hh"
 #include "G4SDManager.hh"
 #include "G4UImanager.hh"
+#include "VoxelHitTracks.hh"
 
 /////////////////////////////////////////////////////////////////////////////
 ///
 EventAction::EventAction()
-    : printProgress(Service<ConfigSvc>()->GetValue<double>("RunSvc", "PrintProgressFrequency")) {}
+    : printProgress(Service<ConfigSvc>()->GetValue<double>("RunSvc", "PrintProgressFrequency")),
+      m_beamAnalysis(Service<ConfigSvc>()->GetHandle<bool>("RunSvc", "BeamAnalysis")),
+      m_primariesAnalysis(Service<ConfigSvc>()->GetHandle<bool>("RunSvc", "PrimariesAnalysis")),
+      m_stepAnalysis(Service<ConfigSvc>()->GetHandle<bool>("RunSvc", "StepAnalysis")),
+      m_ntupleAnalysis(Service<ConfigSvc>()->GetHandle<bool>("RunSvc", "NTupleAnalysis")),
+      m_runAnalysis(Service<ConfigSvc>()->GetHandle<bool>("RunSvc", "RunAnalysis")) {}
 
 /////////////////////////////////////////////////////////////////////////////
 ///
 void EventAction::BeginOfEventAction(const G4Event *) {
   totalNoOfEvents = Service<RunSvc>()->CurrentControlPoint()->GetNEvts();
+  VoxelHitTracks::Instance()->Reset(); // the previous event hits are gone
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -70,20 +77,18 @@ void EventAction::EndOfEventAction(const G4Event *evt) {
     oss << G4endl;
     G4cout << oss.str() << std::flush;
   }
-  auto configSvc = Service<ConfigSvc>();
-
-  if (configSvc->GetValue<bool>("RunSvc", "BeamAnalysis"))
+  if (*m_beamAnalysis)
     BeamAnalysis::GetInstance()->EndOfEventAction(evt);
 
-  if (configSvc->GetValue<bool>("RunSvc", "PrimariesAnalysis"))
+  if (*m_primariesAnalysis)
     PrimariesAnalysis::GetInstance()->EndOfEventAction(evt);
 
-  if (configSvc->GetValue<bool>("RunSvc", "StepAnalysis"))
+  if (*m_stepAnalysis)
     StepAnalysis::GetInstance()->EndOfEventAction(evt);
   
-  if (configSvc->GetValue<bool>("RunSvc", "NTupleAnalysis") && NTupleEventAnalisys::IsAnyTTreeDefined() ) //  
+  if (*m_ntupleAnalysis && NTupleEventAnalisys::IsAnyTTreeDefined() ) //  
     NTupleEventAnalisys::GetInstance()->EndOfEventAction(evt);
 
-  if (configSvc->GetValue<bool>("RunSvc", "RunAnalysis"))
+  if (*m_runAnalysis)
     RunAnalysis::GetInstance()->EndOfEventAction(evt);
 }
@@ -12,6 +12,7 @@
 #include "G4UserEventAction.hh"
 #include "RunSvc.hh"
 #include "globals.hh"
+#include "ConfigHandle.hh"
 
 ///\class EventAction
 class EventAction : public G4UserEventAction {
@@ -28,6 +29,13 @@ class EventAction : public G4UserEventAction {
   private:
   const G4double printProgress;
   G4int totalNoOfEvents;
+
+  /// RunSvc analysis switches, bound once (read per event)
+  ConfigHandle<bool> m_beamAnalysis;
+  ConfigHandle<bool> m_primariesAnalysis;
+  ConfigHandle<bool> m_stepAnalysis;
+  ConfigHandle<bool> m_ntupleAnalysis;
+  ConfigHandle<bool> m_runAnalysis;
 };
 
 #endif // Dose3D_EVENTACTION_HH
@@ -8,9 +8,13 @@
 #include "PrimaryParticleInfo.hh"
 #include "G4EventManager.hh"
 #include "BeamCollimation.hh"
+#include "G4Threading.hh"
+#include <chrono>
 
 
 namespace {
+  // Guards the generators construction/destruction only,
+  // the generation itself is performed on the thread-local state
   G4Mutex PrimGenMutex = G4MUTEX_INITIALIZER;
 }
 
@@ -18,7 +22,8 @@ G4RotationMatrix* PrimaryGenerationAction::m_rotation_matrix=nullptr;
 
 ////////////////////////////////////////////////////////////////////////////////
 ///
-PrimaryGenerationAction::PrimaryGenerationAction(){
+PrimaryGenerationAction::PrimaryGenerationAction()
+  : m_primariesAnalysis(Service<ConfigSvc>()->GetHandle<bool>("RunSvc", "PrimariesAnalysis")) {
   SetPrimaryGenerator();
   ConfigurePrimaryGenerator();
 }
@@ -85,6 +90,10 @@ void PrimaryGenerationAction::ConfigurePrimaryGenerator() {
 ////////////////////////////////////////////////////////////////////////////////
 ///
 PrimaryGenerationAction::~PrimaryGenerationAction(void) {
+  if(m_generated_events > 0){
+    LOGSVC_INFO("PrimaryGenerationAction:: thread #{}: {} events generated in {:.3f} [s] ({:.1f} evt/s)",
+      G4Threading::G4GetThreadId(), m_generated_events, m_generation_time, m_generated_events/m_generation_time);
+  }
   G4AutoLock lock(&PrimGenMutex);
   if (m_primaryGenerator) {
     delete m_primaryGenerator;
@@ -95,9 +104,7 @@ PrimaryGenerationAction::~PrimaryGenerationAction(void) {
 ////////////////////////////////////////////////////////////////////////////////
 ///
 void PrimaryGenerationAction::GeneratePrimaries(G4Event *anEvent) {
-  auto runSvc = Service<RunSvc>();
-  G4AutoLock lock(&PrimGenMutex);
-  auto evtID = anEvent->GetEventID();
+  auto start = std::chrono::steady_clock::now();
   std::vector<G4PrimaryVertex*> primary_vrtx; 
   if( dynamic_cast<IaeaPrimaryGenerator*>(m_primaryGenerator) ){
     auto p_gen = dynamic_cast<IaeaPrimaryGenerator*>(m_primaryGenerator);
@@ -105,7 +112,7 @@ void PrimaryGenerationAction::GeneratePrimaries(G4Event *anEvent) {
     while(primary_vrtx.empty() || primary_vrtx.size() < m_min_p_vrtx_vec_size ){
         ++n_reader_calls;
         auto read_p_vrtx = p_gen->GeneratePrimaryVertexVector(anEvent);
-        BeamCollimation::FilterPrimaries(read_p_vrtx);
+        BeamCollimation::FilterPrimaries(read_p_vrtx, p_gen->IsPreFiltered());
         primary_vrtx.insert(primary_vrtx.end(),read_p_vrtx.begin(),read_p_vrtx.end());
         auto nVrtx = primary_vrtx.size();
         if(nVrtx < m_min_p_vrtx_vec_size && n_reader_calls > 99){ // in order to avoid infinit loop
@@ -154,6 +161,9 @@ void PrimaryGenerationAction::GeneratePrimaries(G4Event *anEvent) {
   }
 
   // FILL PRIMARY ANALYSIS
-  if (nVrtx>0 && Service<ConfigSvc>()->GetValue<bool>("RunSvc", "PrimariesAnalysis") )
+  if (nVrtx>0 && *m_primariesAnalysis )
     PrimariesAnalysis::GetInstance()->FillPrimaries(anEvent);
+
+  ++m_generated_events;
+  m_generation_time += std::chrono::duration<G4double>(std::chrono::steady_clock::now() - start).count();
 }
@@ -13,6 +13,7 @@
 #include "G4VUserPrimaryGeneratorAction.hh"
 #include "G4String.hh"
 #include "G4RotationMatrix.hh"
+#include "ConfigHandle.hh"
 
 class G4Event;
 class G4PrimaryVertex;
@@ -58,6 +59,13 @@ class PrimaryGenerationAction : public G4VUserPrimaryGeneratorAction {
 
     ///
     int m_min_p_vrtx_vec_size = 1;
+
+    ///
+    ConfigHandle<bool> m_primariesAnalysis;
+
+    /// Per-thread generation statistics (reported at the end of the worker life)
+    G4long m_generated_events = 0;
+    G4double m_generation_time = 0.; // [s]
 };
 
 #endif // PRIMARYGENERATIONACTION_H
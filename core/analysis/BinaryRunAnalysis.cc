@@ -0,0 +1,115 @@
+#include "BinaryRunAnalysis.hh"
+#include "Services.hh"
+#include "RunOutputWriter.hh"
+#include "DoseFile.hh"
+#include "G4SystemOfUnits.hh"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <set>
+
+namespace {
+    /// The smallest spacing of the sorted values, 0 for a single value
+    double Pitch(const std::set<double>& values){
+        double pitch = 0.;
+        for(auto it = values.begin(); it != values.end() && std::next(it) != values.end(); ++it){
+            auto spacing = *std::next(it) - *it;
+            if(pitch == 0. || spacing < pitch)
+                pitch = spacing;
+        }
+        return pitch;
+    }
+
+    /// The centres are rounded to 1 nm to merge the same planes
+    double Rounded(double value){
+        return std::round(value * 1.e6) / 1.e6;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+BinaryRunAnalysis *BinaryRunAnalysis::GetInstance() {
+    static BinaryRunAnalysis instance = BinaryRunAnalysis();
+    return &instance;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+void BinaryRunAnalysis::WriteDoseToBinary(const RunOutputSnapshot& snapshot){
+    const auto& scoring_maps = snapshot.m_scoring_maps;
+    LOGSVC_INFO("BinaryRunAnalysis::WriteDoseToBinary #{} collections:",scoring_maps.size());
+    for(auto& scoring_map: scoring_maps){
+        for(auto& scoring: scoring_map.second){
+            auto scoring_type = scoring.first;
+            auto& data = scoring.second;
+            auto voxelised = scoring_type==Scoring::Type::Voxel;
+            auto type_str = Scoring::to_string(scoring_type);
+            auto file = snapshot.m_output_file_name+"_"+svc::tolower(scoring_map.first)+"_"+svc::tolower(type_str)+".dose";
+
+            auto n = data.size();
+            std::vector<std::int32_t> cell_id[3], voxel_id[3];
+            std::vector<double> centre[3];
+            std::vector<double> dose, dose_uncertainty, infield, edep_mean, edep_var;
+            std::vector<std::int64_t> steps;
+            for(int axis = 0; axis < 3; ++axis){
+                cell_id[axis].reserve(n);
+                centre[axis].reserve(n);
+                if(voxelised)
+                    voxel_id[axis].reserve(n);
+            }
+            for(auto* column : {&dose, &dose_uncertainty, &infield, &edep_mean, &edep_var})
+                column->reserve(n);
+            steps.reserve(n);
+
+            DoseFile::Header header;
+            std::set<double> planes[3];
+            for(auto& hit : data){
+                auto volume_centre = hit.GetCentre();
+                for(int axis = 0; axis < 3; ++axis){
+                    cell_id[axis].emplace_back(hit.GetGlobalID(axis));
+                    header.m_cell_shape[axis] = std::max(header.m_cell_shape[axis], hit.GetGlobalID(axis) + 1);
+                    if(voxelised){
+                        voxel_id[axis].emplace_back(hit.GetID(axis));
+                        header.m_voxel_shape[axis] = std::max(header.m_voxel_shape[axis], hit.GetID(axis) + 1);
+                    }
+                    centre[axis].emplace_back(volume_centre[axis]);
+                    planes[axis].insert(Rounded(volume_centre[axis]));
+                }
+                const auto& stepsEdep = hit.GetStepsEnergyDeposit();
+                dose.emplace_back(hit.GetDose());
+                dose_uncertainty.emplace_back(hit.GetDoseRelativeUncertainty(snapshot.m_n_histories));
+                infield.emplace_back(hit.GetFieldScalingFactor());
+                steps.emplace_back(stepsEdep.GetCount());
+                edep_mean.emplace_back(stepsEdep.GetMean()/keV);
+                edep_var.emplace_back(stepsEdep.GetVariance()/(keV*keV));
+            }
+
+            header.m_n_histories = snapshot.m_n_histories;
+            header.m_cp_id = snapshot.m_cp_id;
+            header.m_voxelised = voxelised ? 1 : 0;
+            header.m_rotation = snapshot.m_rotation;
+            for(int axis = 0; axis < 3; ++axis){
+                header.m_pitch[axis] = Pitch(planes[axis]);
+                header.m_origin[axis] = planes[axis].empty() ? 0. : *planes[axis].begin();
+            }
+            std::strncpy(header.m_collection, scoring_map.first.c_str(), sizeof(header.m_collection) - 1);
+            std::strncpy(header.m_scoring_type, type_str.c_str(), sizeof(header.m_scoring_type) - 1);
+
+            // The columns and labels of the CsvRunAnalysis::WriteDoseToCsv layout
+            using Column = DoseFile::ColumnData;
+            std::vector<Column> columns = {Column::Of("Cell IdX",cell_id[0]), Column::Of("Cell IdY",cell_id[1]), Column::Of("Cell IdZ",cell_id[2])};
+            if(voxelised){
+                for(const auto& column : {Column::Of("Voxel IdX",voxel_id[0]), Column::Of("Voxel IdY",voxel_id[1]), Column::Of("Voxel IdZ",voxel_id[2])})
+                    columns.emplace_back(column);
+            }
+            for(const auto& column : {Column::Of("X [mm]",centre[0]), Column::Of("Y [mm]",centre[1]), Column::Of("Z [mm]",centre[2]),
+                                      Column::Of("Dose",dose), Column::Of("FieldScalingFactor",infield), Column::Of("Steps",steps),
+                                      Column::Of("Step EDep Mean [keV]",edep_mean), Column::Of("Step EDep Variance [keV2]",edep_var),
+                                      Column::Of("Dose Rel. Uncertainty",dose_uncertainty)})
+                columns.emplace_back(column);
+
+            DoseFile::Write(file, header, columns);
+            LOGSVC_INFO("Output file closed: {}",file);
+        }
+    }
+}
@@ -0,0 +1,33 @@
+#ifndef BINARY_RUN_ANALYSIS_HH
+#define BINARY_RUN_ANALYSIS_HH
+
+#include "globals.hh"
+
+struct RunOutputSnapshot;
+
+////////////////////////////////////////////////////////////////////////////////
+///\brief The run scoring written to the binary columnar dose files (see DoseFile),
+/// a file per run collection and scoring type, with the columns of the CSV layout.
+class BinaryRunAnalysis {
+    private:
+        ///
+        BinaryRunAnalysis() = default;
+
+        ///
+        ~BinaryRunAnalysis() = default;
+
+        /// Delete the copy and move constructors
+        BinaryRunAnalysis(const BinaryRunAnalysis &) = delete;
+        BinaryRunAnalysis &operator=(const BinaryRunAnalysis &) = delete;
+        BinaryRunAnalysis(BinaryRunAnalysis &&) = delete;
+        BinaryRunAnalysis &operator=(BinaryRunAnalysis &&) = delete;
+
+    public:
+        ///
+        static BinaryRunAnalysis* GetInstance();
+
+        ///
+        void WriteDoseToBinary(const RunOutputSnapshot& snapshot);
+};
+
+#endif //BINARY_RUN_ANALYSIS_HH
@@ -1,6 +1,7 @@
 #include "CsvRunAnalysis.hh"
 #include "Services.hh"
 #include "ControlPoint.hh"
+#include "RunOutputWriter.hh"
 #include <pybind11/embed.h>
 #include <pybind11/stl.h>
 
@@ -17,8 +18,9 @@ CsvRunAnalysis *CsvRunAnalysis::GetInstance() {
 
 ////////////////////////////////////////////////////////////////////////////////
 ///
-void CsvRunAnalysis::WriteDoseToCsv(const G4Run* runPtr){
-    auto writeVolumeHitDataRaw = [](std::ofstream& file, const VoxelHit& hit, bool voxelised){
+void CsvRunAnalysis::WriteDoseToCsv(const RunOutputSnapshot& snapshot){
+    auto nHistories = snapshot.m_n_histories;
+    auto writeVolumeHitDataRaw = [nHistories](std::ofstream& file, const VoxelHit& hit, bool voxelised){
         auto cxId = hit.GetGlobalID(0);
         auto cyId = hit.GetGlobalID(1);
         auto czId = hit.GetGlobalID(2);
@@ -27,16 +29,19 @@ void CsvRunAnalysis::WriteDoseToCsv(const G4Run* runPtr){
         auto vzId = hit.GetID(2);
         auto volume_centre = hit.GetCentre();
         auto dose = hit.GetDose();
+        auto doseUncertainty = hit.GetDoseRelativeUncertainty(nHistories);
         auto inField = hit.GetFieldScalingFactor();
+        const auto& stepsEdep = hit.GetStepsEnergyDeposit();
         file <<cxId<<","<<cyId<<","<<czId;
         if(voxelised)
             file <<","<<vxId<<","<<vyId<<","<<vzId;
         file <<","<<volume_centre.getX()<<","<<volume_centre.getY()<<","<<volume_centre.getZ();
-        file <<","<<dose<<","<< inField << std::endl;
+        file <<","<<dose<<","<< inField;
+        file <<","<<stepsEdep.GetCount()<<","<<stepsEdep.GetMean()/keV<<","<<stepsEdep.GetVariance()/(keV*keV);
+        file <<","<<doseUncertainty << '\n';
     };
 
-    auto cp = Service<RunSvc>()->CurrentControlPoint();
-    const auto& scoring_maps = cp->GetRun()->GetScoringCollections();
+    const auto& scoring_maps = snapshot.m_scoring_maps;
     LOGSVC_INFO("CsvRunAnalysis::WriteDoseToCsv #{} collections:",scoring_maps.size());
 
     for(auto& scoring_map: scoring_maps){
@@ -46,17 +51,19 @@ void CsvRunAnalysis::WriteDoseToCsv(const G4Run* runPtr){
             auto& data = scoring.second;
             auto type_str = svc::tolower(Scoring::to_string(scoring_type));
             auto coll_str = svc::tolower(scoring_map.first);
-            auto file = cp->GetOutputFileName()+"_"+coll_str+"_"+type_str+".csv";
+            auto file = snapshot.m_output_file_name+"_"+coll_str+"_"+type_str+".csv";
             std::string header = "Cell IdX,Cell IdY,Cell IdZ,X [mm],Y [mm],Z [mm],Dose,FieldScalingFactor";
 
             if(scoring_type==Scoring::Type::Voxel)
                 header = "Cell IdX,Cell IdY,Cell IdZ,Voxel IdX,Voxel IdY,Voxel IdZ,X [mm],Y [mm],Z [mm],Dose,FieldScalingFactor";
+            header += ",Steps,Step EDep Mean [keV],Step EDep Variance [keV2]";
+            header += ",Dose Rel. Uncertainty"; // appended, the columns above keep their positions (see scripts/data_reader.py)
 
             std::ofstream c_outFile;
             c_outFile.open(file.c_str(), std::ios::out);
-            c_outFile << header << std::endl;
-            for(auto& scoring : data){
-                writeVolumeHitDataRaw(c_outFile, scoring.second, scoring_type==Scoring::Type::Voxel);
+            c_outFile << header << '\n';
+            for(auto& hit : data){
+                writeVolumeHitDataRaw(c_outFile, hit, scoring_type==Scoring::Type::Voxel);
             }
             c_outFile.close();
             LOGSVC_INFO("Output file closed: {}",file);
@@ -67,22 +74,22 @@ void CsvRunAnalysis::WriteDoseToCsv(const G4Run* runPtr){
 
 ////////////////////////////////////////////////////////////////////////////////
 ///
-void CsvRunAnalysis::WriteFieldMaskToCsv(const G4Run* runPtr){
-    auto cp = Service<RunSvc>()->CurrentControlPoint();
-    auto data_types = cp->DataTypes();
-    for(const auto& type : data_types){
+void CsvRunAnalysis::WriteFieldMaskToCsv(const RunOutputSnapshot& snapshot){
+    for(const auto& mask : snapshot.m_field_masks){
+        const auto& type = mask.first;
+        const auto& field_mask = mask.second;
         LOGSVC_INFO("Writing field mask (type={}) to CSV...",type);
-        const auto& field_mask = cp->GetFieldMask(type);
         if(field_mask.size()>0){
-            auto file = cp->GetOutputFileName()+"_field_mask_"+svc::tolower(type)+".csv";
+            auto file = snapshot.m_output_file_name+"_field_mask_"+svc::tolower(type)+".csv";
             std::string header = "X [mm],Y [mm],Z [mm]";
             std::ofstream c_outFile;
             c_outFile.open(file.c_str(), std::ios::out);
-            c_outFile << header << std::endl;
+            c_outFile << header << '\n';
             for(auto& mp : field_mask)
-                c_outFile << mp.getX() << "," << mp.getY() << "," << mp.getZ() << std::endl;
+                c_outFile << mp.getX() << "," << mp.getY() << "," << mp.getZ() << '\n';
             c_outFile.close();
             LOGSVC_INFO("Writing Field Mask to file {} - done!",file);
+            py::gil_scoped_acquire gil; // called from the RunOutputWriter thread
             auto writePngCopy = py::module::import("field_mask_png");
             writePngCopy.attr("save_mask_as_png")(file);
         }
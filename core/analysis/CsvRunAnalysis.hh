@@ -7,7 +7,7 @@
 
 #include "globals.hh"
 
-class G4Run;
+struct RunOutputSnapshot;
 
 class CsvRunAnalysis {
     private:
@@ -28,8 +28,8 @@ class CsvRunAnalysis {
         static CsvRunAnalysis* GetInstance();
 
         ///
-        void WriteDoseToCsv(const G4Run* runPtr);
-        void WriteFieldMaskToCsv(const G4Run* runPtr);
+        void WriteDoseToCsv(const RunOutputSnapshot& snapshot);
+        void WriteFieldMaskToCsv(const RunOutputSnapshot& snapshot);
 };
 
 #endif //CSV_RUN_ANALYSIS_HH
\ No newline at end of file
@@ -0,0 +1,189 @@
+#include "DoseConvergenceMonitor.hh"
+#include "ControlPoint.hh"
+#include "Services.hh"
+#include "G4Threading.hh"
+#include <algorithm>
+
+////////////////////////////////////////////////////////////////////////////////
+///
+DoseConvergenceMonitor *DoseConvergenceMonitor::GetInstance() {
+    static DoseConvergenceMonitor instance;
+    return &instance;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+DoseConvergenceMonitor::~DoseConvergenceMonitor(){
+    Stop();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+void DoseConvergenceMonitor::Reset(G4int cpId){
+    Stop();
+    auto configSvc = Service<ConfigSvc>();
+    m_target_uncertainty = configSvc->GetValue<double>("RunSvc", "TargetDoseUncertainty");
+    m_dose_threshold = configSvc->GetValue<double>("RunSvc", "TargetDoseThreshold");
+    m_check_interval = std::max(1, configSvc->GetValue<int>("RunSvc", "ConvergenceCheckInterval"));
+    m_cp_id = cpId;
+    for(auto& snapshot : m_snapshots){
+        snapshot.second->m_registered = false;
+        snapshot.second->m_histories = 0;
+    }
+    m_groups.clear();
+    m_uncertainty = 1.;
+    m_converged_histories = 0;
+    m_converged.store(false);
+    if(!IsEnabled())
+        return;
+    LOGSVC_INFO("DoseConvergenceMonitor:: CP-{} target uncertainty {:.2f}% (dose > {:.0f}% of max), checked every {} events",
+                m_cp_id, 100. * m_target_uncertainty, 100. * m_dose_threshold, m_check_interval);
+    m_stop = false;
+    m_pending = false;
+    m_thread = std::thread(&DoseConvergenceMonitor::Process, this);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+void DoseConvergenceMonitor::Finish(){
+    Stop();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+void DoseConvergenceMonitor::Stop(){
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_submitted.notify_all();
+    if(m_thread.joinable())
+        m_thread.join();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+void DoseConvergenceMonitor::Submit(const ControlPointRun* run, G4long nHistories){
+    if(IsConverged())
+        return;
+    // The layout is checked (and the slot is created) once per run and thread only
+    auto threadId = G4Threading::G4GetThreadId();
+    Snapshot* snapshot = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto& slot = m_snapshots[threadId];
+        if(!slot)
+            slot = std::make_unique<Snapshot>();
+        snapshot = slot.get();
+        if(!snapshot->m_registered){ // the first submission of this run
+            std::vector<std::size_t> groups(1,0);
+            for(const auto& scoring_map : run->GetScoringCollections())
+                for(const auto& scoring : scoring_map.second)
+                    groups.emplace_back(groups.back() + scoring.second.size());
+            if(m_groups.empty())
+                m_groups = groups;
+            else if(m_groups != groups){
+                LOGSVC_WARN("DoseConvergenceMonitor:: inconsistent scoring layout of thread {}, skipped",threadId);
+                return;
+            }
+            snapshot->m_registered = true;
+        }
+    }
+
+    // Thread's own run scoring into thread's own slot, the evaluation may only wait for it
+    {
+        std::lock_guard<std::mutex> lock(snapshot->m_mutex);
+        snapshot->m_histories = nHistories;
+        snapshot->m_dose.resize(m_groups.back());
+        snapshot->m_dose2.resize(m_groups.back());
+        std::size_t i = 0;
+        for(const auto& scoring_map : run->GetScoringCollections()){
+            for(const auto& scoring : scoring_map.second){
+                for(const auto& hit : scoring.second){
+                    snapshot->m_dose[i] = hit.GetDose();
+                    snapshot->m_dose2[i] = hit.GetDose2();
+                    ++i;
+                }
+            }
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending = true;
+    }
+    m_submitted.notify_one();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+void DoseConvergenceMonitor::Process(){
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while(true){
+        m_submitted.wait(lock, [&]{ return m_stop || m_pending; });
+        if(m_stop)
+            return;
+        m_pending = false;
+        lock.unlock();
+        Evaluate();
+        lock.lock();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+void DoseConvergenceMonitor::Evaluate(){
+    std::vector<std::size_t> groups;
+    std::vector<Snapshot*> snapshots;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        groups = m_groups;
+        for(auto& snapshot : m_snapshots)
+            snapshots.emplace_back(snapshot.second.get());
+    }
+    if(groups.size() < 2)
+        return;
+
+    G4long nHistories = 0;
+    auto size = groups.back();
+    std::vector<G4double> dose(size,0.), dose2(size,0.);
+    for(auto snapshot : snapshots){
+        std::lock_guard<std::mutex> lock(snapshot->m_mutex);
+        if(snapshot->m_histories == 0 || snapshot->m_dose.size() != size)
+            continue;
+        nHistories += snapshot->m_histories;
+        for(std::size_t i = 0; i < size; ++i){
+            dose[i] += snapshot->m_dose[i];
+            dose2[i] += snapshot->m_dose2[i];
+        }
+    }
+    if(nHistories < 2)
+        return;
+
+    G4double worst = 0.;
+    G4int nEvaluated = 0;
+    for(std::size_t g = 0; g + 1 < groups.size(); ++g){
+        auto begin = dose.begin() + groups[g];
+        auto end = dose.begin() + groups[g + 1];
+        if(begin == end)
+            continue;
+        auto threshold = m_dose_threshold * (*std::max_element(begin, end));
+        if(threshold <= 0.) // no dose in this group (e.g. out of the field), it doesn't block the convergence
+            continue;
+        ++nEvaluated;
+        for(auto i = groups[g]; i < groups[g + 1]; ++i)
+            if(dose[i] >= threshold)
+                worst = std::max(worst, VoxelHit::GetRelativeUncertainty(dose[i], dose2[i], nHistories));
+    }
+    if(nEvaluated == 0) // nothing scored yet
+        return;
+    m_uncertainty = worst;
+    LOGSVC_DEBUG("DoseConvergenceMonitor:: CP-{} #{} histories, max relative uncertainty {:.3f}%",
+                 m_cp_id, nHistories, 100. * worst);
+
+    if(worst <= m_target_uncertainty){
+        m_converged_histories = nHistories;
+        m_converged.store(true);
+        LOGSVC_INFO("DoseConvergenceMonitor:: CP-{} converged after #{} histories ({:.3f}% <= {:.3f}%)",
+                    m_cp_id, nHistories, 100. * worst, 100. * m_target_uncertainty);
+    }
+}
@@ -0,0 +1,112 @@
+#ifndef DOSE_CONVERGENCE_MONITOR_HH
+#define DOSE_CONVERGENCE_MONITOR_HH
+
+#include "globals.hh"
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ControlPointRun;
+
+////////////////////////////////////////////////////////////////////////////////
+///\brief Uncertainty driven early termination of the control point run.
+/// Each worker publishes its run scoring statistics (dose sums and squared history doses)
+/// every RunSvc::ConvergenceCheckInterval events into its own (reused) slot, which is all
+/// it does. The slots are combined by the evaluation thread started by the master (Reset),
+/// hence the workers neither wait for nor pay for the evaluation. The worst relative
+/// uncertainty among the entries above RunSvc::TargetDoseThreshold of the maximum dose
+/// (per scoring collection and type) is compared with RunSvc::TargetDoseUncertainty.
+/// The groups that haven't received any dose (e.g. the out of field detectors) are skipped,
+/// at least one has to be evaluated. Once reached, the workers soft-abort the run.
+/// Note: The combined statistics are exact, the merged ones at the end of run are the same.
+class DoseConvergenceMonitor {
+    private:
+        ///
+        DoseConvergenceMonitor() = default;
+
+        ///
+        ~DoseConvergenceMonitor();
+
+        /// Delete the copy and move constructors
+        DoseConvergenceMonitor(const DoseConvergenceMonitor &) = delete;
+        DoseConvergenceMonitor &operator=(const DoseConvergenceMonitor &) = delete;
+        DoseConvergenceMonitor(DoseConvergenceMonitor &&) = delete;
+        DoseConvergenceMonitor &operator=(DoseConvergenceMonitor &&) = delete;
+
+        /// Dose sums of single thread run scoring (all collections and types flattened)
+        struct Snapshot {
+            std::mutex m_mutex;
+            G4bool m_registered = false; // guarded by DoseConvergenceMonitor::m_mutex
+            G4long m_histories = 0;
+            std::vector<G4double> m_dose;
+            std::vector<G4double> m_dose2;
+        };
+
+        /// Thread ID / the latest snapshot (the slots are kept, hence reused by the next runs)
+        std::map<G4int,std::unique_ptr<Snapshot>> m_snapshots;
+
+        /// Offsets of the scoring collection/type groups within the snapshot (the last one is the size)
+        std::vector<std::size_t> m_groups;
+
+        ///
+        G4double m_target_uncertainty = 0.;
+        G4double m_dose_threshold = 0.5;
+        G4int m_check_interval = 10000;
+
+        ///
+        G4int m_cp_id = -1;
+        G4double m_uncertainty = 1.;
+        G4long m_converged_histories = 0;
+        std::atomic<bool> m_converged{false};
+
+        /// The evaluation thread
+        std::thread m_thread;
+        std::mutex m_mutex;
+        std::condition_variable m_submitted;
+        bool m_pending = false;
+        bool m_stop = false;
+
+        /// The evaluation thread loop
+        void Process();
+
+        /// Stop the evaluation thread (if running)
+        void Stop();
+
+        /// Combine the snapshots and update the convergence state (the evaluation thread)
+        void Evaluate();
+
+    public:
+        ///
+        static DoseConvergenceMonitor* GetInstance();
+
+        /// Read the configuration, drop the previous run state and start the evaluation,
+        /// to be called in the master before BeamOn
+        void Reset(G4int cpId);
+
+        /// Stop the evaluation, to be called in the master after BeamOn
+        void Finish();
+
+        ///
+        G4bool IsEnabled() const { return m_target_uncertainty > 0.; }
+
+        ///
+        G4int GetCheckInterval() const { return m_check_interval; }
+
+        /// Publish the (worker) run scoring statistics of nHistories, the evaluation is done asynchronously
+        void Submit(const ControlPointRun* run, G4long nHistories);
+
+        ///
+        G4bool IsConverged() const { return m_converged.load(std::memory_order_relaxed); }
+
+        /// The number of histories (all threads) at which the target uncertainty has been reached (see Finish)
+        G4long GetConvergedHistories() const { return m_converged_histories; }
+
+        /// The worst relative uncertainty at the last evaluation (see Finish)
+        G4double GetUncertainty() const { return m_uncertainty; }
+};
+
+#endif //DOSE_CONVERGENCE_MONITOR_HH
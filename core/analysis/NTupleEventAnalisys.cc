@@ -86,10 +86,10 @@ void NTupleEventAnalisys::BeginOfRun(const G4Run* runPtr, G4bool isMaster){
     return;
   // Book Voxel data Ntuple for all HitsColletions
   //------------------------------------------
-  m_runId = runPtr->GetRunID();
+  m_runId.Put(runPtr->GetRunID());
   auto runSvc = Service<RunSvc>();
   auto control_point = runSvc->CurrentControlPoint();
-  m_degree_rotation = control_point->GetDegreeRotation();
+  m_degree_rotation.Put(control_point->GetDegreeRotation());
   for(const auto& tree : NTupleEventAnalisys::m_ttree_collection){
     if(GetNTupleId(tree.m_name+m_treeNamePostfix) == -1){ // not created yet
       CreateNTuple(tree);
@@ -113,68 +113,100 @@ void NTupleEventAnalisys::CreateNTuple(const TTreeCollection& treeColl){
   evtNTupleColl.m_minimalistic_ttree = treeColl.m_minimalistic;
   evtNTupleColl.m_voxel_tree_structure = treeColl.m_voxel_tree_structure;
 
+  auto layout = Service<ConfigSvc>()->GetValue<std::string>("RunSvc", "NTupleLayout");
+  if(layout != "hit" && layout != "event"){
+    G4String msg = "Unknown RunSvc::NTupleLayout ("+layout+"), the hit or event are available";
+    LOGSVC_CRITICAL(msg.data());
+    G4Exception("NTupleEventAnalisys", "CreateNTuple", FatalErrorInArgument, msg);
+  }
+  evtNTupleColl.m_event_rows = layout == "event";
+  auto eventRows = evtNTupleColl.m_event_rows;
+  using Column = TTreeEventCollection::Column;
+
   /* NOTE:
     The G4AnalysisManager CreateNtuple(X)Column creates each column with unique ID,
     being inremented in each method call. Once we want to call FillNtuple(X)Column
     in order to set value explicitly we have to know ID matched to the defined column.
-    Here it's why we create the map of ID to each column...
+    Here it's why we keep the ID of each column, resolved once here (no lookups per fill)...
   */
-  auto createNtupleIColumn = [&](const char* name){
-    evtNTupleColl.m_colId[name] = analysisManager->CreateNtupleIColumn(ntupleId, name); 
+  auto createNtupleIColumn = [&](Column column, const char* name){
+    evtNTupleColl.m_colId[column] = analysisManager->CreateNtupleIColumn(ntupleId, name); 
   };
-  auto createNtupleDColumn = [&](const char* name){
-    evtNTupleColl.m_colId[name] = analysisManager->CreateNtupleDColumn(ntupleId, name); 
+  auto createNtupleDColumn = [&](Column column, const char* name){
+    evtNTupleColl.m_colId[column] = analysisManager->CreateNtupleDColumn(ntupleId, name); 
   };
 
+  // The vector columns are bound to the event collection members (read by the AddNtupleRow)
   auto createNtupleVecIColumn = [&](const char* name,std::vector<G4int>& vec){
-    evtNTupleColl.m_colId[name] = analysisManager->CreateNtupleIColumn(ntupleId, name, vec); 
+    analysisManager->CreateNtupleIColumn(ntupleId, name, vec); 
   };
 
   auto createNtupleVecDColumn = [&](const char* name,std::vector<G4double>& vec){
-    evtNTupleColl.m_colId[name] = analysisManager->CreateNtupleDColumn(ntupleId, name, vec); 
+    analysisManager->CreateNtupleDColumn(ntupleId, name, vec); 
+  };
+
+  // The per hit columns: the scalar ones (a row per hit) or the vectors of the event hits (a row per event)
+  auto createNtupleHitIColumn = [&](Column column, const char* name, std::vector<G4int>& vec){
+    if(eventRows)
+      createNtupleVecIColumn(name,vec);
+    else
+      createNtupleIColumn(column,name);
+  };
+  auto createNtupleHitDColumn = [&](Column column, const char* name, std::vector<G4double>& vec){
+    if(eventRows)
+      createNtupleVecDColumn(name,vec);
+    else
+      createNtupleDColumn(column,name);
   };
   
   // General TTree branches
   if(!treeColl.m_minimalistic){
-    createNtupleIColumn("ThreadId");
-    createNtupleIColumn("G4EvtId");
-    createNtupleIColumn("G4RunId");
-    createNtupleDColumn("G4EvtGlobalTime");
+    createNtupleIColumn(Column::ThreadId,"ThreadId");
+    createNtupleIColumn(Column::G4EvtId,"G4EvtId");
+    createNtupleIColumn(Column::G4RunId,"G4RunId");
+    createNtupleDColumn(Column::G4EvtGlobalTime,"G4EvtGlobalTime");
     createNtupleVecDColumn("G4EvtPrimaryE",evtNTupleColl.m_G4EvtPrimaryEnergy);
-    createNtupleIColumn("G4EvtPrimaryN");
-    createNtupleDColumn("GantryAngle");
+    createNtupleIColumn(Column::G4EvtPrimaryN,"G4EvtPrimaryN");
+    createNtupleDColumn(Column::GantryAngle,"GantryAngle");
+  }
+  else if(eventRows){
+    createNtupleIColumn(Column::G4EvtId,"G4EvtId");
   }
 
   // Dose-3D cell level scoring
   if(evtNTupleColl.m_cell_tree_structure){
-    createNtupleIColumn("CellIdX");
-    createNtupleIColumn("CellIdY");
-    createNtupleIColumn("CellIdZ");
+    createNtupleHitIColumn(Column::CellIdX,"CellIdX",evtNTupleColl.m_CellIdX);
+    createNtupleHitIColumn(Column::CellIdY,"CellIdY",evtNTupleColl.m_CellIdY);
+    createNtupleHitIColumn(Column::CellIdZ,"CellIdZ",evtNTupleColl.m_CellIdZ);
     if(!treeColl.m_minimalistic){
-      createNtupleDColumn("CellPositionX");
-      createNtupleDColumn("CellPositionY");
-      createNtupleDColumn("CellPositionZ");
-      createNtupleDColumn("CellEDeposit");
-      createNtupleDColumn("CellMeanEDeposit");
+      createNtupleHitDColumn(Column::CellPositionX,"CellPositionX",evtNTupleColl.m_CellPositionX);
+      createNtupleHitDColumn(Column::CellPositionY,"CellPositionY",evtNTupleColl.m_CellPositionY);
+      createNtupleHitDColumn(Column::CellPositionZ,"CellPositionZ",evtNTupleColl.m_CellPositionZ);
+      createNtupleHitDColumn(Column::CellEDeposit,"CellEDeposit",evtNTupleColl.m_VoxelHitEDeposit);
+      createNtupleHitDColumn(Column::CellMeanEDeposit,"CellMeanEDeposit",evtNTupleColl.m_VoxelHitMeanEDeposit);
+      createNtupleHitDColumn(Column::CellVarEDeposit,"CellVarEDeposit",evtNTupleColl.m_VoxelHitVarEDeposit);
     }
-    createNtupleDColumn("CellDose");
+    createNtupleHitDColumn(Column::CellDose,"CellDose",evtNTupleColl.m_CellIDose);
   }
 
   // Any voxel-like scoring (+ Dose-3D scope)
   if(evtNTupleColl.m_voxel_tree_structure){
-    createNtupleIColumn("VoxelIdX");
-    createNtupleIColumn("VoxelIdY");
-    createNtupleIColumn("VoxelIdZ");
+    createNtupleHitIColumn(Column::VoxelIdX,"VoxelIdX",evtNTupleColl.m_VoxelIdX);
+    createNtupleHitIColumn(Column::VoxelIdY,"VoxelIdY",evtNTupleColl.m_VoxelIdY);
+    createNtupleHitIColumn(Column::VoxelIdZ,"VoxelIdZ",evtNTupleColl.m_VoxelIdZ);
     if(!treeColl.m_minimalistic){
-      createNtupleDColumn("VoxelPositionX");
-      createNtupleDColumn("VoxelPositionY");
-      createNtupleDColumn("VoxelPositionZ");
-      createNtupleDColumn("VoxelEDeposit");
-      createNtupleDColumn("VoxelMeanEDeposit");
+      createNtupleHitDColumn(Column::VoxelPositionX,"VoxelPositionX",evtNTupleColl.m_VoxelPositionX);
+      createNtupleHitDColumn(Column::VoxelPositionY,"VoxelPositionY",evtNTupleColl.m_VoxelPositionY);
+      createNtupleHitDColumn(Column::VoxelPositionZ,"VoxelPositionZ",evtNTupleColl.m_VoxelPositionZ);
+      createNtupleHitDColumn(Column::VoxelEDeposit,"VoxelEDeposit",evtNTupleColl.m_VoxelHitEDeposit);
+      createNtupleHitDColumn(Column::VoxelMeanEDeposit,"VoxelMeanEDeposit",evtNTupleColl.m_VoxelHitMeanEDeposit);
+      createNtupleHitDColumn(Column::VoxelVarEDeposit,"VoxelVarEDeposit",evtNTupleColl.m_VoxelHitVarEDeposit);
     }
-    createNtupleDColumn("VoxelDose");
+    createNtupleHitDColumn(Column::VoxelDose,"VoxelDose",evtNTupleColl.m_VoxelHitDose);
     
     if(evtNTupleColl.m_tracks_analysis){
+      if(eventRows) // the tracks of all the event hits, flattened
+        createNtupleVecIColumn("VoxelTrkN",evtNTupleColl.m_VoxelTrkN);
       createNtupleVecIColumn("VoxelTrkId",evtNTupleColl.m_VoxelTrkId);
       createNtupleVecIColumn("VoxelTrkTypeId",evtNTupleColl.m_VoxelTrkTypeId);
       createNtupleVecDColumn("VoxelTrkE",evtNTupleColl.m_VoxelTrkEnergy);
@@ -202,7 +234,8 @@ G4int NTupleEventAnalisys::GetNTupleId(const G4String& treeName){
 ////////////////////////////////////////////////////////////////////////////////
 ///
 void NTupleEventAnalisys::FillEventCollection(const G4String& treeName, const G4Event *evt, VoxelHitsCollection* hitsColl){
-  auto isoToSim = Service<ConfigSvc>()->GetValue<G4ThreeVector>("WorldConstruction", "IsoToSimTransformation");
+  static const auto isoToSimHandle = Service<ConfigSvc>()->GetHandle<G4ThreeVector>("WorldConstruction", "IsoToSimTransformation");
+  const auto& isoToSim = isoToSimHandle.Get();
   auto analysisManager = G4AnalysisManager::Instance();
   auto ntplId = GetNTupleId(treeName);
   if (ntplId==-1){
@@ -226,6 +259,7 @@ void NTupleEventAnalisys::FillEventCollection(const G4String& treeName, const G4
     auto hit = dynamic_cast<VoxelHit*>(hitsColl->GetHit(i));
     auto hitEDeposit = hit->GetEnergyDeposit() / keV;
     auto hitMeanEDeposit = hit->GetMeanEnergyDeposit() / keV;
+    auto hitVarEDeposit = hit->GetEnergyDepositVariance() / (keV*keV);
 
     evtColl.m_CellIdX.push_back(hit->GetGlobalID(0));
     evtColl.m_CellIdY.push_back(hit->GetGlobalID(1));
@@ -262,6 +296,7 @@ void NTupleEventAnalisys::FillEventCollection(const G4String& treeName, const G4
     if(!evtColl.m_minimalistic_ttree){
       evtColl.m_VoxelHitEDeposit.emplace_back(hitEDeposit);
       evtColl.m_VoxelHitMeanEDeposit.emplace_back(hitMeanEDeposit);
+      evtColl.m_VoxelHitVarEDeposit.emplace_back(hitVarEDeposit);
     }
     evtColl.m_VoxelHitDose.emplace_back( voxelDose );
 
@@ -274,44 +309,31 @@ void NTupleEventAnalisys::FillEventCollection(const G4String& treeName, const G4
 
 
     if (evtColl.m_tracks_analysis){
-      std::vector<G4int> trkType;
-      std::vector<G4int> trkTypeId;
-      for(const auto& iTrkType : hit->GetTrkType()){
-        trkType.emplace_back(iTrkType.first);
-        trkTypeId.emplace_back(iTrkType.second);
-      }
-      evtColl.m_VoxelHitsTrkId.emplace_back(trkType);
-      evtColl.m_VoxelHitsTrkTypeId.emplace_back(trkTypeId);
-
-      std::vector<G4double> trkEnergy;
-      for(const auto& iTrkE : hit->GetTrkEnergy()){
-        trkEnergy.emplace_back(iTrkE.second / MeV);
-      }
-      evtColl.m_VoxelHitsTrkEnergy.emplace_back(trkEnergy);
-
-      std::vector<G4double> trkTheta;
-      for(const auto& iTrkTheta : hit->GetTrkTheta()){
-        trkTheta.emplace_back(iTrkTheta.second);
-      }
-      evtColl.m_VoxelHitsTrkTheta.emplace_back(trkTheta);
-
-      std::vector<G4double> trkPosX;
-      std::vector<G4double> trkPosY;
-      std::vector<G4double> trkPosZ;
-      for(const auto& iTrkPos : hit->GetTrkPosition()){
-        trkPosX.emplace_back(iTrkPos.second.getX()-isoToSim.x());
-        trkPosY.emplace_back(iTrkPos.second.getY()-isoToSim.y());
-        trkPosZ.emplace_back(iTrkPos.second.getZ()-isoToSim.z());
-      }
-      evtColl.m_VoxelHitsTrkPosX.emplace_back(trkPosX);
-      evtColl.m_VoxelHitsTrkPosY.emplace_back(trkPosY);
-      evtColl.m_VoxelHitsTrkPosZ.emplace_back(trkPosZ);
-
-      std::vector<G4double> trkLength;
-      for(const auto& iTrkLength : hit->GetTrkLength()){
-        trkLength.emplace_back(iTrkLength.second);
-      }
-      evtColl.m_VoxelHitsTrkLength.emplace_back(trkLength);
+      auto nTrk = hit->GetNTrkType();
+      auto& trkId = evtColl.m_VoxelHitsTrkId.emplace_back();
+      auto& trkTypeId = evtColl.m_VoxelHitsTrkTypeId.emplace_back();
+      auto& trkEnergy = evtColl.m_VoxelHitsTrkEnergy.emplace_back();
+      auto& trkTheta = evtColl.m_VoxelHitsTrkTheta.emplace_back();
+      auto& trkPosX = evtColl.m_VoxelHitsTrkPosX.emplace_back();
+      auto& trkPosY = evtColl.m_VoxelHitsTrkPosY.emplace_back();
+      auto& trkPosZ = evtColl.m_VoxelHitsTrkPosZ.emplace_back();
+      auto& trkLength = evtColl.m_VoxelHitsTrkLength.emplace_back();
+      for(auto column : {&trkEnergy,&trkTheta,&trkPosX,&trkPosY,&trkPosZ,&trkLength})
+        column->reserve(nTrk);
+      trkId.reserve(nTrk);
+      trkTypeId.reserve(nTrk);
+      hit->ForEachTrackSpan([&](const VoxelHitTracks::Track* trk, G4int n){
+        for(G4int i = 0; i < n; ++i){
+          trkId.emplace_back(trk[i].m_id);
+          trkTypeId.emplace_back(trk[i].m_type);
+          trkEnergy.emplace_back(trk[i].m_energy / MeV);
+          trkTheta.emplace_back(trk[i].m_theta);
+          trkPosX.emplace_back(trk[i].m_position.getX()-isoToSim.x());
+          trkPosY.emplace_back(trk[i].m_position.getY()-isoToSim.y());
+          trkPosZ.emplace_back(trk[i].m_position.getZ()-isoToSim.z());
+          trkLength.emplace_back(trk[i].m_length);
+        }
+      });
     }
 
   }
@@ -324,6 +346,7 @@ void NTupleEventAnalisys::FillEventCollection(const G4String& treeName, const G4
 ///
 void NTupleEventAnalisys::FillNTupleEvent(){
   auto analysisManager = G4AnalysisManager::Instance();
+  using Column = TTreeEventCollection::Column;
   
   for(auto coll = m_ntuple_collection.Begin(); coll != m_ntuple_collection.End(); ++coll){
     auto minimalistic_ttree = coll->second.m_minimalistic_ttree;
@@ -332,73 +355,96 @@ void NTupleEventAnalisys::FillNTupleEvent(){
       auto& treeEvtColl = coll->second;
       auto ntupleId = treeEvtColl.m_ntupleId;
 
-      auto fillNtupleIColumn = [&](const char* name, G4int val){
+      auto fillNtupleIColumn = [&](Column column, G4int val){
         // TODO: utilize G4 utilities: G4GenericFileManager::GetFileManager->G4RootAnalysisManager...
-        // if(analysisManager->GetNtupleIColumn(ntupleId, treeEvtColl.m_colId[name])) 
-          analysisManager->FillNtupleIColumn(ntupleId,treeEvtColl.m_colId[name], val);
+        // if(analysisManager->GetNtupleIColumn(ntupleId, treeEvtColl.m_colId[column])) 
+          analysisManager->FillNtupleIColumn(ntupleId,treeEvtColl.m_colId[column], val);
       };
 
-      auto fillNtupleDColumn = [&](const char* name, G4double val){
-        analysisManager->FillNtupleDColumn(ntupleId,treeEvtColl.m_colId[name], val);
+      auto fillNtupleDColumn = [&](Column column, G4double val){
+        analysisManager->FillNtupleDColumn(ntupleId,treeEvtColl.m_colId[column], val);
       };
 
-      for (int i=0;i<nHits;++i){ // a.k.a. voxel loop => creates nEvents=nHits in the NTuple
+      auto fillEventColumns = [&](){
         // ThreadId: -1 for the master thread, and -2 if it is used in the sequential mode.
-        // std::string doseMapName;
-        // // doseMapName.clear();
         if(!minimalistic_ttree){
-          fillNtupleIColumn("ThreadId",G4Threading::G4GetThreadId());
-          fillNtupleIColumn("G4EvtId",treeEvtColl.m_evtId);
-          fillNtupleDColumn("G4EvtGlobalTime",treeEvtColl.m_global_time);
-          fillNtupleIColumn("G4EvtPrimaryN",treeEvtColl.m_EvtPrimariesN);
-          fillNtupleIColumn("G4RunId",m_runId);
-          fillNtupleDColumn("GantryAngle",m_degree_rotation);
+          fillNtupleIColumn(Column::ThreadId,G4Threading::G4GetThreadId());
+          fillNtupleIColumn(Column::G4EvtId,treeEvtColl.m_evtId);
+          fillNtupleDColumn(Column::G4EvtGlobalTime,treeEvtColl.m_global_time);
+          fillNtupleIColumn(Column::G4EvtPrimaryN,treeEvtColl.m_EvtPrimariesN);
+          fillNtupleIColumn(Column::G4RunId,m_runId.Get());
+          fillNtupleDColumn(Column::GantryAngle,m_degree_rotation.Get());
+        }
+        else if(treeEvtColl.m_event_rows){
+          fillNtupleIColumn(Column::G4EvtId,treeEvtColl.m_evtId);
+        }
+      };
+
+      if(treeEvtColl.m_event_rows){ // single row, the hits vectors are bound to the columns already
+        fillEventColumns();
+        if(treeEvtColl.m_tracks_analysis){
+          treeEvtColl.m_VoxelTrkN.clear();
+          auto flatten = [](auto& flat, const auto& perHit){
+            flat.clear();
+            for(const auto& hitTracks : perHit)
+              flat.insert(flat.end(), hitTracks.begin(), hitTracks.end());
+          };
+          for(const auto& hitTracks : treeEvtColl.m_VoxelHitsTrkId)
+            treeEvtColl.m_VoxelTrkN.emplace_back(hitTracks.size());
+          flatten(treeEvtColl.m_VoxelTrkId,treeEvtColl.m_VoxelHitsTrkId);
+          flatten(treeEvtColl.m_VoxelTrkTypeId,treeEvtColl.m_VoxelHitsTrkTypeId);
+          flatten(treeEvtColl.m_VoxelTrkEnergy,treeEvtColl.m_VoxelHitsTrkEnergy);
+          flatten(treeEvtColl.m_VoxelTrkTheta,treeEvtColl.m_VoxelHitsTrkTheta);
+          flatten(treeEvtColl.m_VoxelTrkLength,treeEvtColl.m_VoxelHitsTrkLength);
+          flatten(treeEvtColl.m_VoxelTrkPositionX,treeEvtColl.m_VoxelHitsTrkPosX);
+          flatten(treeEvtColl.m_VoxelTrkPositionY,treeEvtColl.m_VoxelHitsTrkPosY);
+          flatten(treeEvtColl.m_VoxelTrkPositionZ,treeEvtColl.m_VoxelHitsTrkPosZ);
         }
+        analysisManager->AddNtupleRow(ntupleId);
+        continue;
+      }
+
+      for (int i=0;i<nHits;++i){ // a.k.a. voxel loop => creates nEvents=nHits in the NTuple
+        fillEventColumns();
 
         if(treeEvtColl.m_cell_tree_structure){
-          fillNtupleIColumn("CellIdX",treeEvtColl.m_CellIdX.at(i));
-          fillNtupleIColumn("CellIdY",treeEvtColl.m_CellIdY.at(i));
-          fillNtupleIColumn("CellIdZ",treeEvtColl.m_CellIdZ.at(i));
+          fillNtupleIColumn(Column::CellIdX,treeEvtColl.m_CellIdX.at(i));
+          fillNtupleIColumn(Column::CellIdY,treeEvtColl.m_CellIdY.at(i));
+          fillNtupleIColumn(Column::CellIdZ,treeEvtColl.m_CellIdZ.at(i));
           if(!minimalistic_ttree){
-            fillNtupleDColumn("CellPositionX",treeEvtColl.m_CellPositionX.at(i));
-            fillNtupleDColumn("CellPositionY",treeEvtColl.m_CellPositionY.at(i));
-            fillNtupleDColumn("CellPositionZ",treeEvtColl.m_CellPositionZ.at(i));
-            fillNtupleDColumn("CellEDeposit",treeEvtColl.m_VoxelHitEDeposit.at(i));         // take value from voxel (vox volume==cell)
-            fillNtupleDColumn("CellMeanEDeposit",treeEvtColl.m_VoxelHitMeanEDeposit.at(i)); // take value from voxel (vox volume==cell)
+            fillNtupleDColumn(Column::CellPositionX,treeEvtColl.m_CellPositionX.at(i));
+            fillNtupleDColumn(Column::CellPositionY,treeEvtColl.m_CellPositionY.at(i));
+            fillNtupleDColumn(Column::CellPositionZ,treeEvtColl.m_CellPositionZ.at(i));
+            fillNtupleDColumn(Column::CellEDeposit,treeEvtColl.m_VoxelHitEDeposit.at(i));         // take value from voxel (vox volume==cell)
+            fillNtupleDColumn(Column::CellMeanEDeposit,treeEvtColl.m_VoxelHitMeanEDeposit.at(i)); // take value from voxel (vox volume==cell)
+            fillNtupleDColumn(Column::CellVarEDeposit,treeEvtColl.m_VoxelHitVarEDeposit.at(i));
           }
-          fillNtupleDColumn("CellDose",treeEvtColl.m_CellIDose.at(i));
+          fillNtupleDColumn(Column::CellDose,treeEvtColl.m_CellIDose.at(i));
 
         }
         if(treeEvtColl.m_voxel_tree_structure){
-          fillNtupleIColumn("VoxelIdX",treeEvtColl.m_VoxelIdX.at(i));
-          fillNtupleIColumn("VoxelIdY",treeEvtColl.m_VoxelIdY.at(i));
-          fillNtupleIColumn("VoxelIdZ",treeEvtColl.m_VoxelIdZ.at(i));
+          fillNtupleIColumn(Column::VoxelIdX,treeEvtColl.m_VoxelIdX.at(i));
+          fillNtupleIColumn(Column::VoxelIdY,treeEvtColl.m_VoxelIdY.at(i));
+          fillNtupleIColumn(Column::VoxelIdZ,treeEvtColl.m_VoxelIdZ.at(i));
           if(!minimalistic_ttree){
-            fillNtupleDColumn("VoxelPositionX",treeEvtColl.m_VoxelPositionX.at(i));
-            fillNtupleDColumn("VoxelPositionY",treeEvtColl.m_VoxelPositionY.at(i));
-            fillNtupleDColumn("VoxelPositionZ",treeEvtColl.m_VoxelPositionZ.at(i));
-            fillNtupleDColumn("VoxelEDeposit",treeEvtColl.m_VoxelHitEDeposit.at(i));
-            fillNtupleDColumn("VoxelMeanEDeposit",treeEvtColl.m_VoxelHitMeanEDeposit.at(i));
+            fillNtupleDColumn(Column::VoxelPositionX,treeEvtColl.m_VoxelPositionX.at(i));
+            fillNtupleDColumn(Column::VoxelPositionY,treeEvtColl.m_VoxelPositionY.at(i));
+            fillNtupleDColumn(Column::VoxelPositionZ,treeEvtColl.m_VoxelPositionZ.at(i));
+            fillNtupleDColumn(Column::VoxelEDeposit,treeEvtColl.m_VoxelHitEDeposit.at(i));
+            fillNtupleDColumn(Column::VoxelMeanEDeposit,treeEvtColl.m_VoxelHitMeanEDeposit.at(i));
+            fillNtupleDColumn(Column::VoxelVarEDeposit,treeEvtColl.m_VoxelHitVarEDeposit.at(i));
           }
-          fillNtupleDColumn("VoxelDose",treeEvtColl.m_VoxelHitDose.at(i));
+          fillNtupleDColumn(Column::VoxelDose,treeEvtColl.m_VoxelHitDose.at(i));
         }
 
         if(treeEvtColl.m_tracks_analysis){
-          treeEvtColl.m_VoxelTrkId.clear();
           treeEvtColl.m_VoxelTrkId = treeEvtColl.m_VoxelHitsTrkId.at(i);
-          treeEvtColl.m_VoxelTrkTypeId.clear();
           treeEvtColl.m_VoxelTrkTypeId = treeEvtColl.m_VoxelHitsTrkTypeId.at(i);
-          treeEvtColl.m_VoxelTrkEnergy.clear();
           treeEvtColl.m_VoxelTrkEnergy = treeEvtColl.m_VoxelHitsTrkEnergy.at(i);
-          treeEvtColl.m_VoxelTrkTheta.clear();
           treeEvtColl.m_VoxelTrkTheta = treeEvtColl.m_VoxelHitsTrkTheta.at(i);
-          treeEvtColl.m_VoxelTrkLength.clear();
           treeEvtColl.m_VoxelTrkLength = treeEvtColl.m_VoxelHitsTrkLength.at(i);
-          treeEvtColl.m_VoxelTrkPositionX.clear();
           treeEvtColl.m_VoxelTrkPositionX = treeEvtColl.m_VoxelHitsTrkPosX.at(i);
-          treeEvtColl.m_VoxelTrkPositionY.clear();
           treeEvtColl.m_VoxelTrkPositionY = treeEvtColl.m_VoxelHitsTrkPosY.at(i);
-          treeEvtColl.m_VoxelTrkPositionZ.clear();
           treeEvtColl.m_VoxelTrkPositionZ = treeEvtColl.m_VoxelHitsTrkPosZ.at(i);
         }
 
@@ -461,6 +507,7 @@ void NTupleEventAnalisys::ClearEventCollections(){
 
     coll->second.m_VoxelHitEDeposit.clear();
     coll->second.m_VoxelHitMeanEDeposit.clear();
+    coll->second.m_VoxelHitVarEDeposit.clear();
     coll->second.m_VoxelHitDose.clear();
 
     coll->second.m_VoxelHitsTrkId.clear();
@@ -471,6 +518,7 @@ void NTupleEventAnalisys::ClearEventCollections(){
     coll->second.m_VoxelHitsTrkPosX.clear();
     coll->second.m_VoxelHitsTrkPosY.clear();
     coll->second.m_VoxelHitsTrkPosZ.clear();
+    coll->second.m_VoxelTrkN.clear();
     
     coll->second.m_CellIDose.clear();
 
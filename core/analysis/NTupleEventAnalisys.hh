@@ -6,6 +6,7 @@
 #define D3D_EVENT_ANALYSIS_HH
 
 #include "globals.hh"
+#include <array>
 #include <vector>
 #include "G4ThreeVector.hh"
 #include "G4SystemOfUnits.hh"
@@ -37,9 +38,20 @@ class NTupleEventAnalisys {
     ///
     class TTreeEventCollection {
       public:
+        /// The scalar columns filled explicitly (the vector ones are bound to the members below)
+        enum Column { ThreadId, G4EvtId, G4RunId, G4EvtGlobalTime, G4EvtPrimaryN, GantryAngle,
+                      CellIdX, CellIdY, CellIdZ, CellPositionX, CellPositionY, CellPositionZ,
+                      CellEDeposit, CellMeanEDeposit, CellVarEDeposit, CellDose,
+                      VoxelIdX, VoxelIdY, VoxelIdZ, VoxelPositionX, VoxelPositionY, VoxelPositionZ,
+                      VoxelEDeposit, VoxelMeanEDeposit, VoxelVarEDeposit, VoxelDose, NColumns };
+
         G4int m_evtId = -1;
         G4int m_ntupleId = -1;
-        std::map<G4String, G4int> m_colId; // variable index within NTuples structure
+        /// Column index within NTuples structure, resolved once the ntuple is created (-1: not defined)
+        std::array<G4int, NColumns> m_colId;
+        /// One row per event with the vector columns of the hits (RunSvc::NTupleLayout = "event"),
+        /// otherwise one row per hit
+        bool m_event_rows = false;
         bool m_cell_tree_structure = true;
         bool m_voxel_tree_structure = false;
         bool m_tracks_analysis = false;
@@ -51,7 +63,7 @@ class NTupleEventAnalisys {
         std::vector<G4int>    m_VoxelIdX, m_VoxelIdY, m_VoxelIdZ;
         std::vector<G4int> m_VoxelHitIdX, m_VoxelHitIdY, m_VoxelHitIdZ;
         std::vector<G4double> m_CellIDose;
-        std::vector<G4double> m_VoxelHitEDeposit, m_VoxelHitMeanEDeposit, m_VoxelHitDose, m_PrimaryTrkEnergy, m_EvtTime; 
+        std::vector<G4double> m_VoxelHitEDeposit, m_VoxelHitMeanEDeposit, m_VoxelHitVarEDeposit, m_VoxelHitDose, m_PrimaryTrkEnergy, m_EvtTime; 
         std::vector<G4double> m_G4EvtPrimaryEnergy;
         std::vector<G4double> m_VoxelPositionX, m_VoxelPositionY, m_VoxelPositionZ;
         std::vector<G4double> m_CellPositionX, m_CellPositionY, m_CellPositionZ;
@@ -63,6 +75,9 @@ class NTupleEventAnalisys {
         std::vector<std::vector<G4double>> m_VoxelHitsTrkPosX; std::vector<G4double> m_VoxelTrkPositionX;
         std::vector<std::vector<G4double>> m_VoxelHitsTrkPosY; std::vector<G4double> m_VoxelTrkPositionY;
         std::vector<std::vector<G4double>> m_VoxelHitsTrkPosZ; std::vector<G4double> m_VoxelTrkPositionZ;
+        std::vector<G4int> m_VoxelTrkN; // the number of tracks of each hit (the event rows: flattened tracks)
+
+        TTreeEventCollection() { m_colId.fill(-1); }
 
     };
 
@@ -81,11 +96,11 @@ class NTupleEventAnalisys {
     };
 
 
-    ///
-    G4int m_runId = -1;
+    /// Per-thread, a thread of the tasking pool can begin the run at any time
+    G4Cache<G4int> m_runId;
 
     ///
-    G4double m_degree_rotation = -10000.;
+    G4Cache<G4double> m_degree_rotation;
 
     ///
     G4String m_treeNamePostfix = "TTree";
@@ -1,6 +1,7 @@
 #include "NTupleRunAnalysis.hh"
 #include "Services.hh"
 #include "ControlPoint.hh"
+#include "RunOutputWriter.hh"
 #include "IO.hh"
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -13,15 +14,14 @@ NTupleRunAnalysis *NTupleRunAnalysis::GetInstance() {
 
 ////////////////////////////////////////////////////////////////////////////////
 ///
-void NTupleRunAnalysis::WriteFieldMaskToTFile(const G4Run* runPtr){
-    auto cp = Service<RunSvc>()->CurrentControlPoint();
-    auto fname = cp->GetOutputFileName()+"_field_mask.root";
-    auto dir_name = "RT_Plan/CP_"+std::to_string(cp->GetId());
+void NTupleRunAnalysis::WriteFieldMaskToTFile(const RunOutputSnapshot& snapshot){
+    auto fname = snapshot.m_output_file_name+"_field_mask.root";
+    auto dir_name = "RT_Plan/CP_"+std::to_string(snapshot.m_cp_id);
     auto file = IO::CreateOutputTFile(fname,dir_name);
     auto cp_dir = file->GetDirectory(dir_name.c_str());
-    auto data_types = cp->DataTypes();
-    for(const auto& type : data_types){
-        auto field_mask = cp->GetFieldMask(type);
+    for(const auto& mask : snapshot.m_field_masks){
+        const auto& type = mask.first;
+        const auto& field_mask = mask.second;
         if(field_mask.size()>0){
             auto linearized_mask_vec = svc::linearizeG4ThreeVector(field_mask);
             std::string name = "FieldMask_"+type;
@@ -36,13 +36,13 @@ void NTupleRunAnalysis::WriteFieldMaskToTFile(const G4Run* runPtr){
 
 ////////////////////////////////////////////////////////////////////////////////
 ///
-void NTupleRunAnalysis::WriteDoseToTFile(const G4Run* runPtr){
-    auto cp = Service<RunSvc>()->CurrentControlPoint();
-    auto fname = cp->GetOutputFileName()+"_dose.root";
-    auto dir_name = "RT_Plan/CP_"+std::to_string(cp->GetId());
+void NTupleRunAnalysis::WriteDoseToTFile(const RunOutputSnapshot& snapshot){
+    auto fname = snapshot.m_output_file_name+"_dose.root";
+    auto dir_name = "RT_Plan/CP_"+std::to_string(snapshot.m_cp_id);
     auto file = IO::CreateOutputTFile(fname,dir_name);
     auto cp_dir = file->GetDirectory(dir_name.c_str());
-    const auto& scoring_maps = cp->GetRun()->GetScoringCollections();
+    const auto& scoring_maps = snapshot.m_scoring_maps;
+    auto nHistories = snapshot.m_n_histories;
     LOGSVC_INFO("NTupleRunAnalysis::WriteDoseToTFile #{} collections:",scoring_maps.size());
     for(auto& scoring_map: scoring_maps){
         LOGSVC_INFO("NTupleRunAnalysis::WriteDoseToTFile::Processing {} run collection:",scoring_map.first);
@@ -54,19 +54,31 @@ void NTupleRunAnalysis::WriteDoseToTFile(const G4Run* runPtr){
             std::vector<double> linearized_mask_vec;
             std::vector<double> infield_tag_vec;
             std::vector<double> dose_vec;
-            for(auto& scoring : data){
-                auto pos = scoring.second.GetCentre();
+            std::vector<double> dose_uncertainty_vec;
+            std::vector<double> steps_edep_mean_vec;
+            std::vector<double> steps_edep_var_vec;
+            for(auto& hit : data){
+                auto pos = hit.GetCentre();
                 for(const auto& i :  svc::linearizeG4ThreeVector(pos))
                     linearized_mask_vec.emplace_back(i);
-                infield_tag_vec.emplace_back(scoring.second.GetFieldScalingFactor());
-                dose_vec.emplace_back(scoring.second.GetDose());
+                infield_tag_vec.emplace_back(hit.GetFieldScalingFactor());
+                dose_vec.emplace_back(hit.GetDose());
+                dose_uncertainty_vec.emplace_back(hit.GetDoseRelativeUncertainty(nHistories));
+                steps_edep_mean_vec.emplace_back(hit.GetStepsEnergyDeposit().GetMean()/keV);
+                steps_edep_var_vec.emplace_back(hit.GetStepsEnergyDeposit().GetVariance()/(keV*keV));
             }
             std::string name_pos = collection+"_VolumeFieldScalingFactorPosition_"+type;
             std::string name_ftag = collection+"_VolumeFieldScalingFactorValue_"+type;
             std::string name_dose = collection+"_Dose_"+type;
+            std::string name_dose_uncertainty = collection+"_DoseRelUncertainty_"+type;
+            std::string name_edep_mean = collection+"_StepEDepMean_"+type;
+            std::string name_edep_var = collection+"_StepEDepVariance_"+type;
             cp_dir->WriteObject(&linearized_mask_vec,name_pos.c_str());
             cp_dir->WriteObject(&infield_tag_vec,name_ftag.c_str());
             cp_dir->WriteObject(&dose_vec,name_dose.c_str());
+            cp_dir->WriteObject(&dose_uncertainty_vec,name_dose_uncertainty.c_str());
+            cp_dir->WriteObject(&steps_edep_mean_vec,name_edep_mean.c_str());
+            cp_dir->WriteObject(&steps_edep_var_vec,name_edep_var.c_str());
             file->Write();
         }
     }
@@ -7,7 +7,7 @@
 
 #include "globals.hh"
 
-class G4Run;
+struct RunOutputSnapshot;
 
 class NTupleRunAnalysis {
     private:
@@ -28,8 +28,8 @@ class NTupleRunAnalysis {
         static NTupleRunAnalysis* GetInstance();
 
         ///
-        void WriteDoseToTFile(const G4Run* runPtr);
-        void WriteFieldMaskToTFile(const G4Run* runPtr);
+        void WriteDoseToTFile(const RunOutputSnapshot& snapshot);
+        void WriteFieldMaskToTFile(const RunOutputSnapshot& snapshot);
 };
 
 #endif //NTUPLE_RUN_ANALYSIS_HH
\ No newline at end of file
@@ -110,7 +110,8 @@ void PrimariesAnalysis::FillPrimaries(const G4Event *evt){
 // void PrimariesAnalysis::FillPrimaries(G4PrimaryVertex* vertex){
   auto nVertex = evt->GetNumberOfPrimaryVertex();
   m_primaryN.Put(nVertex);
-  auto isoToSim = Service<ConfigSvc>()->GetValue<G4ThreeVector>("WorldConstruction", "IsoToSimTransformation");
+  static const auto isoToSimHandle = Service<ConfigSvc>()->GetHandle<G4ThreeVector>("WorldConstruction", "IsoToSimTransformation");
+  const auto& isoToSim = isoToSimHandle.Get();
   if(nVertex>0){
     for(int n=0;n<nVertex;++n){
       auto vertex = evt->GetPrimaryVertex(n);
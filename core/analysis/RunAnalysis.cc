@@ -10,6 +10,11 @@
 #include "G4AnalysisManager.hh"
 #include "CsvRunAnalysis.hh"
 #include "NTupleRunAnalysis.hh"
+#include "BinaryRunAnalysis.hh"
+#include "DoseConvergenceMonitor.hh"
+#include "RunOutputWriter.hh"
+#include "ControlPoint.hh"
+#include "G4RunManager.hh"
 #include "Services.hh"
 #ifdef G4MULTITHREADED
   #include "G4MTRunManager.hh"
@@ -22,6 +27,8 @@ RunAnalysis::RunAnalysis(){
         m_csv_run_analysis = CsvRunAnalysis::GetInstance();
     if(!m_ntuple_run_analysis) // TODO: && RUN_NTUPLE_ANALYSIS
         m_ntuple_run_analysis = NTupleRunAnalysis::GetInstance();
+    if(!m_binary_run_analysis)
+        m_binary_run_analysis = BinaryRunAnalysis::GetInstance();
     // TODO: RUN_HDF5_ANALYSIS
   }
   m_is_initialized = true;
@@ -49,7 +56,17 @@ void RunAnalysis::BeginOfRun(const G4Run* runPtr, G4bool isMaster){
 /// This member is called at the end of every event from EventAction::EndOfEventAction
 void RunAnalysis::EndOfEventAction(const G4Event *evt){
     auto hCofThisEvent = evt->GetHCofThisEvent();
-    m_current_cp->FillEventCollections(hCofThisEvent);
+    m_current_cp->FillEventCollections(hCofThisEvent,evt->GetEventID());
+
+    auto monitor = DoseConvergenceMonitor::GetInstance();
+    if(monitor->IsEnabled()){
+        auto run = m_current_cp->GetRun();
+        auto nHistories = run->GetNumberOfEvent() + 1; // the current event is not recorded yet
+        if(nHistories % monitor->GetCheckInterval() == 0)
+            monitor->Submit(run,nHistories);
+        if(monitor->IsConverged())
+            G4RunManager::GetRunManager()->AbortRun(true); // soft: the current event is completed
+    }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -58,14 +75,34 @@ void RunAnalysis::EndOfRun(const G4Run* runPtr){
     LOGSVC_INFO("RunAnalysis::EndOfRun:: CtrlPoint-{} / G4Run-{}", m_current_cp->GetId(), runPtr->GetRunID());
     // Note: Multithreading merging is being performed before...
     m_current_cp->GetRun()->EndOfRun();
-    if(m_csv_run_analysis){
-        m_csv_run_analysis->WriteDoseToCsv(runPtr);
-        m_csv_run_analysis->WriteFieldMaskToCsv(runPtr);
+    if(m_csv_run_analysis) // it navigates the geometry, hence it's done here
         PatientGeometry::GetInstance()->ExportDoseToCsvCT(runPtr);
-    }
 
-    if(m_ntuple_run_analysis){
-        m_ntuple_run_analysis->WriteDoseToTFile(runPtr);
-        m_ntuple_run_analysis->WriteFieldMaskToTFile(runPtr);
+    // The per-voxel dose table format: csv, binary (see DoseFile) or both
+    auto format = Service<ConfigSvc>()->GetValue<std::string>("RunSvc", "DoseOutputFormat");
+    if(format != "csv" && format != "binary" && format != "both"){
+        G4String msg = "Unknown RunSvc::DoseOutputFormat ("+format+"), the csv, binary or both are available";
+        LOGSVC_CRITICAL(msg.data());
+        G4Exception("RunAnalysis", "EndOfRun", FatalErrorInArgument, msg);
     }
+    auto csv = m_csv_run_analysis;
+    auto ntuple = m_ntuple_run_analysis;
+    auto binary = format != "csv" ? m_binary_run_analysis : nullptr;
+    auto csvDose = format != "binary";
+
+    // The files are written in the background, while the next control point is being simulated
+    auto snapshot = RunOutputSnapshot::Take(m_current_cp);
+    RunOutputWriter::GetInstance()->Submit([snapshot, csv, csvDose, ntuple, binary](){
+        if(csv){
+            if(csvDose)
+                csv->WriteDoseToCsv(*snapshot);
+            csv->WriteFieldMaskToCsv(*snapshot);
+        }
+        if(binary)
+            binary->WriteDoseToBinary(*snapshot);
+        if(ntuple){
+            ntuple->WriteDoseToTFile(*snapshot);
+            ntuple->WriteFieldMaskToTFile(*snapshot);
+        }
+    });
 }
\ No newline at end of file
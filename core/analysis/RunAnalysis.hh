@@ -10,17 +10,16 @@
 #include "G4ThreeVector.hh"
 #include "G4SystemOfUnits.hh"
 #include "G4Cache.hh"
-#include "VoxelHit.hh"
+#include "VoxelHitMap.hh"
 #include "Types.hh"
 
 class ControlPoint;
 class CsvRunAnalysis;
 class NTupleRunAnalysis;
+class BinaryRunAnalysis;
 class G4Event;
 class G4Run;
 
-typedef std::map<Scoring::Type, std::map<std::size_t, VoxelHit>> ScoringMap;
-
 class RunAnalysis {
 
   private:
@@ -43,6 +42,7 @@ class RunAnalysis {
     ///
     CsvRunAnalysis* m_csv_run_analysis = nullptr;
     NTupleRunAnalysis* m_ntuple_run_analysis = nullptr;
+    BinaryRunAnalysis* m_binary_run_analysis = nullptr;
 
     ///
     bool m_is_initialized = false;
@@ -0,0 +1,121 @@
+#include "RunOutputWriter.hh"
+#include "ControlPoint.hh"
+#include "Services.hh"
+#include "TROOT.h"
+#include <pybind11/embed.h>
+
+namespace py = pybind11;
+
+namespace {
+    /// The GIL is released (if held) for the time the calling thread waits for the writer
+    std::unique_ptr<py::gil_scoped_release> ReleaseGIL(){
+        if(Py_IsInitialized() && PyGILState_Check())
+            return std::make_unique<py::gil_scoped_release>();
+        return nullptr;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+std::shared_ptr<const RunOutputSnapshot> RunOutputSnapshot::Take(ControlPoint* cp){
+    auto snapshot = std::make_shared<RunOutputSnapshot>();
+    snapshot->m_cp_id = cp->GetId();
+    snapshot->m_output_file_name = cp->GetOutputFileName();
+    snapshot->m_n_histories = cp->GetRun()->GetNumberOfEvent();
+    snapshot->m_rotation = cp->GetDegreeRotation();
+    snapshot->m_scoring_maps = cp->GetRun()->GetScoringCollections();
+    for(const auto& type : cp->DataTypes())
+        snapshot->m_field_masks.emplace_back(type, cp->GetFieldMask(type));
+    return snapshot;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+RunOutputWriter *RunOutputWriter::GetInstance() {
+    static RunOutputWriter instance;
+    return &instance;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+RunOutputWriter::~RunOutputWriter(){
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_job_added.notify_all();
+    if(m_thread.joinable())
+        m_thread.join();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+void RunOutputWriter::Submit(std::function<void()> job){
+    auto queueSize = Service<ConfigSvc>()->GetValue<int>("RunSvc", "OutputQueueSize");
+    if(queueSize <= 0){
+        Execute(job);
+        return;
+    }
+    auto release = ReleaseGIL();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if(!m_thread.joinable()){
+        ROOT::EnableThreadSafety(); // the TFiles are written concurrently with the main thread ones
+        m_thread = std::thread(&RunOutputWriter::Process, this);
+    }
+    if(m_queue.size() >= static_cast<std::size_t>(queueSize))
+        LOGSVC_DEBUG("RunOutputWriter:: the queue is full ({}), waiting for the writer...",m_queue.size());
+    m_job_done.wait(lock, [&]{ return m_queue.size() < static_cast<std::size_t>(queueSize); });
+    m_queue.emplace_back(std::move(job));
+    lock.unlock();
+    m_job_added.notify_one();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+void RunOutputWriter::Flush(){
+    G4int nFailed = 0;
+    {
+        auto release = ReleaseGIL();
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_job_done.wait(lock, [&]{ return m_queue.empty() && !m_busy; });
+        std::swap(nFailed, m_n_failed);
+    }
+    if(nFailed > 0){
+        G4String msg = std::to_string(nFailed)+" of the output writing jobs failed";
+        LOGSVC_CRITICAL(msg.data());
+        G4Exception("RunOutputWriter", "Flush", FatalException, msg);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+void RunOutputWriter::Process(){
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while(true){
+        m_job_added.wait(lock, [&]{ return m_stop || !m_queue.empty(); });
+        if(m_queue.empty()) // stopped
+            return;
+        auto job = std::move(m_queue.front());
+        m_queue.pop_front();
+        m_busy = true;
+        lock.unlock();
+        m_job_done.notify_all(); // the queue slot is free
+        Execute(job);
+        lock.lock();
+        m_busy = false;
+        m_job_done.notify_all();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+void RunOutputWriter::Execute(const std::function<void()>& job){
+    try {
+        job();
+    }
+    catch(const std::exception& e){
+        LOGSVC_ERROR("RunOutputWriter:: writing failed: {}",e.what());
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_n_failed;
+    }
+}
@@ -0,0 +1,96 @@
+#ifndef RUN_OUTPUT_WRITER_HH
+#define RUN_OUTPUT_WRITER_HH
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+#include "VoxelHitMap.hh"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class ControlPoint;
+
+////////////////////////////////////////////////////////////////////////////////
+///\brief Immutable copy of the control point run data written to the output files.
+/// It's taken in the master thread at the end of run, hence the writers don't touch
+/// the control point (nor its run), which is being reused by the next BeamOn meanwhile.
+struct RunOutputSnapshot {
+    ///
+    G4int m_cp_id = -1;
+
+    /// ControlPoint::GetOutputFileName (the file name prefix)
+    std::string m_output_file_name;
+
+    ///
+    G4long m_n_histories = 0;
+
+    /// ControlPoint::GetDegreeRotation
+    G4double m_rotation = 0.;
+
+    /// RunCollectionName / ScoringMap
+    std::map<G4String,ScoringMap> m_scoring_maps;
+
+    /// Field mask type / points (the control point DataTypes order)
+    std::vector<std::pair<std::string,std::vector<G4ThreeVector>>> m_field_masks;
+
+    /// To be called in the master thread (the plan field mask may be evaluated here)
+    static std::shared_ptr<const RunOutputSnapshot> Take(ControlPoint* cp);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+///\brief Dedicated I/O thread serializing the end of run outputs (CSV, ROOT and field mask PNG),
+/// thus the transport of the next control point runs meanwhile. The queue is bounded by
+/// RunSvc::OutputQueueSize (control points), Submit blocks once it's full; 0 - synchronous writing.
+/// The thread is started with the first job, i.e. after the control point processes are forked.
+/// Note: The Python GIL is released while the caller waits for the writer (the PNG rendering),
+/// see also UIManager::UserRunInitialization, where it's released for the BeamOn.
+class RunOutputWriter {
+    private:
+        ///
+        RunOutputWriter() = default;
+
+        ///
+        ~RunOutputWriter();
+
+        /// Delete the copy and move constructors
+        RunOutputWriter(const RunOutputWriter &) = delete;
+        RunOutputWriter &operator=(const RunOutputWriter &) = delete;
+        RunOutputWriter(RunOutputWriter &&) = delete;
+        RunOutputWriter &operator=(RunOutputWriter &&) = delete;
+
+        ///
+        std::thread m_thread;
+        std::mutex m_mutex;
+        std::condition_variable m_job_added;
+        std::condition_variable m_job_done;
+        std::deque<std::function<void()>> m_queue;
+
+        ///
+        bool m_busy = false;
+        bool m_stop = false;
+        G4int m_n_failed = 0;
+
+        /// The I/O thread loop
+        void Process();
+
+        /// Run the job, the failures are counted (reported by Flush)
+        void Execute(const std::function<void()>& job);
+
+    public:
+        ///
+        static RunOutputWriter* GetInstance();
+
+        /// Enqueue the job (or run it in place once the queue size is 0)
+        void Submit(std::function<void()> job);
+
+        /// Barrier: wait for all the submitted jobs being done, G4Exception if any has failed
+        void Flush();
+};
+
+#endif //RUN_OUTPUT_WRITER_HH
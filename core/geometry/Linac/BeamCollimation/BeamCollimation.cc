@@ -115,12 +115,17 @@ void BeamCollimation::SetRunConfiguration(const ControlPoint* control_point){
 ////////////////////////////////////////////////////////////////////////////////
 ///
 
-void BeamCollimation::FilterPrimaries(std::vector<G4PrimaryVertex*>& p_vrtx) {
+void BeamCollimation::FilterPrimaries(std::vector<G4PrimaryVertex*>& p_vrtx, bool preFiltered) {
   Service<RunSvc>()->CurrentControlPoint()->MLC();
 
   auto model = Service<GeoSvc>()->GetMlcModel();
   for(int i=0; i < p_vrtx.size();++i){
     auto vrtx = p_vrtx.at(i);
+    if(preFiltered){
+      if(model != EMlcModel::Simplified)
+        BeamCollimation::SetParticlePositionBeforeCollimators(vrtx, BeforeJaws);
+      continue;
+    }
     auto theta = vrtx->GetPrimary()->GetMomentum().theta();
     if (theta * 180.0 / M_PI > ParticleAngleTreshold ){
       delete vrtx;
@@ -40,7 +40,8 @@ class BeamCollimation : public IPhysicalVolume, public RunComponet {
   ///
   void WriteInfo() override;
 
-  static void FilterPrimaries(std::vector<G4PrimaryVertex*>& p_vrtx);
+  /// The angle and field cuts are skipped for the vertices already filtered in the reader (see PhspFieldFilter)
+  static void FilterPrimaries(std::vector<G4PrimaryVertex*>& p_vrtx, bool preFiltered = false);
 
   static G4ThreeVector SetParticlePositionBeforeCollimators(G4PrimaryVertex* vrtx, G4double finalZ);
 
@@ -117,3 +117,9 @@ bool MlcSimplified::IsInField(const G4ThreeVector& position, bool transformToIso
 bool MlcSimplified::IsInField(G4PrimaryVertex* vrtx) {
     return IsInField(VMlc::GetPositionInMaskPlane(vrtx)); 
 }
+
+std::vector<std::pair<double,double>> MlcSimplified::GetFieldPolygon() const {
+    if (m_fieldShape == "RTPlan" || m_fieldShape == "CustomPlan")
+        return m_mlc_corners; // the same polygon as tested by IsInField
+    return {};
+}
@@ -18,6 +18,7 @@ public:
     ~MlcSimplified() override {};	
     bool IsInField(const G4ThreeVector& position, bool transformToIsocentre = false) override;
     bool IsInField(G4PrimaryVertex* vrtx) override;
+    std::vector<std::pair<double,double>> GetFieldPolygon() const override;
     void SetRunConfiguration(const ControlPoint* ) override;
 
 
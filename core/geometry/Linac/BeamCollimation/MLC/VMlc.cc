@@ -57,8 +57,13 @@ G4ThreeVector VMlc::GetPositionInMaskPlane(const G4ThreeVector& position){
 }
 
 G4ThreeVector VMlc::GetPositionInMaskPlane(const G4PrimaryVertex* vrtx){
-    auto position = vrtx->GetPosition();
-    auto direction = vrtx->GetPrimary()->GetMomentum().unit();
+    return GetPositionInMaskPlane(vrtx->GetPosition(), vrtx->GetPrimary()->GetMomentum());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// The particle position propagated along its momentum to the isocentre Z plane
+G4ThreeVector VMlc::GetPositionInMaskPlane(const G4ThreeVector& position, const G4ThreeVector& momentum){
+    auto direction = momentum.unit();
     G4double z = m_isocentre.z();
     G4double deltaZ = z - position.getZ();
     G4double zRatio = deltaZ / direction.getZ(); 
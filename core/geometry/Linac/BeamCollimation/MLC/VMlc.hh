@@ -28,10 +28,13 @@ class VMlc: public RunComponet {
         virtual ~VMlc() = default;
         virtual bool IsInField(const G4ThreeVector& position, bool transformToIsocentre=false) = 0;
         virtual bool IsInField(G4PrimaryVertex* vrtx) = 0;
+        /// The aperture outline (x,y) at the isocentre plane, empty if the shape isn't a polygon
+        virtual std::vector<std::pair<double,double>> GetFieldPolygon() const { return {}; }
         std::vector<G4ThreeVector> GetMlcPositioning(const std::string& side) const;
         bool Initialized(const ControlPoint* control_point) const;
         static G4ThreeVector GetPositionInMaskPlane(const G4ThreeVector& position);
         static G4ThreeVector GetPositionInMaskPlane(const G4PrimaryVertex* vrtx);
+        static G4ThreeVector GetPositionInMaskPlane(const G4ThreeVector& position, const G4ThreeVector& momentum);
 
         static G4double GetMlcZPosition();
 };
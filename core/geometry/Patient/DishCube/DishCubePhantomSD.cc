@@ -17,7 +17,7 @@ G4bool DishCubePhantomSD::ProcessHits(G4Step* aStep, G4TouchableHistory*) {
   // i.e. get volume where G4Step is remember (Note: PostStep "belongs" to next volume,
   // hence we use PreStepPoint!
   auto theTouchable = dynamic_cast<const G4TouchableHistory *>(aStep->GetPreStepPoint()->GetTouchable());
-  auto volumeName = theTouchable->GetVolume()->GetName();
+  const auto& volumeName = theTouchable->GetVolume()->GetName();
   if (volumeName != "DishCubePhantomPV")
     G4cout << "[debug]:: ProcessHits volume name " << volumeName << G4endl;
   
@@ -34,12 +34,11 @@ G4bool DishCubePhantomSD::ProcessHits(G4Step* aStep, G4TouchableHistory*) {
   }
 
   // ____________________________________________________________________________
-  for(const auto& hcName : ControlPoint::GetHitCollectionNames())
-    ProcessHitsCollection(hcName,aStep); 
+  ProcessScoringVolumes(aStep);
 
   // ____________________________________________________________________________
   // Collect all hits in this detector volume
-  if (Service<ConfigSvc>()->GetValue<bool>("RunSvc", "StepAnalysis"))
+  if (m_step_analysis)
     StepAnalysis::GetInstance()->FillStep(aStep);
 
   return true;
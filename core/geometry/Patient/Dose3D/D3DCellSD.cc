@@ -22,7 +22,7 @@ G4bool D3DCellSD::ProcessHits(G4Step* aStep, G4TouchableHistory*) {
   // i.e. get volume where G4Step is remember 
   // Note: PostStep on the boundary "belongs" to next volume hence we use PreStepPoint!
   auto theTouchable = dynamic_cast<const G4TouchableHistory *>(aStep->GetPreStepPoint()->GetTouchable());
-  auto volumeName = theTouchable->GetVolume()->GetName();
+  const auto& volumeName = theTouchable->GetVolume()->GetName();
   if ( ! G4StrUtil::contains(volumeName, "D3D"))
     LOGSVC_DEBUG("ProcessHits volume name ", volumeName);
   
@@ -41,11 +41,7 @@ G4bool D3DCellSD::ProcessHits(G4Step* aStep, G4TouchableHistory*) {
   }
 
   // ____________________________________________________________________________
-  auto thisSdHCNames = GetScoringVolumeNames(); // it may happen that there is more instances of this SD type, 
-  // hence Hits Collections existing independent from this cell geometry. 
-  for(const auto& hcName : ControlPoint::GetHitCollectionNames()){
-    if(find(thisSdHCNames.begin(), thisSdHCNames.end(), hcName) != thisSdHCNames.end())
-      ProcessHitsCollection(hcName,aStep); 
-  }
+  // Only the hits collections of this cell are resolved (see VPatientSD::InitializeDispatch)
+  ProcessScoringVolumes(aStep);
   return true;
 }
\ No newline at end of file
@@ -15,9 +15,14 @@
 #include <array>
 #include "IO.hh"
 #include "VPatientSD.hh"
+#include "G4AutoLock.hh"
 
 
-std::map<std::string, std::map<std::size_t, VoxelHit>> D3DDetector::m_hashed_scoring_map_template = std::map<std::string, std::map<std::size_t, VoxelHit>>();
+std::map<std::string, VoxelHitMap> D3DDetector::m_hashed_scoring_map_template = std::map<std::string, VoxelHitMap>();
+
+namespace {
+  G4Mutex D3DScoringTemplateMutex = G4MUTEX_INITIALIZER;
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 ///
@@ -317,8 +322,7 @@ void D3DDetector::ExportPositioningToTFile(const std::string& path_to_out_dir) c
     std::vector<int> linearized_id_global;
     std::vector<int> linearized_id;
     auto hashed_scoring_map = GetScoringHashedMap("Dose3D",type);
-    for(auto& scoring_volume : hashed_scoring_map){
-      auto& hit = scoring_volume.second;
+    for(auto& hit : hashed_scoring_map){
       auto volume_centre = hit.GetCentre();
       linearized_positioning.emplace_back(volume_centre.getX());
       linearized_positioning.emplace_back(volume_centre.getY());
@@ -387,8 +391,7 @@ void D3DDetector::ExportVoxelPositioningToCsv(const std::string& path_to_out_dir
     outFile <<"CellPosX[mm]"<<sep<<"CellPosY[mm]"<<sep<<"CellPosZ[mm]"<<sep;
     outFile <<"VoxelPosX[mm]"<<sep<<"VoxelPosY[mm]"<<sep<<"VoxelPosZ[mm]"<< std::endl; // data header
     // Extract voxel position for each cell from scoring map
-    for(auto& scoring_volume : hashed_scoring_map){ // this is the loop over all voxels for given run collection
-      auto& hit = scoring_volume.second;
+    for(auto& hit : hashed_scoring_map){ // this is the loop over all voxels for given run collection
       auto hit_centre_global = hit.GetGlobalCentre();
       auto hit_centre = hit.GetCentre();
       outFile   << hit.GetGlobalID(0) // Cell ID X
@@ -431,8 +434,7 @@ void D3DDetector::ExportCellPositioningToCsv(const std::string& path_to_out_dir)
   outFile.open(file.c_str(), std::ios::out);
   outFile << "CellIdX"<<sep<<"CellIdY"<<sep<<"CellIdZ"<<sep<<"CellPosX[mm]"<<sep<<"CellPosY[mm]"<<sep<<"CellPosZ[mm]"<< std::endl; // data header
   auto hashed_scoring_map = GetScoringHashedMap(run_collection,Scoring::Type::Cell);
-  for(auto& scoring_volume : hashed_scoring_map){ // this is the loop over all cells in geometry layout
-    auto& hit = scoring_volume.second;
+  for(auto& hit : hashed_scoring_map){ // this is the loop over all cells in geometry layout
     auto hit_centre = hit.GetCentre();
     outFile   << hit.GetID(0) // Cell ID X
       << sep  << hit.GetID(1) // Cell ID Y
@@ -475,25 +477,34 @@ void D3DDetector::ExportToGateCsv(const std::string& path_to_out_dir) const {
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-///
-std::map<std::size_t, VoxelHit> D3DDetector::GetScoringHashedMap(const G4String& run_collection, Scoring::Type type) const {
+/// The scoring template is built once per run collection and type and then copied
+/// for every run (the key-to-slot layout is shared between the copies).
+VoxelHitMap D3DDetector::GetScoringHashedMap(const G4String& run_collection, Scoring::Type type) const {
   if(!m_label.contains(run_collection))
-    return std::map<std::size_t, VoxelHit>(); // return empty map
-    
+    return VoxelHitMap(); // return empty map
+
+  G4AutoLock lock(&D3DScoringTemplateMutex);
+  auto template_name = run_collection+"_"+Scoring::to_string(type);
+  auto scoring_template = m_hashed_scoring_map_template.find(template_name);
+  if(scoring_template!=m_hashed_scoring_map_template.end())
+    return scoring_template->second;
+
   // G4cout<<"GetScoringHashedMap for " << run_collection << " / " <<Scoring::to_string(type)<<G4endl;
-  std::map<std::size_t, VoxelHit> hashed_map_scoring;
+  VoxelHitMap hashed_map_scoring;
   auto size = D3DCell::SIZE;
   auto Medium = ConfigSvc::GetInstance()->GetValue<G4MaterialSPtr>("MaterialsSvc", m_config.m_cell_medium);
   for(const auto& mLayer: m_d3d_layers){
-    // TODO: hashed_map_scoring.insert(mLayer->GetScoringHashedMap(run_collection,type));
     for(const auto& cell: mLayer->GetCells()){
       auto centre = cell->GetGlobalCentre();
       auto cIdX = cell->GetIdX();
       auto cIdY = cell->GetIdY();
       auto cIdZ = cell->GetIdZ();
-      auto hashedCellString = std::to_string(cIdX);
-      hashedCellString+=std::to_string(cIdY);
-      hashedCellString+=std::to_string(cIdZ);
+      if(!Scoring::IsKeyIndex(cIdX) || !Scoring::IsKeyIndex(cIdY) || !Scoring::IsKeyIndex(cIdZ)){
+        G4String msg = "The cell ("+std::to_string(cIdX)+","+std::to_string(cIdY)+","+std::to_string(cIdZ)+
+                       ") index is out of the scoring key range [0,"+std::to_string(Scoring::KEY_AXIS_MASK)+"]";
+        LOGSVC_CRITICAL(msg.data());
+        G4Exception("D3DDetector", "GetScoringHashedMap", FatalErrorInArgument, msg);
+      }
 
       if( type==Scoring::Type::Voxel ){ 
         // !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
@@ -505,6 +516,12 @@ std::map<std::size_t, VoxelHit> D3DDetector::GetScoringHashedMap(const G4String&
         auto nvx = cell_sv->m_nVoxelsX;
         auto nvy = cell_sv->m_nVoxelsY;
         auto nvz = cell_sv->m_nVoxelsZ;
+        if(!Scoring::IsKeyIndex(nvx-1) || !Scoring::IsKeyIndex(nvy-1) || !Scoring::IsKeyIndex(nvz-1)){
+          G4String msg = "The cell voxelisation ("+std::to_string(nvx)+","+std::to_string(nvy)+","+std::to_string(nvz)+
+                         ") exceeds the scoring key range of "+std::to_string(Scoring::KEY_AXIS_MASK+1)+" voxels per axis";
+          LOGSVC_CRITICAL(msg.data());
+          G4Exception("D3DDetector", "GetScoringHashedMap", FatalErrorInArgument, msg);
+        }
 
         double pix_size_x = size / nvx;
         double pix_size_y = size / nvy;
@@ -513,35 +530,34 @@ std::map<std::size_t, VoxelHit> D3DDetector::GetScoringHashedMap(const G4String&
         for(int ix=0; ix<nvx; ix++ ){
           for(int iy=0; iy<nvy; iy++ ){
             for(int iz=0; iz<nvz; iz++ ){
-              auto hashedVoxelString = hashedCellString;
-              hashedVoxelString+=std::to_string(ix);
-              hashedVoxelString+=std::to_string(iy);
-              hashedVoxelString+=std::to_string(iz);
-              auto voxelHash = std::hash<std::string>{}(hashedVoxelString);
-              hashed_map_scoring[voxelHash] = VoxelHit();
+              auto& voxel = hashed_map_scoring.Insert(Scoring::PackKey(cIdX,cIdY,cIdZ,ix,iy,iz));
               auto x_centre = centre.getX() - size/2 + (ix) * pix_size_x + pix_size_x/2.;  
               auto y_centre = centre.getY() - size/2 + (iy) * pix_size_y + pix_size_y/2.;  
               auto z_centre = centre.getZ() - size/2 + (iz) * pix_size_z + pix_size_z/2.;
-              hashed_map_scoring[voxelHash].SetCentre(G4ThreeVector(x_centre,y_centre,z_centre));
-              hashed_map_scoring[voxelHash].SetId(ix,iy,iz);
-              hashed_map_scoring[voxelHash].SetGlobalId(cIdX,cIdY,cIdZ);
-              hashed_map_scoring[voxelHash].SetVolume( cell_sv->GetVoxelVolume() );
-              hashed_map_scoring[voxelHash].SetMass(Medium->GetDensity()*hashed_map_scoring[voxelHash].GetVolume());
+              voxel.SetCentre(G4ThreeVector(x_centre,y_centre,z_centre));
+              voxel.SetId(ix,iy,iz);
+              voxel.SetGlobalId(cIdX,cIdY,cIdZ);
+              voxel.SetVolume( cell_sv->GetVoxelVolume() );
+              voxel.SetMass(Medium->GetDensity()*voxel.GetVolume());
             }
           }
         }
       } else if (type==Scoring::Type::Cell){
-        auto cellHash = std::hash<std::string>{}(hashedCellString);
-        hashed_map_scoring[cellHash] = VoxelHit();
-        hashed_map_scoring[cellHash].SetCentre(centre);
-        hashed_map_scoring[cellHash].SetId(cIdX,cIdY,cIdZ);
-        hashed_map_scoring[cellHash].SetGlobalId(cIdX,cIdY,cIdZ); // Id == GlobalId
-        hashed_map_scoring[cellHash].SetVolume( size*size*size );
-        hashed_map_scoring[cellHash].SetMass(Medium->GetDensity()*hashed_map_scoring[cellHash].GetVolume());
-        // hashed_map_scoring[cellHash].Print();
+        auto& cellHit = hashed_map_scoring.Insert(Scoring::PackKey(cIdX,cIdY,cIdZ));
+        cellHit.SetCentre(centre);
+        cellHit.SetId(cIdX,cIdY,cIdZ);
+        cellHit.SetGlobalId(cIdX,cIdY,cIdZ); // Id == GlobalId
+        cellHit.SetVolume( size*size*size );
+        cellHit.SetMass(Medium->GetDensity()*cellHit.GetVolume());
+        // cellHit.Print();
       }
     }
   }
+  // Don't keep empty one, the sensitive detectors might not be defined yet
+  if(!hashed_map_scoring.empty()){
+    hashed_map_scoring.BuildDirectIndex(); // the layout is complete, see ControlPoint::FillEventCollection
+    m_hashed_scoring_map_template[template_name] = hashed_map_scoring;
+  }
   return hashed_map_scoring;
 }
 
@@ -57,7 +57,7 @@ class D3DDetector : public VPatient, public GeoComponet {
     void ExportLayerPads(const std::string& path_to_output_dir) const;
 
     //
-    std::map<std::size_t, VoxelHit> GetScoringHashedMap(const G4String& scoring_name,Scoring::Type type) const override;
+    VoxelHitMap GetScoringHashedMap(const G4String& scoring_name,Scoring::Type type) const override;
     //
     class Config {
       public:
@@ -127,8 +127,8 @@ class D3DDetector : public VPatient, public GeoComponet {
     ///
     void ReadCellsInLayersPositioning();
 
-    ///
-    static std::map<std::string, std::map<std::size_t, VoxelHit>> m_hashed_scoring_map_template; 
+    /// Scoring template per run collection and scoring type, built once and copied for each run
+    static std::map<std::string, VoxelHitMap> m_hashed_scoring_map_template;
 };
 
 #endif  // D3D_MODULE_HH
@@ -9,7 +9,7 @@
 #include "IPhysicalVolume.hh"
 #include "TomlConfigModule.hh"
 #include "Logable.hh"
-#include "VoxelHit.hh"
+#include "VoxelHitMap.hh"
 #include <map>
 
 class VPatientSD;
@@ -53,14 +53,14 @@ class VPatient : public IPhysicalVolume, public TomlConfigModule, public Logable
     G4ThreeVector GetPatientTopPositionInWolrdEnv() {return m_patient_top_position_in_world_env; }
 
     /// TO BE DELETED
-    virtual std::map<std::size_t, VoxelHit> GetScoringHashedMap(const std::string& name, bool voxelised) const {
-      return std::map<std::size_t, VoxelHit>();
+    virtual VoxelHitMap GetScoringHashedMap(const std::string& name, bool voxelised) const {
+      return VoxelHitMap();
     }
     VPatientSD* GetSD() const { return m_patientSD.Get(); }
 
-    virtual std::map<std::size_t, VoxelHit> GetScoringHashedMap(const G4String&,Scoring::Type) const {
+    virtual VoxelHitMap GetScoringHashedMap(const G4String&,Scoring::Type) const {
       LOGSVC_WARN("Returning empty scoring hashed map!");
-      return std::map<std::size_t, VoxelHit>();
+      return VoxelHitMap();
     }
 
 
@@ -1,12 +1,24 @@
 #include "G4SDManager.hh"
+#include "G4PhysicalConstants.hh"
 #include "VPatientSD.hh"
 #include "VPatient.hh"
 #include "Services.hh"
 #include <string>
+#include <cmath>
+#include <algorithm>
 #include "PatientTrackInfo.hh"
 #include "PrimaryParticleInfo.hh"
 #include "NTupleEventAnalisys.hh"
 
+namespace {
+  // The scoring volume range and the step position are compared at the precision of 1e-8 mm,
+  // see VPatientSD::SetScoringVolume and ScoringVolume::IsInside
+  const G4double LocatorScale = 1e8;
+
+  // The PTW 30013 (Farmer) chamber cavity radius [mm]
+  const G4double Farmer30013Radius = 3.05;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 ///
 VPatientSD::VPatientSD(const G4String& sdName):G4VSensitiveDetector(sdName),Logable("GeoAndScoring"){}
@@ -44,6 +56,7 @@ void VPatientSD::AddScoringVolume(const G4String& runCollName, const G4String& h
   AddHitsCollection(runCollName,hitsCollName);
   SetScoringParameterization(hitsCollName,scoringNX,scoringNY,scoringNZ);
   SetScoringVolume(hitsCollName,scoringBox,translation);
+  m_dense_scoring = Service<ConfigSvc>()->GetValue<bool>("RunSvc", "DenseScoring");
   if (Service<ConfigSvc>()->GetValue<bool>("RunSvc", "NTupleAnalysis")){
     auto isVoxelised = false;
     if(scoringNX > 1 || scoringNY > 1 ||scoringNZ > 1)
@@ -118,6 +131,8 @@ bool VPatientSD::ScoringVolume::operator == (const ScoringVolume& other){
 /// This method is being called at beginning of event
 void VPatientSD::Initialize(G4HCofThisEvent* hCofThisEvent){
 
+  if(!m_dispatch_initialized)
+    InitializeDispatch();
   InitializeChannelsID();
   auto sdManager = G4SDManager::GetSDMpointer();
 
@@ -137,6 +152,28 @@ void VPatientSD::Initialize(G4HCofThisEvent* hCofThisEvent){
 
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// It may happen that there is more instances of this SD type, hence the run hits
+/// collections existing independent from this SD geometry - only the own ones are taken.
+void VPatientSD::InitializeDispatch(){
+  m_dispatch_volumes.clear();
+  auto hcNames = ControlPoint::GetHitCollectionNames();
+  for(const auto& i_sd : m_scoring_volumes){
+    if(hcNames.find(i_sd.first) != hcNames.end())
+      m_dispatch_volumes.emplace_back(i_sd.second.get());
+  }
+  m_step_analysis = Service<ConfigSvc>()->GetValue<bool>("RunSvc", "StepAnalysis");
+  m_dispatch_initialized = true;
+  LOGSVC_DEBUG("{}:: {} scoring volume(s) resolved for the steps dispatch",GetName(),m_dispatch_volumes.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+void VPatientSD::ProcessScoringVolumes(G4Step* aStep){
+  for(auto scoringVolumePtr : m_dispatch_volumes)
+    ProcessHitsCollection(scoringVolumePtr,aStep);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 ///
 std::vector<G4String> VPatientSD::GetScoringVolumeNames() const{
@@ -155,6 +192,7 @@ void VPatientSD::SetScoringParameterization(const G4String& hitsCollName, int nX
   scoring_sd->m_nVoxelsX = nX;
   scoring_sd->m_nVoxelsY = nY;
   scoring_sd->m_nVoxelsZ = nZ; 
+  scoring_sd->InitializeLocator();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -273,6 +311,16 @@ G4String VPatientSD::GetScoringHcName(G4int hitsCollId) const {
 ///
 void VPatientSD::InitializeChannelsID(){
   for(const auto& i_sd : m_scoring_volumes){
+    if(IsDenseScoring()){
+      auto& sv = i_sd.second;
+      if(sv->m_denseSlot.empty()){
+        auto max_unique_index = static_cast<std::size_t>(sv->LinearizeIndex(sv->m_nVoxelsX,sv->m_nVoxelsY,sv->m_nVoxelsZ));
+        sv->m_denseSlot.assign(max_unique_index,-1);
+        sv->m_denseMass.assign(max_unique_index,0.);
+      } else // only in case the previous event has not been terminated properly
+        sv->ResetDenseAccumulator();
+      continue; // the hit collection index is not used in the dense mode, no need to reset it
+    }
     auto& channelHCollectionIndex = i_sd.second->m_channelHCollectionIndex;
     if(channelHCollectionIndex.empty()) {
       auto nvX  = i_sd.second->m_nVoxelsX;
@@ -290,19 +338,70 @@ void VPatientSD::InitializeChannelsID(){
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-///
-void VPatientSD::EndOfEvent(G4HCofThisEvent* hCofThisEvent){}
+/// In the dense scoring mode the hits are created here, once per touched voxel,
+/// hence the downstream (ControlPoint, analysis) sees the same per-voxel edep/dose.
+void VPatientSD::EndOfEvent(G4HCofThisEvent* hCofThisEvent){
+  if(!IsDenseScoring())
+    return;
+  for(const auto& i_sd : m_scoring_volumes){
+    auto scoringVolumePtr = i_sd.second.get();
+    auto voxelVolume = scoringVolumePtr->GetVoxelVolume();
+    for(const auto& voxel : scoringVolumePtr->m_denseVoxels){
+      G4int voxelIdX, voxelIdY, voxelIdZ;
+      scoringVolumePtr->DelinearizeIndex(voxel.m_voxelId,voxelIdX,voxelIdY,voxelIdZ);
+      auto voxelHit = new VoxelHit();
+      voxelHit->SetVolume(voxelVolume);
+      voxelHit->SetMass(scoringVolumePtr->m_denseMass[voxel.m_voxelId]);
+      voxelHit->SetCentre(scoringVolumePtr->GetVoxelCentre(voxel.m_voxelId));
+      voxelHit->SetId(voxelIdX, voxelIdY, voxelIdZ);
+      voxelHit->SetGlobalId(m_id_x, m_id_y, m_id_z);
+      voxelHit->SetGlobalCentre(GetSDCentre());
+      voxelHit->SetGravCentre(voxel.m_gravCentre);
+      voxelHit->SetPrimary(voxel.m_primaryId, voxel.m_primaryEnergy);
+      voxelHit->SetEnergyDeposit(voxel.m_edep, voxel.m_stepsEdep);
+      voxelHit->FillPrimaryParticleUserInfo<PrimaryParticleInfo>();
+      scoringVolumePtr->m_voxelHCollectionPtr->insert(voxelHit);
+    }
+    scoringVolumePtr->ResetDenseAccumulator();
+  }
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 ///
 void VPatientSD::SetScoringShape(const G4String& hitsCollName, const G4String& shapeName){
   auto scoringVolume = GetScoringVolumePtr(hitsCollName);
-  if(shapeName!="Farmer30013" && shapeName!="Farmer30013ScanZBox" ){
-    G4String msg = "SetScoringShape:: "+shapeName+" is not found. Available shape: Farmer30013";
+  if(shapeName!="Farmer30013" && shapeName!="Farmer30013ScanZBox" && shapeName!="Cylinder"){
+    G4String msg = "SetScoringShape:: "+shapeName+" is not found. Available shapes: Farmer30013, Farmer30013ScanZBox, Cylinder";
     LOGSVC_CRITICAL("{}. Verify your input!", msg);
     G4Exception("VPatientSD", msg, FatalException,"Verify your input!");
   }
   scoringVolume->m_shape = shapeName;
+  if(shapeName=="Farmer30013"){ // the chamber axis along X
+    scoringVolume->m_cylinderAxis = 0;
+    scoringVolume->m_cylinderRadius = Farmer30013Radius;
+  }
+  else if(shapeName=="Cylinder" && scoringVolume->m_cylinderRadius <= 0.){
+    // not set by SetScoringCylinder: inscribed in the envelope box, along the current axis
+    const G4double size[3] = {scoringVolume->GetSizeX(), scoringVolume->GetSizeY(), scoringVolume->GetSizeZ()};
+    auto axis = scoringVolume->m_cylinderAxis;
+    scoringVolume->m_cylinderRadius = std::min(size[(axis+1)%3], size[(axis+2)%3]) / 2.;
+  }
+  scoringVolume->InitializeLocator();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+void VPatientSD::SetScoringCylinder(const G4String& hitsCollName, G4int axisId, G4double radius){
+  auto scoringVolume = GetScoringVolumePtr(hitsCollName);
+  if(axisId < 0 || axisId > 2 || radius <= 0.){
+    G4String msg = "SetScoringCylinder:: "+hitsCollName+" invalid cylinder: axis="+std::to_string(axisId)+", radius="+std::to_string(radius);
+    LOGSVC_CRITICAL("{}. Verify your input!", msg);
+    G4Exception("VPatientSD", msg, FatalException,"Verify your input!");
+  }
+  scoringVolume->m_shape = "Cylinder";
+  scoringVolume->m_cylinderAxis = axisId;
+  scoringVolume->m_cylinderRadius = radius;
+  scoringVolume->InitializeLocator();
 }
 
 
@@ -337,6 +436,7 @@ void VPatientSD::SetScoringVolume(G4int scoringSdIdx, const G4Box& envelopBox, c
   LOGSVC_DEBUG("VPatientSD:: Voxelized SD range x {} - {}", sdHColPtr->m_rangeMinX, sdHColPtr->m_rangeMaxX);
   LOGSVC_DEBUG("VPatientSD:: Voxelized SD range y {} - {}", sdHColPtr->m_rangeMinY, sdHColPtr->m_rangeMaxY);
   LOGSVC_DEBUG("VPatientSD:: Voxelized SD range z {} - {}",sdHColPtr->m_rangeMinZ,sdHColPtr->m_rangeMaxZ);
+  sdHColPtr->InitializeLocator();
 
 
   //G4cout << "[DEBUG]:: VPatientSD:: Defined Collection: " << hcName << G4endl;
@@ -387,6 +487,47 @@ G4int VPatientSD::ScoringVolume::LinearizeIndex(int idX, int idY, int idZ) const
     return (idX * m_nVoxelsY + idY) * m_nVoxelsZ + idZ;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+///
+void VPatientSD::ScoringVolume::DelinearizeIndex(G4int linearizedId, G4int& idX, G4int& idY, G4int& idZ) const {
+    idZ = linearizedId % m_nVoxelsZ;
+    idY = (linearizedId / m_nVoxelsZ) % m_nVoxelsY;
+    idX = linearizedId / (m_nVoxelsZ * m_nVoxelsY);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+void VPatientSD::ScoringVolume::DenseAccumulate(G4int linearizedId, G4Step* aStep){
+  auto preStepPoint = aStep->GetPreStepPoint();
+  auto& slot = m_denseSlot[linearizedId];
+  if(slot < 0){ // first hit of this voxel in the current event, see VoxelHit::Fill
+    slot = static_cast<G4int>(m_denseVoxels.size());
+    auto& voxel = m_denseVoxels.emplace_back();
+    voxel.m_voxelId = linearizedId;
+  }
+  auto& mass = m_denseMass[linearizedId];
+  if(mass == 0.) // the voxel mass template, see VoxelHit::Fill
+    mass = preStepPoint->GetMaterial()->GetDensity() * GetVoxelVolume();
+  auto& voxel = m_denseVoxels[slot];
+  if(voxel.m_primaryId < 0){ // until the particle type is recognized, as VoxelHit::Fill does
+    voxel.m_primaryId = VoxelHit::GetTrkType(aStep);
+    voxel.m_primaryEnergy = preStepPoint->GetKineticEnergy();
+  }
+  VoxelHit::UpdateGravCentre(voxel.m_gravCentre, preStepPoint->GetPosition());
+  auto edep = aStep->GetTotalEnergyDeposit();
+  voxel.m_edep += edep;
+  if(edep > 0.) // don't count the zero deposit steps
+    voxel.m_stepsEdep.Add(edep);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+void VPatientSD::ScoringVolume::ResetDenseAccumulator(){
+  for(const auto& voxel : m_denseVoxels)
+    m_denseSlot[voxel.m_voxelId] = -1;
+  m_denseVoxels.clear();
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 ///
 G4ThreeVector VPatientSD::ScoringVolume::GetVoxelCentre(int idX, int idY, int idZ) const {
@@ -433,10 +574,6 @@ G4int VPatientSD::ScoringVolume::GetVoxelID(G4int axisId, const G4ThreeVector& h
     }
     else {
       id = int(std::floor(nVoxels * (x - min) / (max - min) ));
-      if(x<=min){
-      G4cout << "max " << max << G4endl;
-      G4cout << "min " << min << G4endl<<G4endl;
-      }
       if(id==nVoxels) --id; // for exact edge hit, it happens!
     }
     return id;
@@ -462,26 +599,100 @@ G4int VPatientSD::ScoringVolume::GetVoxelID(G4int axisId, const G4ThreeVector& h
 ////////////////////////////////////////////////////////////////////////////////
 /// 
 G4int VPatientSD::ScoringVolume::GetLinearizedVoxelID(const G4ThreeVector& hitPosition)  const {
-  auto idX = GetVoxelID(0, hitPosition);
-  auto idY = GetVoxelID(1, hitPosition);
-  auto idZ = GetVoxelID(2, hitPosition);
+  G4int idX, idY, idZ;
+  G4bool onBorder;
+  if(Locate(hitPosition, idX, idY, idZ, onBorder))
+    return LinearizeIndex(idX,idY,idZ);
+  // out of range: clamped and warned
+  idX = GetVoxelID(0, hitPosition);
+  idY = GetVoxelID(1, hitPosition);
+  idZ = GetVoxelID(2, hitPosition);
   return LinearizeIndex(idX,idY,idZ);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+///
+void VPatientSD::ScoringVolume::InitializeLocator(){
+  m_locatorShape = (m_shape=="Farmer30013" || m_shape=="Cylinder") ? Shape::Cylinder : Shape::Box;
+  const G4double min[3] = {m_rangeMinX, m_rangeMinY, m_rangeMinZ};
+  const G4double max[3] = {m_rangeMaxX, m_rangeMaxY, m_rangeMaxZ};
+  const G4int nVoxels[3] = {m_nVoxelsX, m_nVoxelsY, m_nVoxelsZ};
+  for(int i = 0; i < 3; ++i){
+    m_locatorMin[i] = min[i];
+    m_locatorMax[i] = max[i];
+    m_locatorScaledMin[i] = std::round(min[i] * LocatorScale); // the range is already rounded, hence it's an exact integer
+    m_locatorScaledMax[i] = std::round(max[i] * LocatorScale);
+    m_locatorNVoxels[i] = nVoxels[i];
+    m_locatorRange[i] = max[i] - min[i];
+    m_locatorMaxId[i] = nVoxels[i] > 0 ? nVoxels[i] - 1 : 0;
+  }
+
+  // Cylinder: centred in the plane transverse to the axis
+  for(int i = 0; i < 2; ++i){
+    auto axis = (m_cylinderAxis + 1 + i) % 3;
+    m_cylinderTransverse[i] = axis;
+    m_cylinderCentre[i] = (min[axis] + max[axis]) / 2.;
+  }
+  m_cylinderRadius2 = m_cylinderRadius * m_cylinderRadius;
+
+  // Note: the Farmer30013 (whole chamber) and Farmer30013ScanZBox (not defined) values are kept
+  // as they have been, they are used by the dose normalization
+  m_voxelVolume = 0.;
+  if(m_envelopeBoxPtr && nVoxels[0] > 0 && nVoxels[1] > 0 && nVoxels[2] > 0){
+    const G4double size[3] = {GetSizeX(), GetSizeY(), GetSizeZ()};
+    if(m_shape=="Box")
+      m_voxelVolume = (size[0]/nVoxels[0])*(size[1]/nVoxels[1])*(size[2]/nVoxels[2]);
+    else if(m_shape=="Farmer30013")
+      m_voxelVolume = size[0]*3.14159*Farmer30013Radius*Farmer30013Radius;
+    else if(m_shape=="Cylinder")
+      m_voxelVolume = CLHEP::pi * m_cylinderRadius2 * size[m_cylinderAxis] / nVoxels[m_cylinderAxis];
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// The IsInside and IsOnBorder comparisons of the rounded position against the rounded range
+/// are performed on the scaled (integer valued) numbers, which is exact, hence the edge semantics
+/// are kept. The voxel id is evaluated with the very GetVoxelID expression (not with the inverse pitch,
+/// which may move the internal voxel edge hits to the next voxel), clamped to [0,nVoxels-1],
+/// i.e. the exact max edge hit gets the last voxel.
+/// The cylinder test is done on the squared radius (no sqrt).
+G4bool VPatientSD::ScoringVolume::Locate(const G4ThreeVector& position, G4int& idX, G4int& idY, G4int& idZ, G4bool& onBorder) const {
+  const G4double pos[3] = {position.x(), position.y(), position.z()};
+  G4int id[3];
+  G4bool inside = true;
+  G4bool border = false;
+  for(int i = 0; i < 3; ++i){
+    auto scaled = std::round(pos[i] * LocatorScale);
+    auto scaledAbs = std::fabs(scaled);
+    inside = inside & (scaled > m_locatorScaledMin[i]) & (scaled < m_locatorScaledMax[i]);
+    border = border | (scaledAbs == std::fabs(m_locatorScaledMin[i])) | (scaledAbs == std::fabs(m_locatorScaledMax[i]));
+    auto t = m_locatorNVoxels[i] * (pos[i] - m_locatorMin[i]) / m_locatorRange[i];
+    id[i] = static_cast<G4int>(std::fmin(std::fmax(t, 0.), m_locatorMaxId[i]));
+  }
+  if(m_locatorShape == Shape::Cylinder){
+    auto axis = m_cylinderAxis;
+    auto u = pos[m_cylinderTransverse[0]] - m_cylinderCentre[0];
+    auto v = pos[m_cylinderTransverse[1]] - m_cylinderCentre[1];
+    inside = (pos[axis] >= m_locatorMin[axis]) & (pos[axis] < m_locatorMax[axis]) & (u*u + v*v <= m_cylinderRadius2);
+  }
+  idX = id[0];
+  idY = id[1];
+  idZ = id[2];
+  onBorder = border;
+  return inside;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 ///
 G4bool VPatientSD::ScoringVolume::IsInside(const G4ThreeVector& position) const {
-  if(m_shape=="Box" || m_shape=="Farmer30013ScanZBox"){
+  if(m_locatorShape == Shape::Box){
     auto pos = svc::round_with_prec(position,8);
     G4bool inX = ( pos.x() > m_rangeMinX && pos.x() < m_rangeMaxX );
     G4bool inY = ( pos.y() > m_rangeMinY && pos.y() < m_rangeMaxY );
     G4bool inZ = ( pos.z() > m_rangeMinZ && pos.z() < m_rangeMaxZ );
     return inX && inY && inZ;
   }
-  else if (m_shape=="Farmer30013"){
-    return IsInsideFarmer30013(position);
-  }
-  return false;
+  return IsInsideCylinder(position);
 }
 
 G4bool VPatientSD::ScoringVolume::IsOnBorder(const G4ThreeVector& position) const {
@@ -493,28 +704,22 @@ G4bool VPatientSD::ScoringVolume::IsOnBorder(const G4ThreeVector& position) cons
     return inBorder;
   }
 
+////////////////////////////////////////////////////////////////////////////////
+/// Precomputed in InitializeLocator()
 G4double VPatientSD::ScoringVolume::GetVoxelVolume() const{
-  if(m_shape=="Box"){
-    return (GetSizeX()/m_nVoxelsX)*(GetSizeY()/m_nVoxelsY)*(GetSizeZ()/m_nVoxelsZ);
-  }
-  else if (m_shape=="Farmer30013"){
-    G4double farmerR = 3.05;
-    return GetSizeX()*3.14159*farmerR*farmerR;
-  }
-  return 0.;
+  return m_voxelVolume;
 }
 
-
 ////////////////////////////////////////////////////////////////////////////////
 ///
-G4bool VPatientSD::ScoringVolume::IsInsideFarmer30013(const G4ThreeVector& position) const {
-  G4bool inX = ( position.x() >= m_rangeMinX) && (position.x() < m_rangeMaxX);
-  G4double farmerR = 3.05;
-  G4double relativeY = (position.y() - (m_rangeMinY + m_rangeMaxY)/2.);
-  G4double relativeZ = (position.z() - (m_rangeMinZ + m_rangeMaxZ)/2.);
-  G4double possitionR = std::sqrt((relativeY*relativeY)+(relativeZ*relativeZ));
-  G4bool inR = (possitionR <= farmerR);
-  return inX && inR;
+G4bool VPatientSD::ScoringVolume::IsInsideCylinder(const G4ThreeVector& position) const {
+  const G4double pos[3] = {position.x(), position.y(), position.z()};
+  auto axis = m_cylinderAxis;
+  G4bool inAxis = ( pos[axis] >= m_locatorMin[axis]) && (pos[axis] < m_locatorMax[axis]);
+  G4double relativeU = pos[m_cylinderTransverse[0]] - m_cylinderCentre[0];
+  G4double relativeV = pos[m_cylinderTransverse[1]] - m_cylinderCentre[1];
+  G4bool inR = (relativeU*relativeU + relativeV*relativeV <= m_cylinderRadius2);
+  return inAxis && inR;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -526,10 +731,16 @@ G4ThreeVector VPatientSD::GetSDCentre() const {
 ////////////////////////////////////////////////////////////////////////////////
 ///
 void VPatientSD::ProcessHitsCollection(const G4String& hitsCollectionName, G4Step* aStep){
+    ProcessHitsCollection(GetScoringVolumePtr(hitsCollectionName),aStep);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+void VPatientSD::ProcessHitsCollection(ScoringVolume* scoringVolumePtr, G4Step* aStep){
     auto position = aStep->GetPreStepPoint()->GetPosition(); // in world volume frame;
-    auto scoringVolumePtr = GetScoringVolumePtr(hitsCollectionName);
-    auto inScoringVolume = scoringVolumePtr->IsInside(position);
-    auto isOnBorder = scoringVolumePtr->IsOnBorder(position);
+    G4int voxelIdX, voxelIdY, voxelIdZ;
+    G4bool isOnBorder;
+    auto inScoringVolume = scoringVolumePtr->Locate(position, voxelIdX, voxelIdY, voxelIdZ, isOnBorder);
 
     if (!inScoringVolume || (isOnBorder && ((aStep->GetTotalEnergyDeposit())==0.))) return; // Nothing to do for this HC
 
@@ -537,11 +748,16 @@ void VPatientSD::ProcessHitsCollection(const G4String& hitsCollectionName, G4Ste
     //if (edep == 0.) return false;
     // ________________________________________________________________
     // Accumulate data from all steps in this event per volume/local channel.
-    auto voxelIdX = scoringVolumePtr->GetVoxelID(0, position);
-    auto voxelIdY = scoringVolumePtr->GetVoxelID(1, position);
-    auto voxelIdZ = scoringVolumePtr->GetVoxelID(2, position);
     auto voxelId =  scoringVolumePtr->LinearizeIndex(voxelIdX,voxelIdY,voxelIdZ);
 
+    if(IsDenseScoring()){
+      if(voxelId>=0 && voxelId < scoringVolumePtr->m_denseSlot.size())
+        scoringVolumePtr->DenseAccumulate(voxelId,aStep);
+      else
+        LOGSVC_DEBUG("Out of scope ChannelId: {}. Max voxel ID is: {}.",voxelId,scoringVolumePtr->m_denseSlot.size()-1);
+      return;
+    }
+
     if(voxelId>=0 && voxelId < scoringVolumePtr->m_channelHCollectionIndex.size() ) {
       if (scoringVolumePtr->m_channelHCollectionIndex[voxelId] == -1) { // This is new hit within given volume/channel
         
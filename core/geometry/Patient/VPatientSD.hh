@@ -22,11 +22,27 @@ class G4Box;
 class VPatientSD : public G4VSensitiveDetector, public Logable {
     public:
       class ScoringVolume: public Logable {
-        private:
-          ///
-          G4bool IsInsideFarmer30013(const G4ThreeVector& position) const;
+        public:
+          /// The scoring shape compiled from the m_shape name, see InitializeLocator()
+          enum class Shape { Box, Cylinder };
 
+        private:
           ///
+          G4bool IsInsideCylinder(const G4ThreeVector& position) const;
+
+          /// Voxel locator constants, see InitializeLocator()
+          Shape m_locatorShape = Shape::Box;
+          G4double m_locatorMin[3] = {0.,0.,0.};
+          G4double m_locatorMax[3] = {0.,0.,0.};
+          G4double m_locatorScaledMin[3] = {0.,0.,0.}; // range in units of the rounding precision
+          G4double m_locatorScaledMax[3] = {0.,0.,0.};
+          G4double m_locatorNVoxels[3] = {0.,0.,0.};
+          G4double m_locatorRange[3] = {0.,0.,0.}; // max - min
+          G4double m_locatorMaxId[3] = {0.,0.,0.};
+          G4int m_cylinderTransverse[2] = {1,2}; // the axes perpendicular to the cylinder axis
+          G4double m_cylinderCentre[2] = {0.,0.}; // in the transverse axes
+          G4double m_cylinderRadius2 = 0.;
+          G4double m_voxelVolume = 0.;
 
         public:
           ScoringVolume():Logable("GeoAndScoring"){}
@@ -71,8 +87,43 @@ class VPatientSD : public G4VSensitiveDetector, public Logable {
           /// Linearized channel (nVoxels) hit collection index (defined for X * Y * Z)
           std::vector<G4int> m_channelHCollectionIndex;
 
+          /// Dense scoring mode: the steps of the event summed up per voxel, the record keeps
+          /// what VoxelHit::Fill/Update would (but the tracks, see IsDenseScoring)
+          struct DenseVoxel {
+            G4int m_voxelId = -1;
+            G4double m_edep = 0.;
+            RunningStats m_stepsEdep;
+            G4ThreeVector m_gravCentre{0.,0.,0.};
+            G4int m_primaryId = -1;
+            G4double m_primaryEnergy = 0.;
+          };
+
+          /// Dense scoring mode: linearized voxel index -> its record in m_denseVoxels (-1 - not touched in this event)
+          std::vector<G4int> m_denseSlot;
+
+          /// Dense scoring mode: the records of the voxels touched within the event (in order of the first hit)
+          std::vector<DenseVoxel> m_denseVoxels;
+
+          /// Dense scoring mode: linearized voxel index -> its mass, set once the voxel is touched for the first time
+          /// and kept for the whole job (0 - not known yet), hence it doesn't depend on the event's first step
+          std::vector<G4double> m_denseMass;
+
           ///
-          G4String m_shape = "Box"; // or Farmer30013
+          void DenseAccumulate(G4int linearizedId, G4Step* aStep);
+
+          /// Clear only the voxels touched within the event
+          void ResetDenseAccumulator();
+
+          ///
+          G4String m_shape = "Box"; // or Farmer30013, Farmer30013ScanZBox, Cylinder
+
+          /// Cylinder shape: the axis (0,1,2 -> X,Y,Z) and the radius, the cylinder spans
+          /// the envelope box along the axis and is centred in the transverse plane
+          G4int m_cylinderAxis = 0;
+          G4double m_cylinderRadius = 0.;
+
+          ///
+          Shape GetShape() const { return m_locatorShape; }
 
           /// axisId = 0,1,2 -> X,Y,Z
           G4int GetVoxelID(G4int axisId, const G4ThreeVector& hitPosition)  const;
@@ -83,10 +134,21 @@ class VPatientSD : public G4VSensitiveDetector, public Logable {
           ///
           G4int LinearizeIndex(int idX, int idY, int idZ) const;
 
+          ///
+          void DelinearizeIndex(G4int linearizedId, G4int& idX, G4int& idY, G4int& idZ) const;
+
           ///
           G4bool IsInside(const G4ThreeVector& position) const;
           G4bool IsOnBorder(const G4ThreeVector& position) const;
 
+          /// Compile the shape and precompute the inverse voxel pitch, the scaled range, the cylinder
+          /// centre and r^2 and the voxel volume; to be called whenever the range, voxelization or shape is changed
+          void InitializeLocator();
+
+          /// IsInside, IsOnBorder and GetVoxelID for all axes in one pass, without pow/divide;
+          /// the voxel ids are valid only if the position is inside
+          G4bool Locate(const G4ThreeVector& position, G4int& idX, G4int& idY, G4int& idZ, G4bool& onBorder) const;
+
           bool operator == (const ScoringVolume& other);
 
           ///
@@ -96,6 +158,14 @@ class VPatientSD : public G4VSensitiveDetector, public Logable {
   private:
       ///
       void InitializeChannelsID();
+
+      /// Resolve the scoring volumes being fed with the steps of this SD (once per SD instance)
+      void InitializeDispatch();
+
+      /// The scoring volumes of this SD that belong to the registered run hits collections,
+      /// resolved at the first event initialization, hence no name lookup is done per step
+      std::vector<ScoringVolume*> m_dispatch_volumes;
+      bool m_dispatch_initialized = false;
       
       ///
       bool IsHitsCollectionExist(const G4String& hitsCollName) const;
@@ -110,7 +180,7 @@ class VPatientSD : public G4VSensitiveDetector, public Logable {
       ///
       void SetScoringVolume(G4int scoringSdIdx, const G4Box& envelopBox, const G4ThreeVector& translation);
 
-      ///
+      /// Farmer30013, Farmer30013ScanZBox or Cylinder (see SetScoringCylinder, otherwise inscribed in the box)
       void SetScoringShape(const G4String& hitsCollName, const G4String& shapeName);
 
 
@@ -134,6 +204,15 @@ class VPatientSD : public G4VSensitiveDetector, public Logable {
       ///
       bool m_tracks_analysis = false;
 
+      /// Accumulate edep in flat per-thread arrays and create hits at the end of event only
+      bool m_dense_scoring = false;
+
+      /// Dense scoring is not applicable once the per-step tracks information is requested
+      bool IsDenseScoring() const { return m_dense_scoring && !m_tracks_analysis; }
+
+      /// RunSvc StepAnalysis flag, resolved along with the dispatch list
+      bool m_step_analysis = false;
+
   public:
 
     ///
@@ -172,9 +251,15 @@ class VPatientSD : public G4VSensitiveDetector, public Logable {
     ///
     void SetScoringParameterization(const G4String& hitsCollName, int nX, int nY, int nZ);
 
+    /// Score within the cylinder of the given radius inscribed in the scoring volume box along the given axis
+    void SetScoringCylinder(const G4String& hitsCollName, G4int axisId, G4double radius);
+
     ///
     void SetTracksAnalysis(bool flag) { m_tracks_analysis = flag; }
 
+    ///
+    void SetDenseScoring(bool flag) { m_dense_scoring = flag; }
+
     ///
     ScoringVolume* GetRunCollectionReferenceScoringVolume(const G4String& runCollName, bool voxelisation_check = false) const;
 
@@ -194,6 +279,13 @@ class VPatientSD : public G4VSensitiveDetector, public Logable {
 
     ///
     void ProcessHitsCollection(const G4String& hitsCollectionName, G4Step* aStep);
+    void ProcessHitsCollection(ScoringVolume* scoringVolumePtr, G4Step* aStep);
+
+    /// Feed the given step to all the scoring volumes resolved for this SD
+    void ProcessScoringVolumes(G4Step* aStep);
+
+    ///
+    G4int GetNumberOfDispatchVolumes() const { return m_dispatch_volumes.size(); }
 
 };
 
@@ -6,13 +6,13 @@
 #include "G4SystemOfUnits.hh"
 #include "G4UnitsTable.hh"
 #include <iomanip>
+#include <cmath>
 #include <G4Gamma.hh>
 #include <G4Electron.hh>
 #include <G4Positron.hh>
 #include <G4Neutron.hh>
 #include <G4Proton.hh>
 #include <G4Alpha.hh>
-#include <numeric>
 #include "Services.hh"
 
 G4ThreadLocal G4Allocator<VoxelHit> *VoxelHitAllocator = nullptr;
@@ -34,8 +34,8 @@ void VoxelHit::Fill(G4Step* aStep){
     // Fill energy deposited along G4Step (i.e. ionization)
     auto edep = aStep->GetTotalEnergyDeposit();
     m_Voxel.m_Edep += edep;
-    if (edep>0){ // don't increase the vector size with zeros
-      m_Voxel.m_stepsEdep.emplace_back(edep);
+    if (edep>0){ // don't count the zero deposit steps
+      m_Voxel.m_stepsEdep.Add(edep);
       if(m_Voxel.m_Mass!=0.)
       m_Voxel.m_Dose = (m_Voxel.m_Edep / m_Voxel.m_Mass) / gray;
       else {
@@ -66,8 +66,8 @@ void VoxelHit::Update(G4Step* aStep){
 
   auto edep = aStep->GetTotalEnergyDeposit();
   m_Voxel.m_Edep += edep;
-  if (edep>0){ // don't increase the vector size with zeros
-      m_Voxel.m_stepsEdep.emplace_back(edep);
+  if (edep>0){ // don't count the zero deposit steps
+      m_Voxel.m_stepsEdep.Add(edep);
       if(m_Voxel.m_Mass!=0.)
         m_Voxel.m_Dose = (m_Voxel.m_Edep / m_Voxel.m_Mass) / gray;
       else {
@@ -79,7 +79,7 @@ void VoxelHit::Update(G4Step* aStep){
 
 ////////////////////////////////////////////////////////////////////////////////
 ///
-G4int VoxelHit::GetTrkType(G4Step* aStep) const {
+G4int VoxelHit::GetTrkType(G4Step* aStep) {
   auto dynamic = aStep->GetTrack()->GetDynamicParticle();
   auto trkDef = dynamic->GetDefinition();
   G4int trkType = -1;
@@ -98,19 +98,15 @@ void VoxelHit::FillTrack(G4Step* aStep){
   if(m_tracks_analysis){
     auto aTrack = aStep->GetTrack();
     auto trkID = aTrack->GetTrackID();
-    auto ret = m_Voxel.m_trksId.insert(trkID);
-    auto postStepPoint = aStep->GetPostStepPoint();
-    auto preStepPoint = aStep->GetPreStepPoint();
-      if (ret.second==true) { // new element inserted
-        m_Voxel.m_trksTypeId.emplace_back(GetTrkType(aStep));
-        m_Voxel.m_trksE.emplace_back(aTrack->GetDynamicParticle()->GetKineticEnergy());
-        // m_Voxel.m_trksPotentialE.emplace_back((aTrack->GetDynamicParticle()->GetTotalEnergy())-(aTrack->GetDynamicParticle()->GetKineticEnergy())) (>dla niefotonów)
-        m_Voxel.m_trksTheta.emplace_back(aTrack->GetDynamicParticle()->GetMomentum().theta());
-        m_Voxel.m_trksLength.emplace_back(aTrack->GetTrackLength());
-        m_Voxel.m_trksPosition.emplace_back(preStepPoint->GetPosition());
-      } else {
-        // auto evtGlobalTime = aTrack->GetGlobalTime();
-        auto edep = aStep->GetTotalEnergyDeposit();
+    auto tracks = VoxelHitTracks::Instance();
+      if (tracks->InsertTrack(GetTracksOwner(tracks),trkID)) { // new element inserted
+        auto dynamic = aTrack->GetDynamicParticle();
+        tracks->Append(m_Voxel.m_trks,VoxelHitTracks::Track{trkID,
+                                                            GetTrkType(aStep),
+                                                            dynamic->GetKineticEnergy(),
+                                                            dynamic->GetMomentum().theta(),
+                                                            aTrack->GetTrackLength(),
+                                                            aStep->GetPreStepPoint()->GetPosition()});
       }
       // time: since the beginning of the event
       m_global_time = aTrack->GetGlobalTime();
@@ -152,21 +148,27 @@ void VoxelHit::SetGlobalId(G4int xId, G4int yId, G4int zId) {
 ////////////////////////////////////////////////////////////////////////////////
 ///
 void VoxelHit::SetGravCentre(const G4ThreeVector& position){
+  UpdateGravCentre(m_Voxel.m_GravitationalCentre, position);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+void VoxelHit::UpdateGravCentre(G4ThreeVector& centre, const G4ThreeVector& position){
 
-  if(m_Voxel.m_GravitationalCentre.x()==0.)
-    m_Voxel.m_GravitationalCentre.setX(position.x());
+  if(centre.x()==0.)
+    centre.setX(position.x());
   else
-    m_Voxel.m_GravitationalCentre.setX((position.x()+m_Voxel.m_GravitationalCentre.x())/2.);
+    centre.setX((position.x()+centre.x())/2.);
 
-  if(m_Voxel.m_GravitationalCentre.y()==0.)
-    m_Voxel.m_GravitationalCentre.setY(position.y());
+  if(centre.y()==0.)
+    centre.setY(position.y());
   else
-    m_Voxel.m_GravitationalCentre.setY((position.y()+m_Voxel.m_GravitationalCentre.y())/2.);
+    centre.setY((position.y()+centre.y())/2.);
 
-  if(m_Voxel.m_GravitationalCentre.z()==0.)
-    m_Voxel.m_GravitationalCentre.setZ(position.z());
+  if(centre.z()==0.)
+    centre.setZ(position.z());
   else
-    m_Voxel.m_GravitationalCentre.setZ((position.z()+m_Voxel.m_GravitationalCentre.z())/2.);
+    centre.setZ((position.z()+centre.z())/2.);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -210,80 +212,35 @@ void VoxelHit::Print(){
 
 ////////////////////////////////////////////////////////////////////////////////
 ///
-std::vector<std::pair<G4int,G4double>> VoxelHit::GetTrkEnergy() const {
-  std::vector<std::pair<G4int,G4double>> trkIdE;
-  auto itE = m_Voxel.m_trksE.begin();
-  for (auto itId=m_Voxel.m_trksId.begin(); itId!=m_Voxel.m_trksId.end(); ++itId)
-    trkIdE.emplace_back(*itId,*itE++);
-  return trkIdE;
-}
-
-////////////////////////////////////////////////////////////////////////////////
-///
-std::vector<std::pair<G4int,G4double>> VoxelHit::GetTrkTheta() const {
-  std::vector<std::pair<G4int,G4double>> trkIdTheta;
-  auto itTheta = m_Voxel.m_trksTheta.begin();
-  for (auto itId=m_Voxel.m_trksId.begin(); itId!=m_Voxel.m_trksId.end(); ++itId)
-    trkIdTheta.emplace_back(*itId,*itTheta++);
-  return trkIdTheta;
-}
-
-////////////////////////////////////////////////////////////////////////////////
-///
-std::vector<std::pair<G4int,G4double>> VoxelHit::GetTrkLength() const {
-  std::vector<std::pair<G4int,G4double>> trkIdLength;
-  auto itL = m_Voxel.m_trksLength.begin();
-  for (auto itId=m_Voxel.m_trksId.begin(); itId!=m_Voxel.m_trksId.end(); ++itId)
-    trkIdLength.emplace_back(*itId,*itL++);
-  return trkIdLength;
-}
-
-////////////////////////////////////////////////////////////////////////////////
-///
-std::vector<std::pair<G4int,G4double>> VoxelHit::GetUserTrkLength() const {
-  std::vector<std::pair<G4int,G4double>> trkIdLength;
-  auto itL = m_Voxel.m_usrTrksLength.begin();
-  for (auto itId=m_Voxel.m_usrTrksId.begin(); itId!=m_Voxel.m_usrTrksId.end(); ++itId)
-    trkIdLength.emplace_back(*itId,*itL++);
-  return trkIdLength;
-}
-
-////////////////////////////////////////////////////////////////////////////////
-///
-std::vector<std::pair<G4int,G4ThreeVector>> VoxelHit::GetTrkPosition() const {
-  std::vector<std::pair<G4int,G4ThreeVector>> trkPosition;
-  auto itP = m_Voxel.m_trksPosition.begin();
-  for (auto itId=m_Voxel.m_trksLength.begin(); itId!=m_Voxel.m_trksLength.end(); ++itId)
-    trkPosition.emplace_back(*itId,*itP++);
-  return trkPosition;
-}
-
-////////////////////////////////////////////////////////////////////////////////
-///
-std::vector<std::pair<G4int,G4int>> VoxelHit::GetTrkType() const {
-  std::vector<std::pair<G4int,G4int>> trkTypeId;
-  auto itType = m_Voxel.m_trksTypeId.begin();
-  for (auto itId=m_Voxel.m_trksId.begin(); itId!=m_Voxel.m_trksId.end(); ++itId)
-    trkTypeId.emplace_back(*itId,*itType++);
-  return trkTypeId;
+G4double VoxelHit::GetPrimaryTrkEnergy() const {
+  G4double energy = -1; // No primary in this voxel hit
+  ForEachTrackSpan([&](const VoxelHitTracks::Track* trk, G4int n){
+    for(G4int i = 0; i < n; ++i)
+      if(trk[i].m_id==1) energy = trk[i].m_energy;
+  });
+  return energy;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 ///
-G4double VoxelHit::GetPrimaryTrkEnergy() const {
-  for (auto& iIdE : GetTrkEnergy())
-    if(iIdE.first==1) return iIdE.second;
-  return -1; // No primary in this voxel hit
+G4double VoxelHit::GetMeanEnergyDeposit() const {
+  if(m_Voxel.m_stepsEdep.GetCount()>0)
+    return m_Voxel.m_stepsEdep.GetMean();
+  return -1;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 ///
-G4double VoxelHit::GetMeanEnergyDeposit() const {
-  if(m_Voxel.m_stepsEdep.size()>0){
-    double sum = std::accumulate(m_Voxel.m_stepsEdep.begin(), m_Voxel.m_stepsEdep.end(), 0.0);
-    return sum / m_Voxel.m_stepsEdep.size();
+void VoxelHit::SetEnergyDeposit(G4double edep, const RunningStats& stepsEdep){
+  m_Voxel.m_Edep = edep;
+  m_Voxel.m_stepsEdep = stepsEdep;
+  if (edep>0){
+    if(m_Voxel.m_Mass!=0.)
+      m_Voxel.m_Dose = (m_Voxel.m_Edep / m_Voxel.m_Mass) / gray;
+    else {
+      G4cout << "[WARNING]::VoxelHit::SetEnergyDeposit() The voxel mass is not set!" << G4endl;
+    }
   }
-  return -1;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -296,21 +253,15 @@ void VoxelHit::PrintEvtInfo() const {
 
 ////////////////////////////////////////////////////////////////////////////////
 ///
-std::size_t VoxelHit::GetGlobalHashedStrId() const {
-  return std::hash<std::string>{}(std::to_string(m_Voxel.m_global_idx_x)
-                                  +std::to_string(m_Voxel.m_global_idx_y)
-                                  +std::to_string(m_Voxel.m_global_idx_z) );
+Scoring::Key VoxelHit::GetGlobalPackedId() const {
+  return Scoring::PackKey(m_Voxel.m_global_idx_x, m_Voxel.m_global_idx_y, m_Voxel.m_global_idx_z);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 ///
-std::size_t VoxelHit::GetHashedStrId() const {
-  return std::hash<std::string>{}(std::to_string(m_Voxel.m_global_idx_x)
-                                  +std::to_string(m_Voxel.m_global_idx_y)
-                                  +std::to_string(m_Voxel.m_global_idx_z) 
-                                  +std::to_string(m_Voxel.m_idx_x) 
-                                  +std::to_string(m_Voxel.m_idx_y) 
-                                  +std::to_string(m_Voxel.m_idx_z));
+Scoring::Key VoxelHit::GetPackedId() const {
+  return Scoring::PackKey(m_Voxel.m_global_idx_x, m_Voxel.m_global_idx_y, m_Voxel.m_global_idx_z,
+                          m_Voxel.m_idx_x, m_Voxel.m_idx_y, m_Voxel.m_idx_z);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -348,7 +299,9 @@ VoxelHit& VoxelHit::Cumulate(const VoxelHit& other, bool global_and_local_allign
       // G4cout << "[INFO]::VoxelHit::Cumulate GetVolume(); "<<GetVolume() << G4endl;
 
 
-      m_Voxel.m_Dose += other.GetDose()*other.GetVolume() / GetVolume();
+      m_Voxel.m_Dose += GetDoseContribution(other,false);
+      m_Voxel.m_Dose2 += other.GetDose2();
+      m_Voxel.m_stepsEdep.Merge(other.m_Voxel.m_stepsEdep);
       
       // G4cout << "[INFO]::VoxelHit::Cumulate m_Voxel.m_Dose post summ "<<m_Voxel.m_Dose << G4endl;
 
@@ -369,6 +322,38 @@ VoxelHit& VoxelHit::Cumulate(const VoxelHit& other, bool global_and_local_allign
 VoxelHit& VoxelHit::operator+=(const VoxelHit& other){
   // TODO: m_Voxel.m_Dose+=other.GetDose()*other.GetVolume() / GetVolume(); Tu też? 
   m_Voxel.m_Dose+=other.GetDose();
+  m_Voxel.m_Dose2+=other.GetDose2();
+  m_Voxel.m_stepsEdep.Merge(other.m_Voxel.m_stepsEdep);
   return *this;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+///
+G4double VoxelHit::GetDoseContribution(const VoxelHit& other, bool global_and_local) const {
+  return global_and_local ? other.GetDose() : other.GetDose()*other.GetVolume() / GetVolume();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+VoxelHit& VoxelHit::CumulateHistory(const VoxelHit& other, G4int historyId, bool global_and_local_allignemnt_check){
+  if(IsAligned(other,global_and_local_allignemnt_check)){
+    if(m_Voxel.m_HistoryId != historyId){ // close the previous history
+      m_Voxel.m_Dose2 += m_Voxel.m_HistoryDose * m_Voxel.m_HistoryDose;
+      m_Voxel.m_HistoryDose = 0.;
+      m_Voxel.m_HistoryId = historyId;
+    }
+    m_Voxel.m_HistoryDose += GetDoseContribution(other,global_and_local_allignemnt_check);
+  }
+  return Cumulate(other,global_and_local_allignemnt_check);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+G4double VoxelHit::GetRelativeUncertainty(G4double sum, G4double sum2, G4long nHistories) {
+  if(nHistories < 2 || sum <= 0.)
+    return 1.;
+  auto mean = sum / nHistories;
+  auto variance = (sum2 / nHistories - mean * mean) / (nHistories - 1);
+  return variance > 0. ? std::sqrt(variance) / mean : 0.;
+}
+
@@ -11,9 +11,11 @@
 #include "G4Allocator.hh"
 #include "G4ThreeVector.hh"
 #include <memory>
-#include <set>
 #include "tls.hh"
 #include <G4RunManager.hh>
+#include "Types.hh"
+#include "VoxelHitTracks.hh"
+#include "RunningStats.hh"
 
 class VoxelHit final : public G4VHit {
 
@@ -36,23 +38,23 @@ class VoxelHit final : public G4VHit {
     G4double m_Edep{0.};
     G4double m_Dose{0.};
 
-    /// Energy of the track / particle entering the voxel paired with its ID
+    /// History-by-history dose statistics (run level scoring): the sum of squared
+    /// doses of the closed histories, the dose of the current (open) history and its ID
+    G4double m_Dose2{0.};
+    G4double m_HistoryDose{0.};
+    G4int m_HistoryId = -1;
+
+    /// The tracks / particles entering the voxel, recorded in the per-event VoxelHitTracks arena
     /// It's assumed to keep single trk of given ID (first occurrence)
     /// Note: Primary tracks have a track ID = 1, secondary tracks have an ID > 1
-    std::set<G4int> m_trksId;
-    std::set<G4Track*> m_trksPtr;
-    std::vector<G4int> m_trksTypeId; // 1:G4Gamma, 2:G4Electron, 3:G4Positron, 4:G4Neutron, 5:G4Proton
-    std::vector<G4double> m_trksE;
-    std::vector<G4double> m_trksTheta;
-    std::vector<G4double> m_trksLength;
-    std::vector<G4ThreeVector> m_trksPosition;
-    /// remember history for all steps
-    std::vector<G4double> m_stepsEdep;
+    G4int m_trksOwner = -1;
+    VoxelHitTracks::Chain m_trks;
+    /// running statistics of the (non-zero) steps energy deposit
+    RunningStats m_stepsEdep;
 
 
     /// User custom track's length measure (e.g. start length accumulation within specific volume)
-    std::set<G4int> m_usrTrksId;
-    std::vector<G4double> m_usrTrksLength;
+    VoxelHitTracks::Chain m_usrTrks;
 
     ///
     G4double m_incidentE = 0.;
@@ -88,6 +90,12 @@ class VoxelHit final : public G4VHit {
   ///
   void FillTrack(G4Step* aStep);
 
+  /// The key of this hit records within the tracks arena
+  G4int GetTracksOwner(VoxelHitTracks* tracks) {
+    if(m_Voxel.m_trksOwner < 0) m_Voxel.m_trksOwner = tracks->NewOwner();
+    return m_Voxel.m_trksOwner;
+  }
+
   ///
   void FillEvtInfo();
   
@@ -97,6 +105,9 @@ class VoxelHit final : public G4VHit {
   ///
   VoxelHit& operator+=(const VoxelHit& other);
 
+  /// The dose the other hit contributes to this one
+  G4double GetDoseContribution(const VoxelHit& other, bool global_and_local) const;
+
   public:
   ///
   VoxelHit() = default;
@@ -117,6 +128,10 @@ class VoxelHit final : public G4VHit {
   ///
   VoxelHit& Cumulate(const VoxelHit& other, bool global_and_local_allignemnt_check = true);
 
+  /// Cumulate the other (event) hit as a part of the given history (event ID), the contributions
+  /// of single history are summed up before being squared, see GetDoseRelativeUncertainty
+  VoxelHit& CumulateHistory(const VoxelHit& other, G4int historyId, bool global_and_local_allignemnt_check = true);
+
   ///
   void Draw() override {};
 
@@ -139,6 +154,9 @@ class VoxelHit final : public G4VHit {
   ///
   void SetGravCentre(const G4ThreeVector& position);
 
+  /// The gravitational centre update with the step position (see SetGravCentre)
+  static void UpdateGravCentre(G4ThreeVector& centre, const G4ThreeVector& position);
+
   ///
   void SetVolume(G4double volume) { m_Voxel.m_Volume = volume;}
 
@@ -167,12 +185,31 @@ class VoxelHit final : public G4VHit {
   G4double GetDose() const { return m_Voxel.m_Dose;}
   G4double SetDose(G4double val) { m_Voxel.m_Dose = val; return m_Voxel.m_Dose;}
 
+  /// Sum of the squared histories dose (including the current one)
+  G4double GetDose2() const { return m_Voxel.m_Dose2 + m_Voxel.m_HistoryDose * m_Voxel.m_HistoryDose; }
+
+  /// Relative standard uncertainty of the mean dose per history, 1 if there is no dose scored
+  G4double GetDoseRelativeUncertainty(G4long nHistories) const { return GetRelativeUncertainty(m_Voxel.m_Dose,GetDose2(),nHistories); }
+
+  /// Relative standard uncertainty of the mean, given the sum and the sum of squares of nHistories
+  static G4double GetRelativeUncertainty(G4double sum, G4double sum2, G4long nHistories);
+
   ///
   inline G4double GetEnergyDeposit() const { return m_Voxel.m_Edep; }
 
-  ///
+  /// Mean energy deposit per (non-zero) step, -1 if there were no such steps
   G4double GetMeanEnergyDeposit() const;
 
+  /// Variance of the energy deposit per (non-zero) step
+  G4double GetEnergyDepositVariance() const { return m_Voxel.m_stepsEdep.GetVariance(); }
+
+  ///
+  const RunningStats& GetStepsEnergyDeposit() const { return m_Voxel.m_stepsEdep; }
+
+  /// Set the total (event) energy deposit and its steps statistics at once and recompute dose,
+  /// used by the dense scoring mode
+  void SetEnergyDeposit(G4double edep, const RunningStats& stepsEdep);
+
   ///
   void SetPrimary(G4int fId, G4double fEn){ m_Voxel.m_primaryID = fId; m_Voxel.m_incidentE = fEn; }
 
@@ -182,19 +219,16 @@ class VoxelHit final : public G4VHit {
   ///
   G4int GetPrimaryId() const { return m_Voxel.m_primaryID; }
 
-  ///
-  std::vector<std::pair<G4int,G4double>> GetTrkEnergy() const;
-  std::vector<std::pair<G4int,G4double>> GetTrkTheta() const;
-  std::vector<std::pair<G4int,G4double>> GetTrkLength() const;
-  std::vector<std::pair<G4int,G4double>> GetUserTrkLength() const;
-  std::vector<std::pair<G4int,G4ThreeVector>> GetTrkPosition() const;
-  std::vector<std::pair<G4int,G4int>> GetTrkType() const;
+  /// The tracks entering the voxel in order of the entrance: f(const VoxelHitTracks::Track* begin, G4int n)
+  /// is called for each contiguous span of the records (valid within the current event only)
+  template <typename F> void ForEachTrackSpan(F f) const { VoxelHitTracks::Instance()->ForEachTrackSpan(m_Voxel.m_trks, f); }
+  template <typename F> void ForEachUserTrackSpan(F f) const { VoxelHitTracks::Instance()->ForEachUserTrackSpan(m_Voxel.m_usrTrks, f); }
 
   ///  
   G4double GetPrimaryTrkEnergy() const;
 
   ///
-  inline G4int GetNTrkType() const { return m_Voxel.m_trksId.size(); }
+  inline G4int GetNTrkType() const { return m_Voxel.m_trks.m_size; }
 
   ///
   void Fill(G4Step* aStep);
@@ -203,7 +237,7 @@ class VoxelHit final : public G4VHit {
   void Update(G4Step* aStep);
 
   ///
-  G4int GetTrkType(G4Step* aStep) const;
+  static G4int GetTrkType(G4Step* aStep);
 
   ///
   G4double GetGlobalTime() const { return m_global_time; }
@@ -235,9 +269,9 @@ class VoxelHit final : public G4VHit {
   ///
   G4double GetFieldScalingFactor() const { return m_field_scaling_factor; }
 
-  ///
-  std::size_t GetGlobalHashedStrId() const;
-  std::size_t GetHashedStrId() const;
+  /// Packed (cell) and (cell, voxel) identifiers, see Scoring::PackKey
+  Scoring::Key GetGlobalPackedId() const;
+  Scoring::Key GetPackedId() const;
 
 };
 
@@ -266,12 +300,12 @@ template <typename T> void VoxelHit::FillTrackUserInfo(G4Step* aStep){
   if(m_tracks_analysis){
     auto aTrack = aStep->GetTrack();
     auto trkID = aTrack->GetTrackID();
-    auto ret = m_Voxel.m_usrTrksId.insert(trkID);
-    if (ret.second==true) { // new element inserted
+    auto tracks = VoxelHitTracks::Instance();
+    if (tracks->InsertUserTrack(GetTracksOwner(tracks),trkID)) { // new element inserted
       auto trackInfo = dynamic_cast<T*>(aTrack->GetUserInformation());
       if(trackInfo){
         auto trkLength = trackInfo->GetTrackLength();
-        m_Voxel.m_usrTrksLength.emplace_back(trkLength);
+        tracks->Append(m_Voxel.m_usrTrks,VoxelHitTracks::UserTrack{trkID,trkLength});
       }
     }
   }
@@ -282,15 +316,17 @@ template <typename T> void VoxelHit::FillTrackUserInfo(G4Step* aStep){
 template <typename T> void VoxelHit::FillPrimaryParticleUserInfo(){
 
   if (m_evtPrimariesIncidentE.empty()){ // it should be done only once!
-    auto evt = G4RunManager::GetRunManager()->GetCurrentEvent();
+    auto runManager = G4RunManager::GetRunManager();
+    auto evt = runManager ? runManager->GetCurrentEvent() : nullptr;
+    if(!evt) return; // no event being processed (e.g. the scoring tests)
     auto nvrtx = evt->GetNumberOfPrimaryVertex();
     for (int i=0; i< nvrtx; ++i){
       auto vrtx = evt->GetPrimaryVertex(i);
       auto particle = vrtx->GetPrimary(0);
       if(particle->GetKineticEnergy()>0){
-        auto particleInfo = particle->GetUserInformation();
-        if(particleInfo){
-          m_evtPrimariesIncidentE.emplace_back(dynamic_cast<T*>(particleInfo)->GetInitialTotalEnergy());
+        auto particleInfo = dynamic_cast<T*>(particle->GetUserInformation());
+        if(particleInfo){ // none or not of T type (e.g. a generator not filling it)
+          m_evtPrimariesIncidentE.emplace_back(particleInfo->GetInitialTotalEnergy());
         }
       }
     }
@@ -0,0 +1,118 @@
+#include "VoxelHitMap.hh"
+#include <algorithm>
+#include <stdexcept>
+
+////////////////////////////////////////////////////////////////////////////////
+///
+VoxelHit& VoxelHitMap::Insert(Scoring::Key key, const VoxelHit& hit){
+  if(!m_layout)
+    m_layout = std::make_shared<Layout>();
+  else if(m_layout.use_count()>1) // copy on write, don't modify the layout of the other copies
+    m_layout = std::make_shared<Layout>(*m_layout);
+  m_layout->m_direct.clear();
+
+  auto slot = m_layout->m_slots.find(key);
+  if(slot!=m_layout->m_slots.end()){
+    m_hits[slot->second] = hit;
+    return m_hits[slot->second];
+  }
+  m_layout->m_slots.emplace(key,m_hits.size());
+  m_layout->m_keys.emplace_back(key);
+  m_hits.emplace_back(hit);
+  return m_hits.back();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+void VoxelHitMap::BuildDirectIndex(std::size_t maxFill){
+  if(!m_layout || m_layout->m_keys.empty())
+    return;
+  auto axis = [](Scoring::Key key, int a){ return (key >> (NAXES-1-a)*Scoring::KEY_AXIS_BITS) & Scoring::KEY_AXIS_MASK; };
+  std::array<Scoring::Key,NAXES> min, max;
+  min.fill(Scoring::KEY_AXIS_MASK);
+  max.fill(0);
+  for(auto key : m_layout->m_keys){
+    for(int a=0; a<NAXES; ++a){
+      min[a] = std::min(min[a],axis(key,a));
+      max[a] = std::max(max[a],axis(key,a));
+    }
+  }
+  std::array<Scoring::Key,NAXES> extent;
+  std::array<std::size_t,NAXES> stride;
+  std::size_t volume = 1;
+  for(int a=NAXES-1; a>=0; --a){ // voxel z is the fastest running index, as in the template
+    extent[a] = max[a] - min[a] + 1;
+    stride[a] = volume;
+    volume *= extent[a];
+    if(volume > maxFill * m_layout->m_keys.size())
+      return; // too sparse, the hashed lookup is kept
+  }
+  if(m_layout.use_count()>1) // copy on write, as in Insert
+    m_layout = std::make_shared<Layout>(*m_layout);
+  auto& layout = *m_layout;
+  layout.m_min = min;
+  layout.m_extent = extent;
+  layout.m_stride = stride;
+  layout.m_direct.assign(volume,-1);
+  for(std::size_t slot=0; slot<layout.m_keys.size(); ++slot){
+    std::size_t idx = 0;
+    for(int a=0; a<NAXES; ++a)
+      idx += (axis(layout.m_keys[slot],a) - min[a]) * stride[a];
+    layout.m_direct[idx] = static_cast<std::int32_t>(slot);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+std::int64_t VoxelHitMap::DirectSlot(const Layout& layout, Scoring::Key key){
+  std::size_t idx = 0;
+  for(int a=NAXES-1; a>=0; --a, key >>= Scoring::KEY_AXIS_BITS){
+    auto offset = (key & Scoring::KEY_AXIS_MASK) - layout.m_min[a]; // wraps around below the min
+    if(offset >= layout.m_extent[a])
+      return -1;
+    idx += offset * layout.m_stride[a];
+  }
+  return layout.m_direct[idx];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+VoxelHit* VoxelHitMap::Find(Scoring::Key key){
+  if(!m_layout)
+    return nullptr;
+  if(!m_layout->m_direct.empty()){
+    auto slot = DirectSlot(*m_layout,key);
+    return slot>=0 ? &m_hits[slot] : nullptr;
+  }
+  auto slot = m_layout->m_slots.find(key);
+  return slot!=m_layout->m_slots.end() ? &m_hits[slot->second] : nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+const VoxelHit* VoxelHitMap::Find(Scoring::Key key) const {
+  return const_cast<VoxelHitMap*>(this)->Find(key);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+VoxelHit& VoxelHitMap::at(Scoring::Key key){
+  auto hit = Find(key);
+  if(!hit)
+    throw std::out_of_range("VoxelHitMap::at:: the key "+std::to_string(key)+" is not defined");
+  return *hit;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+const VoxelHit& VoxelHitMap::at(Scoring::Key key) const {
+  return const_cast<VoxelHitMap*>(this)->at(key);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+void VoxelHitMap::clear(){
+  m_hits.clear();
+  m_hits.shrink_to_fit();
+  m_layout.reset();
+}
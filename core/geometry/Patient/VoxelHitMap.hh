@@ -0,0 +1,101 @@
+#ifndef VOXELHITMAP_HH
+#define VOXELHITMAP_HH
+
+#include "VoxelHit.hh"
+#include "Types.hh"
+#include <array>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+///
+///\class VoxelHitMap
+///\brief Flat, vector-backed storage of the scoring volumes hits identified with
+/// the packed (cell, voxel) key. The key-to-slot layout is built once (scoring template)
+/// and shared between all copies, hence copying the map per run/thread copies the hits only.
+/// Once the template is complete (see BuildDirectIndex) the slot is indexed directly
+/// with the unpacked (cell, voxel) indexes, the hashed lookup is the fallback only.
+class VoxelHitMap {
+  private:
+    ///
+    static constexpr int NAXES = 6;
+
+    ///
+    struct Layout {
+      std::vector<Scoring::Key> m_keys;
+      std::unordered_map<Scoring::Key, std::size_t> m_slots;
+
+      /// Slot (or -1) of each point of the keys bounding box, empty if not built
+      std::vector<std::int32_t> m_direct;
+      std::array<Scoring::Key, NAXES> m_min{};
+      std::array<Scoring::Key, NAXES> m_extent{};
+      std::array<std::size_t, NAXES> m_stride{};
+    };
+
+    /// Return -1 for not existing key
+    static std::int64_t DirectSlot(const Layout& layout, Scoring::Key key);
+
+    ///
+    std::vector<VoxelHit> m_hits;
+
+    ///
+    std::shared_ptr<Layout> m_layout;
+
+  public:
+    ///
+    VoxelHitMap() = default;
+
+    ///
+    ~VoxelHitMap() = default;
+
+    /// Add new scoring volume to the layout (building the template only)
+    VoxelHit& Insert(Scoring::Key key, const VoxelHit& hit = VoxelHit());
+
+    /// Index the slots directly over the keys bounding box, unless it's too sparse
+    /// (more than maxFill points per key). To be called once the template is complete,
+    /// the next Insert drops the direct index.
+    void BuildDirectIndex(std::size_t maxFill = 8);
+
+    ///
+    bool HasDirectIndex() const { return m_layout && !m_layout->m_direct.empty(); }
+
+    /// Return nullptr for not existing key
+    VoxelHit* Find(Scoring::Key key);
+    const VoxelHit* Find(Scoring::Key key) const;
+
+    /// Throws std::out_of_range for not existing key (as std::map::at)
+    VoxelHit& at(Scoring::Key key);
+    const VoxelHit& at(Scoring::Key key) const;
+
+    ///
+    VoxelHit& operator[](std::size_t slot) { return m_hits[slot]; }
+    const VoxelHit& operator[](std::size_t slot) const { return m_hits[slot]; }
+
+    ///
+    Scoring::Key GetKey(std::size_t slot) const { return m_layout->m_keys[slot]; }
+
+    /// Both maps are copies of the same template, thus the slots are matching each other
+    bool HasSameLayout(const VoxelHitMap& other) const { return m_layout && m_layout == other.m_layout; }
+
+    ///
+    std::size_t size() const { return m_hits.size(); }
+    bool empty() const { return m_hits.empty(); }
+
+    /// Release the memory (the layout is kept by the other copies if any)
+    void clear();
+
+    ///
+    std::vector<VoxelHit>::iterator begin() { return m_hits.begin(); }
+    std::vector<VoxelHit>::iterator end() { return m_hits.end(); }
+    std::vector<VoxelHit>::const_iterator begin() const { return m_hits.begin(); }
+    std::vector<VoxelHit>::const_iterator end() const { return m_hits.end(); }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+///
+typedef std::map<Scoring::Type, VoxelHitMap> ScoringMap;
+
+#endif //VOXELHITMAP_HH
@@ -0,0 +1,75 @@
+#include "VoxelHitTracks.hh"
+#include <algorithm>
+
+namespace {
+  G4ThreadLocal VoxelHitTracks* theVoxelHitTracks = nullptr;
+
+  /// The initial capacity of the track ID set (power of 2)
+  const std::size_t InitialCapacity = 1024;
+
+  ///
+  inline std::size_t Hash(std::uint64_t key){
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return static_cast<std::size_t>(key);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+VoxelHitTracks* VoxelHitTracks::Instance(){
+  if(!theVoxelHitTracks)
+    theVoxelHitTracks = new VoxelHitTracks();
+  return theVoxelHitTracks;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+void VoxelHitTracks::Reset(){
+  m_tracks.m_used = 0;
+  m_user_tracks.m_used = 0;
+  m_owners = 0;
+  m_count = 0;
+  if(++m_stamp == 0){ // wrapped around, the stale stamps have to be cleared once
+    std::fill(m_stamps.begin(), m_stamps.end(), 0);
+    m_stamp = 1;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+G4bool VoxelHitTracks::Insert(std::uint64_t key){
+  if(2 * (m_count + 1) > m_keys.size())
+    Rehash(std::max(InitialCapacity, 2 * m_keys.size()));
+  auto mask = m_keys.size() - 1;
+  for(auto slot = Hash(key) & mask; ; slot = (slot + 1) & mask){
+    if(m_stamps[slot] != m_stamp){ // empty slot
+      m_keys[slot] = key;
+      m_stamps[slot] = m_stamp;
+      ++m_count;
+      return true;
+    }
+    if(m_keys[slot] == key)
+      return false;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+void VoxelHitTracks::Rehash(std::size_t capacity){
+  std::vector<std::uint64_t> keys(capacity);
+  std::vector<std::uint32_t> stamps(capacity, 0);
+  auto mask = capacity - 1;
+  for(std::size_t i = 0; i < m_keys.size(); ++i){
+    if(m_stamps[i] != m_stamp)
+      continue;
+    auto slot = Hash(m_keys[i]) & mask;
+    while(stamps[slot] == m_stamp)
+      slot = (slot + 1) & mask;
+    keys[slot] = m_keys[i];
+    stamps[slot] = m_stamp;
+  }
+  m_keys.swap(keys);
+  m_stamps.swap(stamps);
+}
@@ -0,0 +1,134 @@
+#ifndef VOXELHITTRACKS_HH
+#define VOXELHITTRACKS_HH
+
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+#include <cstdint>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+/// Per-thread, per-event storage of the tracks analysis records of all the voxel hits.
+/// The records of single hit are chained in fixed size chunks allocated from the arena,
+/// the chunks storage (and the track ID set) capacity is kept between events, hence the
+/// Reset() at the new event is O(1) and no allocation happens once the arena is warmed up.
+/// The content is valid within the current event only.
+class VoxelHitTracks {
+  public:
+  /// The track entering the voxel (first occurrence of the track ID)
+  struct Track {
+    G4int m_id;
+    G4int m_type; // 1:G4Gamma, 2:G4Electron, 3:G4Positron, 4:G4Neutron, 5:G4Proton, 6:G4Alpha
+    G4double m_energy;
+    G4double m_theta;
+    G4double m_length;
+    G4ThreeVector m_position;
+  };
+
+  /// User custom track's length measure (see VoxelHit::FillTrackUserInfo)
+  struct UserTrack {
+    G4int m_id;
+    G4double m_length;
+  };
+
+  /// The records of single voxel hit, first/last are the chunk indexes within the arena
+  struct Chain {
+    G4int m_first = -1;
+    G4int m_last = -1;
+    G4int m_size = 0;
+  };
+
+  ///
+  static VoxelHitTracks* Instance();
+
+  /// Drop all the records and the track IDs, to be called at the beginning of event
+  void Reset();
+
+  /// Unique (within the event) key of the voxel hit records
+  G4int NewOwner() { return m_owners++; }
+
+  /// Returns true if the track ID has not been recorded yet for the given owner
+  G4bool InsertTrack(G4int owner, G4int trkId) { return Insert(MakeKey(owner, trkId, 0)); }
+  G4bool InsertUserTrack(G4int owner, G4int trkId) { return Insert(MakeKey(owner, trkId, 1)); }
+
+  ///
+  void Append(Chain& chain, const Track& record) { Append(m_tracks, chain, record); }
+  void Append(Chain& chain, const UserTrack& record) { Append(m_user_tracks, chain, record); }
+
+  /// Call f(const Track* begin, G4int n) for each contiguous span of the chain records (in order of insertion)
+  template <typename F> void ForEachTrackSpan(const Chain& chain, F f) const { ForEachSpan(m_tracks, chain, f); }
+  template <typename F> void ForEachUserTrackSpan(const Chain& chain, F f) const { ForEachSpan(m_user_tracks, chain, f); }
+
+  private:
+  VoxelHitTracks() = default;
+
+  static constexpr G4int ChunkSize = 16;
+
+  template <typename T> struct Chunk {
+    T m_records[ChunkSize];
+    G4int m_size = 0;
+    G4int m_next = -1;
+  };
+
+  /// The chunks being used within the current event are [0, m_used)
+  template <typename T> struct Arena {
+    std::vector<Chunk<T>> m_chunks;
+    G4int m_used = 0;
+  };
+
+  template <typename T> void Append(Arena<T>& arena, Chain& chain, const T& record);
+
+  template <typename T, typename F> void ForEachSpan(const Arena<T>& arena, const Chain& chain, F f) const;
+
+  ///
+  static std::uint64_t MakeKey(G4int owner, G4int trkId, G4int kind) {
+    return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(owner)) << 33)
+         | (static_cast<std::uint64_t>(kind) << 32)
+         | static_cast<std::uint32_t>(trkId);
+  }
+
+  /// Open addressing (linear probing) set of the recorded keys, the slot is occupied
+  /// if its stamp matches the current event one, thus it's cleared just by the stamp increment
+  G4bool Insert(std::uint64_t key);
+  void Rehash(std::size_t capacity);
+
+  std::vector<std::uint64_t> m_keys;
+  std::vector<std::uint32_t> m_stamps;
+  std::uint32_t m_stamp = 1;
+  std::size_t m_count = 0;
+
+  Arena<Track> m_tracks;
+  Arena<UserTrack> m_user_tracks;
+  G4int m_owners = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+///
+template <typename T> void VoxelHitTracks::Append(Arena<T>& arena, Chain& chain, const T& record){
+  if(chain.m_last < 0 || arena.m_chunks[chain.m_last].m_size == ChunkSize){
+    G4int chunkIdx = arena.m_used++;
+    if(chunkIdx == static_cast<G4int>(arena.m_chunks.size()))
+      arena.m_chunks.emplace_back();
+    auto& chunk = arena.m_chunks[chunkIdx];
+    chunk.m_size = 0;
+    chunk.m_next = -1;
+    if(chain.m_last < 0)
+      chain.m_first = chunkIdx;
+    else
+      arena.m_chunks[chain.m_last].m_next = chunkIdx;
+    chain.m_last = chunkIdx;
+  }
+  auto& chunk = arena.m_chunks[chain.m_last];
+  chunk.m_records[chunk.m_size++] = record;
+  ++chain.m_size;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+template <typename T, typename F> void VoxelHitTracks::ForEachSpan(const Arena<T>& arena, const Chain& chain, F f) const {
+  for(auto chunkIdx = chain.m_first; chunkIdx >= 0; chunkIdx = arena.m_chunks[chunkIdx].m_next){
+    const auto& chunk = arena.m_chunks[chunkIdx];
+    f(chunk.m_records, chunk.m_size);
+  }
+}
+
+#endif //VOXELHITTRACKS_HH
@@ -68,6 +68,9 @@ void WaterPhantom::ParseTomlConfig(){
   ///
   m_watertankScoring = config[configObjScoring]["FullVolume"].value_or(true);
   m_farmerScoring = config[configObjScoring]["FarmerDoseCalibration"].value_or(false);
+  m_farmerShape = config[configObjScoring]["FarmerShape"].value_or("Box");
+  m_farmerRadius = config[configObjScoring]["FarmerRadius"].value_or(m_farmerRadius);
+  m_farmerLength = config[configObjScoring]["FarmerLength"].value_or(m_farmerLength);
 
   ///
   m_tracks_analysis = config[configObjScoring]["TracksAnalysis"].value_or(false);
@@ -193,8 +196,20 @@ void WaterPhantom::ConstructFarmerVolumeScoring(const G4String& name){
   if(m_patientSD.Get()==0)
     ConstructSensitiveDetector();
   auto patientSD = m_patientSD.Get();
-  auto farmerBox = G4Box(name+"Box",2.65*mm,2.65*mm,20*cm); 
-  patientSD->AddScoringVolume(name,name,farmerBox,1,1,200);
+  if(m_farmerShape=="Cylinder"){ // the chamber cavity along the Z axis
+    auto farmerBox = G4Box(name+"Box",m_farmerRadius*mm,m_farmerRadius*mm,m_farmerLength/2.*mm);
+    patientSD->AddScoringVolume(name,name,farmerBox,1,1,200);
+    patientSD->SetScoringCylinder(name,2,m_farmerRadius*mm);
+  }
+  else if(m_farmerShape=="Box"){
+    auto farmerBox = G4Box(name+"Box",2.65*mm,2.65*mm,m_farmerLength/2.*mm); 
+    patientSD->AddScoringVolume(name,name,farmerBox,1,1,200);
+  }
+  else {
+    G4String msg = "ConstructFarmerVolumeScoring:: FarmerShape "+m_farmerShape+" is not supported. Available: Box, Cylinder";
+    LOGSVC_CRITICAL("{}. Verify your input!", msg);
+    G4Exception("WaterPhantom", "ConstructFarmerVolumeScoring", FatalErrorInArgument, msg);
+  }
 }
 ////////////////////////////////////////////////////////////////////////////////
 ///
@@ -40,8 +40,8 @@ class WaterPhantom : public VPatient {
   void DefineSensitiveDetector() override;
 
   ///
-  std::map<std::size_t, VoxelHit> GetScoringHashedMap(const G4String& scoring_name,Scoring::Type type) const override {
-    return std::map<std::size_t, VoxelHit>(); // TODO
+  VoxelHitMap GetScoringHashedMap(const G4String& scoring_name,Scoring::Type type) const override {
+    return VoxelHitMap(); // TODO
   }
 
 
@@ -93,6 +93,11 @@ class WaterPhantom : public VPatient {
   ///
   G4bool m_farmerScoring = false;
 
+  /// The Farmer scoring volume: Box (5.3 mm square) or Cylinder of the given radius, length in [mm]
+  G4String m_farmerShape = "Box";
+  G4double m_farmerRadius = 3.05;
+  G4double m_farmerLength = 400.;
+
 };
 
 #endif  // WATER_PHANTOM_HH
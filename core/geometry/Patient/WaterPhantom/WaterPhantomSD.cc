@@ -26,7 +26,7 @@ G4bool WaterPhantomSD::ProcessHits(G4Step* aStep, G4TouchableHistory*) {
   // i.e. get volume where G4Step is remember (Note: PostStep "belongs" to next volume,
   // hence we use PreStepPoint!
   auto theTouchable = dynamic_cast<const G4TouchableHistory *>(aStep->GetPreStepPoint()->GetTouchable());
-  auto volumeName = theTouchable->GetVolume()->GetName();
+  const auto& volumeName = theTouchable->GetVolume()->GetName();
   if (volumeName != "WaterPhantomPV")
     LOGSVC_DEBUG("ProcessHits volume name ", volumeName);
   
@@ -45,12 +45,11 @@ G4bool WaterPhantomSD::ProcessHits(G4Step* aStep, G4TouchableHistory*) {
   }
 
   // ____________________________________________________________________________
-  for(const auto& hcName : ControlPoint::GetHitCollectionNames())
-    ProcessHitsCollection(hcName,aStep); 
+  ProcessScoringVolumes(aStep);
 
   // ____________________________________________________________________________
   // Collect all hits in this detector volume
-  if (Service<ConfigSvc>()->GetValue<bool>("RunSvc", "StepAnalysis"))
+  if (m_step_analysis)
     StepAnalysis::GetInstance()->FillStep(aStep);
 
   return true;
@@ -0,0 +1,124 @@
+#include "gtest/gtest.h"
+#include <array>
+#include <chrono>
+#include <functional>
+#include <numeric>
+#include "PatientTest.hh"
+#include "WaterPhantomSD.hh"
+#include "StepAnalysis.hh"
+#include "G4SDManager.hh"
+#include "G4HCofThisEvent.hh"
+#include "G4Navigator.hh"
+#include "G4TouchableHistory.hh"
+#include "G4Step.hh"
+#include "Randomize.hh"
+
+namespace {
+    // The scoring volumes fed by the SD: <hits collection name, voxelization>
+    const std::vector<std::pair<G4String,std::array<int,3>>> BenchmarkScoring = {
+        {"BenchTank",    {10,10,10}},
+        {"BenchProfile", {200,1,1}},
+        {"BenchDepth",   {1,1,200}},
+        {"BenchSlab",    {50,50,1}}
+    };
+    const int BenchmarkSteps = 500000;
+}
+
+// The WaterPhantomSD with the string based hits collection routing (as it has been done
+// before the dispatch list), being the reference for the timing and the scoring results.
+class BenchmarkSD : public WaterPhantomSD {
+    public:
+        BenchmarkSD(const G4String& sdName):WaterPhantomSD(sdName){}
+
+        G4bool ProcessHitsByName(G4Step* aStep){
+            auto theTouchable = dynamic_cast<const G4TouchableHistory *>(aStep->GetPreStepPoint()->GetTouchable());
+            auto volumeName = theTouchable->GetVolume()->GetName();
+            if (volumeName != "WaterPhantomPV")
+                LOGSVC_DEBUG("ProcessHits volume name ", volumeName);
+            auto thisSdHCNames = GetScoringVolumeNames();
+            for(const auto& hcName : ControlPoint::GetHitCollectionNames()){
+                if(find(thisSdHCNames.begin(), thisSdHCNames.end(), hcName) != thisSdHCNames.end())
+                    ProcessHitsCollection(hcName,aStep);
+            }
+            if (Service<ConfigSvc>()->GetValue<bool>("RunSvc", "StepAnalysis"))
+                StepAnalysis::GetInstance()->FillStep(aStep);
+            return true;
+        }
+
+        G4double GetTotalEdep(const G4String& hcName) {
+            const auto& voxels = GetScoringVolumePtr(hcName)->m_denseVoxels;
+            return std::accumulate(voxels.begin(), voxels.end(), 0.,
+                                   [](G4double sum, const auto& voxel){ return sum + voxel.m_edep; });
+        }
+
+        void ResetEdep(const G4String& hcName) {
+            GetScoringVolumePtr(hcName)->ResetDenseAccumulator();
+        }
+};
+
+// Steps/second through the SD: the dispatch list vs the string based routing
+TEST_F(PatientTest, WaterPhantomSDStepsPerSecond){
+    auto toml_file = m_projectPath + "/WaterPhantom/test/water_phantom_1x1x1_test.toml";
+    SvcSetup(toml_file);
+    auto world = WorldSetup();
+    auto water = G4NistManager::Instance()->FindOrBuildMaterial("G4_WATER");
+    auto phantomBox = new G4Box("WaterPhantomBox", 20.*cm, 20.*cm, 20.*cm);
+    auto phantomLV = new G4LogicalVolume(phantomBox, water, "waterPhantomLV");
+    new G4PVPlacement(nullptr, G4ThreeVector(), "WaterPhantomPV", phantomLV, world, false, 0);
+
+    auto sd = new BenchmarkSD("WaterPhantomBenchmarkSD");
+    for(const auto& scoring : BenchmarkScoring){
+        const auto& v = scoring.second;
+        sd->AddScoringVolume(scoring.first, scoring.first, *phantomBox, v[0], v[1], v[2]);
+    }
+    sd->SetDenseScoring(true); // no per-step hits allocation, the routing cost is what is measured
+    G4SDManager::GetSDMpointer()->AddNewDetector(sd);
+    G4HCofThisEvent hce(G4SDManager::GetSDMpointer()->GetCollectionCapacity());
+    sd->Initialize(&hce);
+    EXPECT_EQ(sd->GetNumberOfDispatchVolumes(), static_cast<G4int>(BenchmarkScoring.size()));
+
+    G4Navigator navigator;
+    navigator.SetWorldVolume(world);
+    navigator.LocateGlobalPointAndSetup(G4ThreeVector());
+    G4Step step;
+    auto preStepPoint = step.GetPreStepPoint();
+    preStepPoint->SetTouchableHandle(G4TouchableHandle(navigator.CreateTouchableHistory()));
+    preStepPoint->SetMaterial(water);
+    step.SetTotalEnergyDeposit(1.*keV);
+
+    std::vector<G4ThreeVector> positions;
+    positions.reserve(BenchmarkSteps);
+    for(int i = 0; i < BenchmarkSteps; ++i)
+        positions.emplace_back(G4ThreeVector(G4RandFlat::shoot(-19.9,19.9)*cm,
+                                             G4RandFlat::shoot(-19.9,19.9)*cm,
+                                             G4RandFlat::shoot(-19.9,19.9)*cm));
+
+    auto stepsPerSecond = [&](const std::function<void(G4Step*)>& process){
+        auto start = std::chrono::steady_clock::now();
+        for(const auto& position : positions){
+            preStepPoint->SetPosition(position);
+            process(&step);
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return BenchmarkSteps / elapsed.count();
+    };
+
+    auto byNameRate = stepsPerSecond([&](G4Step* aStep){ sd->ProcessHitsByName(aStep); });
+    std::vector<G4double> byNameEdep;
+    for(const auto& scoring : BenchmarkScoring){
+        byNameEdep.emplace_back(sd->GetTotalEdep(scoring.first));
+        sd->ResetEdep(scoring.first);
+    }
+
+    auto dispatchRate = stepsPerSecond([&](G4Step* aStep){ sd->ProcessHits(aStep, nullptr); });
+    for(std::size_t i = 0; i < BenchmarkScoring.size(); ++i){
+        EXPECT_GT(byNameEdep.at(i), 0.);
+        EXPECT_DOUBLE_EQ(sd->GetTotalEdep(BenchmarkScoring.at(i).first), byNameEdep.at(i));
+    }
+
+    G4cout << "WaterPhantomSD (" << BenchmarkScoring.size() << " scoring volumes, "
+           << BenchmarkSteps << " steps):" << G4endl;
+    G4cout << "  string routing: " << byNameRate << " steps/s" << G4endl;
+    G4cout << "  dispatch list:  " << dispatchRate << " steps/s (x" << dispatchRate/byNameRate << ")" << G4endl;
+    EXPECT_GT(dispatchRate, 0.);
+}
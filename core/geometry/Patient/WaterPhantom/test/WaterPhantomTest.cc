@@ -1,6 +1,27 @@
 #include "gtest/gtest.h"
 #include "PatientTest.hh"
 #include "WaterPhantom.hh"
+#include "WaterPhantomSD.hh"
+#include "G4SDManager.hh"
+#include "G4HCofThisEvent.hh"
+#include "G4Navigator.hh"
+#include "G4TouchableHistory.hh"
+#include "G4Step.hh"
+#include "G4Track.hh"
+#include "G4DynamicParticle.hh"
+#include "G4Gamma.hh"
+#include "G4Electron.hh"
+#include "Randomize.hh"
+
+namespace {
+    // The steps are fed directly into the given scoring volume
+    class ScoringTestSD : public WaterPhantomSD {
+        public:
+            ScoringTestSD(const G4String& sdName):WaterPhantomSD(sdName){}
+            void Process(const G4String& hcName, G4Step* aStep){ ProcessHitsCollection(hcName,aStep); }
+            VoxelHitsCollection* GetHits(const G4String& hcName){ return GetScoringVolumePtr(hcName)->m_voxelHCollectionPtr; }
+    };
+}
 
 // [WIP] Test Water Phantom
 TEST_F(PatientTest, WaterPhantom){
@@ -37,3 +58,72 @@ TEST_F(PatientTest, WaterPhantomScoring){
 }
 
 
+
+// The dense scoring mode yields the same event hits as the per-step VoxelHit updates
+TEST_F(PatientTest, WaterPhantomDenseScoringEquivalence){
+    auto toml_file = m_projectPath + "/WaterPhantom/test/water_phantom_1x1x1_test.toml";
+    SvcSetup(toml_file);
+    auto world = WorldSetup();
+    auto water = G4NistManager::Instance()->FindOrBuildMaterial("G4_WATER");
+    auto phantomBox = new G4Box("WaterPhantomEqBox", 2.*cm, 2.*cm, 2.*cm);
+    auto phantomLV = new G4LogicalVolume(phantomBox, water, "waterPhantomEqLV");
+    new G4PVPlacement(nullptr, G4ThreeVector(), "WaterPhantomPV", phantomLV, world, false, 0);
+
+    auto mapSD = new ScoringTestSD("WaterPhantomMapSD");
+    auto denseSD = new ScoringTestSD("WaterPhantomDenseSD");
+    mapSD->AddScoringVolume("MapTank", "MapTank", *phantomBox, 4, 4, 4);
+    denseSD->AddScoringVolume("DenseTank", "DenseTank", *phantomBox, 4, 4, 4);
+    mapSD->SetDenseScoring(false); // after the scoring volumes, these are taking the RunSvc setting
+    denseSD->SetDenseScoring(true);
+    G4SDManager::GetSDMpointer()->AddNewDetector(mapSD);
+    G4SDManager::GetSDMpointer()->AddNewDetector(denseSD);
+
+    G4Navigator navigator;
+    navigator.SetWorldVolume(world);
+    navigator.LocateGlobalPointAndSetup(G4ThreeVector());
+    G4Step step;
+    auto preStepPoint = step.GetPreStepPoint();
+    preStepPoint->SetTouchableHandle(G4TouchableHandle(navigator.CreateTouchableHistory()));
+    preStepPoint->SetMaterial(water);
+    G4Track gamma(new G4DynamicParticle(G4Gamma::Definition(), G4ThreeVector(0.,0.,1.), 1.*MeV), 0., G4ThreeVector());
+    G4Track electron(new G4DynamicParticle(G4Electron::Definition(), G4ThreeVector(0.,0.,1.), 1.*MeV), 0., G4ThreeVector());
+
+    for(int evt = 0; evt < 3; ++evt){
+        G4HCofThisEvent hce(G4SDManager::GetSDMpointer()->GetCollectionCapacity());
+        mapSD->Initialize(&hce);
+        denseSD->Initialize(&hce);
+        for(int i = 0; i < 2000; ++i){
+            step.SetTrack(G4UniformRand() < 0.5 ? &gamma : &electron);
+            preStepPoint->SetKineticEnergy(G4RandFlat::shoot(0.01, 6.) * MeV);
+            preStepPoint->SetPosition(G4ThreeVector(G4RandFlat::shoot(-2.,2.)*cm, G4RandFlat::shoot(-2.,2.)*cm,
+                                                    G4RandFlat::shoot(-2.,2.)*cm));
+            step.SetTotalEnergyDeposit(G4UniformRand() < 0.2 ? 0. : G4RandFlat::shoot(0.,50.)*keV);
+            mapSD->Process("MapTank", &step);
+            denseSD->Process("DenseTank", &step);
+        }
+        mapSD->EndOfEvent(&hce);
+        denseSD->EndOfEvent(&hce);
+
+        auto mapHits = mapSD->GetHits("MapTank");
+        auto denseHits = denseSD->GetHits("DenseTank");
+        ASSERT_EQ(mapHits->entries(), denseHits->entries());
+        EXPECT_EQ(static_cast<int>(mapHits->entries()), 4 * 4 * 4);
+        for(std::size_t i = 0; i < mapHits->entries(); ++i){
+            const auto& mapHit = *(*mapHits)[i];
+            const auto& denseHit = *(*denseHits)[i];
+            EXPECT_EQ(mapHit.GetPackedId(), denseHit.GetPackedId());
+            EXPECT_EQ(mapHit.GetEnergyDeposit(), denseHit.GetEnergyDeposit());
+            EXPECT_EQ(mapHit.GetDose(), denseHit.GetDose());
+            EXPECT_EQ(mapHit.GetPrimaryId(), denseHit.GetPrimaryId());
+            EXPECT_EQ(mapHit.GetPrimaryEnergy(), denseHit.GetPrimaryEnergy());
+            EXPECT_EQ(mapHit.GetGravCentre(), denseHit.GetGravCentre());
+            EXPECT_EQ(mapHit.GetCentre(), denseHit.GetCentre());
+            const auto& mapSteps = mapHit.GetStepsEnergyDeposit();
+            const auto& denseSteps = denseHit.GetStepsEnergyDeposit();
+            EXPECT_EQ(mapSteps.GetCount(), denseSteps.GetCount());
+            EXPECT_EQ(mapSteps.GetSum2(), denseSteps.GetSum2());
+            EXPECT_EQ(mapSteps.GetMin(), denseSteps.GetMin());
+            EXPECT_EQ(mapSteps.GetMax(), denseSteps.GetMax());
+        }
+    }
+}
@@ -0,0 +1,156 @@
+#include "gtest/gtest.h"
+#include "PatientTest.hh"
+#include "VPatientSD.hh"
+#include "Randomize.hh"
+#include <cmath>
+
+namespace {
+    std::unique_ptr<VPatientSD::ScoringVolume> MakeScoringVolume(const G4ThreeVector& centre, const G4ThreeVector& halfSize,
+                                                                int nX, int nY, int nZ){
+        auto sv = std::make_unique<VPatientSD::ScoringVolume>();
+        sv->m_nVoxelsX = nX;
+        sv->m_nVoxelsY = nY;
+        sv->m_nVoxelsZ = nZ;
+        sv->m_envelopeBoxPtr = std::make_unique<G4Box>("LocatorTestBox", halfSize.x(), halfSize.y(), halfSize.z());
+        // as it's done in VPatientSD::SetScoringVolume
+        sv->m_rangeMinX = svc::round_with_prec(centre.x() - halfSize.x(), 8);
+        sv->m_rangeMaxX = svc::round_with_prec(centre.x() + halfSize.x(), 8);
+        sv->m_rangeMinY = svc::round_with_prec(centre.y() - halfSize.y(), 8);
+        sv->m_rangeMaxY = svc::round_with_prec(centre.y() + halfSize.y(), 8);
+        sv->m_rangeMinZ = svc::round_with_prec(centre.z() - halfSize.z(), 8);
+        sv->m_rangeMaxZ = svc::round_with_prec(centre.z() + halfSize.z(), 8);
+        sv->InitializeLocator();
+        return sv;
+    }
+
+    // Compare the fused locator with the IsInside/IsOnBorder/GetVoxelID implementation
+    int CountMismatches(const VPatientSD::ScoringVolume& sv, const G4ThreeVector& position){
+        G4int idX, idY, idZ;
+        G4bool onBorder;
+        auto inside = sv.Locate(position, idX, idY, idZ, onBorder);
+        int mismatches = 0;
+        mismatches += inside != sv.IsInside(position);
+        mismatches += onBorder != sv.IsOnBorder(position);
+        if(inside && sv.IsInside(position)){
+            mismatches += idX != sv.GetVoxelID(0, position);
+            mismatches += idY != sv.GetVoxelID(1, position);
+            mismatches += idZ != sv.GetVoxelID(2, position);
+        }
+        return mismatches;
+    }
+}
+
+// The Locate(...) kernel vs the per-axis implementation on randomized and on the edge positions
+TEST_F(PatientTest, ScoringVolumeLocator){
+    SvcSetup(m_projectPath + "/WaterPhantom/test/water_phantom_1x1x1_test.toml");
+    std::vector<std::unique_ptr<VPatientSD::ScoringVolume>> volumes;
+    volumes.emplace_back(MakeScoringVolume(G4ThreeVector(0.,0.,0.), G4ThreeVector(200.,200.,200.), 1, 1, 1));
+    volumes.emplace_back(MakeScoringVolume(G4ThreeVector(0.,0.,-180.), G4ThreeVector(200.,200.,200.), 10, 10, 10));
+    volumes.emplace_back(MakeScoringVolume(G4ThreeVector(12.3456789,-7.1,33.3), G4ThreeVector(2.65,2.65,200.), 1, 1, 200));
+    volumes.emplace_back(MakeScoringVolume(G4ThreeVector(-40.,25.,0.), G4ThreeVector(5.,5.,5.), 7, 3, 13));
+    volumes.emplace_back(MakeScoringVolume(G4ThreeVector(0.1,0.2,0.3), G4ThreeVector(0.5,0.25,0.125), 50, 50, 1));
+
+    int mismatches = 0;
+    for(const auto& sv : volumes){
+        const G4double min[3] = {sv->m_rangeMinX, sv->m_rangeMinY, sv->m_rangeMinZ};
+        const G4double max[3] = {sv->m_rangeMaxX, sv->m_rangeMaxY, sv->m_rangeMaxZ};
+        auto shoot = [&](int axis, G4double margin){
+            auto size = max[axis] - min[axis];
+            return G4RandFlat::shoot(min[axis] - margin*size, max[axis] + margin*size);
+        };
+        // randomized positions, within and around the scoring volume
+        for(int i = 0; i < 200000; ++i)
+            mismatches += CountMismatches(*sv, G4ThreeVector(shoot(0,0.1), shoot(1,0.1), shoot(2,0.1)));
+        // positions at and around the edges (within and beyond the rounding precision)
+        const G4double shifts[] = {0., 1e-12, -1e-12, 0.4e-8, -0.4e-8, 0.6e-8, -0.6e-8, 1e-8, -1e-8, 1e-6, -1e-6};
+        // the internal voxel edges, evaluated as the pitch multiples and as the former expression inverted
+        const G4int nVoxels[3] = {sv->m_nVoxelsX, sv->m_nVoxelsY, sv->m_nVoxelsZ};
+        for(int axis = 0; axis < 3; ++axis){
+            for(int k = 1; k < nVoxels[axis]; ++k){
+                auto size = max[axis] - min[axis];
+                for(auto edge : {min[axis] + k * (size / nVoxels[axis]), min[axis] + k * size / nVoxels[axis],
+                                 max[axis] - (nVoxels[axis] - k) * (size / nVoxels[axis])}){
+                    for(auto ulps : {-2, -1, 0, 1, 2}){
+                        auto x = edge;
+                        for(int u = 0; u < std::abs(ulps); ++u)
+                            x = std::nextafter(x, ulps > 0 ? max[axis] : min[axis]);
+                        G4double pos[3] = {shoot(0,0.), shoot(1,0.), shoot(2,0.)};
+                        pos[axis] = x;
+                        mismatches += CountMismatches(*sv, G4ThreeVector(pos[0], pos[1], pos[2]));
+                    }
+                }
+            }
+        }
+        for(int axis = 0; axis < 3; ++axis){
+            for(auto edge : {min[axis], max[axis], -min[axis], -max[axis]}){
+                for(auto shift : shifts){
+                    for(int i = 0; i < 100; ++i){
+                        G4double pos[3] = {shoot(0,0.), shoot(1,0.), shoot(2,0.)};
+                        pos[axis] = edge + shift;
+                        mismatches += CountMismatches(*sv, G4ThreeVector(pos[0], pos[1], pos[2]));
+                    }
+                }
+            }
+        }
+    }
+    EXPECT_EQ(mismatches, 0);
+}
+
+// The cylinder shape vs the sqrt based reference (as the former Farmer30013 implementation)
+TEST_F(PatientTest, ScoringVolumeCylinderLocator){
+    SvcSetup(m_projectPath + "/WaterPhantom/test/water_phantom_1x1x1_test.toml");
+    const G4double radius = 3.05;
+    for(int axis = 0; axis < 3; ++axis){
+        G4ThreeVector halfSize(radius, radius, radius);
+        halfSize[axis] = 200.;
+        int nVoxels[3] = {1, 1, 1};
+        nVoxels[axis] = 200;
+        auto sv = MakeScoringVolume(G4ThreeVector(1.5,-2.5,-180.), halfSize, nVoxels[0], nVoxels[1], nVoxels[2]);
+        sv->m_shape = "Cylinder";
+        sv->m_cylinderAxis = axis;
+        sv->m_cylinderRadius = radius;
+        sv->InitializeLocator();
+        EXPECT_EQ(sv->GetShape(), VPatientSD::ScoringVolume::Shape::Cylinder);
+        EXPECT_NEAR(sv->GetVoxelVolume(), CLHEP::pi*radius*radius*400./200., 1e-9);
+
+        const G4double min[3] = {sv->m_rangeMinX, sv->m_rangeMinY, sv->m_rangeMinZ};
+        const G4double max[3] = {sv->m_rangeMaxX, sv->m_rangeMaxY, sv->m_rangeMaxZ};
+        auto u = (axis + 1) % 3, v = (axis + 2) % 3;
+        int mismatches = 0;
+        for(int i = 0; i < 200000; ++i){
+            G4double pos[3];
+            for(int k = 0; k < 3; ++k){
+                auto margin = 0.1*(max[k] - min[k]);
+                pos[k] = G4RandFlat::shoot(min[k] - margin, max[k] + margin);
+            }
+            G4ThreeVector position(pos[0], pos[1], pos[2]);
+            auto relU = pos[u] - (min[u] + max[u])/2.;
+            auto relV = pos[v] - (min[v] + max[v])/2.;
+            G4bool reference = pos[axis] >= min[axis] && pos[axis] < max[axis] && std::sqrt(relU*relU + relV*relV) <= radius;
+            G4int idX, idY, idZ;
+            G4bool onBorder;
+            auto inside = sv->Locate(position, idX, idY, idZ, onBorder);
+            mismatches += inside != reference;
+            mismatches += inside != sv->IsInside(position);
+            if(inside && reference){
+                G4int id[3] = {idX, idY, idZ};
+                mismatches += id[axis] != sv->GetVoxelID(axis, position);
+            }
+        }
+        EXPECT_EQ(mismatches, 0);
+    }
+}
+
+// The voxel volumes (used by the dose normalization) of the named shapes are kept as they have been
+TEST_F(PatientTest, ScoringVolumeShapeVoxelVolume){
+    SvcSetup(m_projectPath + "/WaterPhantom/test/water_phantom_1x1x1_test.toml");
+    auto sv = MakeScoringVolume(G4ThreeVector(0.,0.,0.), G4ThreeVector(200.,2.65,2.65), 200, 1, 1);
+    EXPECT_NEAR(sv->GetVoxelVolume(), 2.*5.3*5.3, 1e-9); // Box
+    sv->m_shape = "Farmer30013";
+    sv->m_cylinderRadius = 3.05;
+    sv->InitializeLocator();
+    EXPECT_NEAR(sv->GetVoxelVolume(), 400.*3.14159*3.05*3.05, 1e-9);
+    sv->m_shape = "Farmer30013ScanZBox";
+    sv->InitializeLocator();
+    EXPECT_EQ(sv->GetVoxelVolume(), 0.);
+}
@@ -0,0 +1,64 @@
+#include "gtest/gtest.h"
+#include "VoxelHitMap.hh"
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    // D3D like template: the cells grid (starting from the given cell) with the voxels of each cell
+    std::vector<Scoring::Key> FillTemplate(VoxelHitMap& map, int cellX0, int nVoxels){
+        std::vector<Scoring::Key> keys;
+        for(int cx = cellX0; cx < cellX0 + 3; ++cx)
+            for(int cy = 0; cy < 2; ++cy)
+                for(int cz = 1; cz < 5; ++cz)
+                    for(int ix = 0; ix < nVoxels; ++ix)
+                        for(int iy = 0; iy < nVoxels; ++iy)
+                            for(int iz = 0; iz < 2; ++iz){
+                                keys.push_back(Scoring::PackKey(cx, cy, cz, ix, iy, iz));
+                                map.Insert(keys.back());
+                            }
+        return keys;
+    }
+}
+
+// The direct index gives the same slots as the hashed lookup, including the keys out of the template
+TEST(VoxelHitMapTest, DirectIndexMatchesHashed){
+    VoxelHitMap hashed, direct;
+    auto keys = FillTemplate(hashed, 2, 3);
+    FillTemplate(direct, 2, 3);
+    direct.BuildDirectIndex();
+    ASSERT_TRUE(direct.HasDirectIndex());
+    ASSERT_FALSE(hashed.HasDirectIndex());
+
+    for(std::size_t slot = 0; slot < keys.size(); ++slot){
+        EXPECT_EQ(hashed.Find(keys[slot]), &hashed[slot]);
+        EXPECT_EQ(direct.Find(keys[slot]), &direct[slot]);
+    }
+    // below and above the bounding box of each axis, and the holes within it
+    for(auto key : {Scoring::PackKey(1,0,1), Scoring::PackKey(5,0,1), Scoring::PackKey(2,0,0), Scoring::PackKey(2,2,1),
+                    Scoring::PackKey(2,0,5), Scoring::PackKey(2,0,1,3), Scoring::PackKey(2,0,1,0,0,2),
+                    Scoring::PackKey(1023,1023,1023,1023,1023,1023)}){
+        EXPECT_EQ(hashed.Find(key), nullptr);
+        EXPECT_EQ(direct.Find(key), nullptr);
+        EXPECT_THROW(direct.at(key), std::out_of_range);
+    }
+
+    // the copies share the index, the next Insert drops it (copy on write)
+    auto copy = direct;
+    EXPECT_TRUE(copy.HasSameLayout(direct));
+    EXPECT_TRUE(copy.HasDirectIndex());
+    copy.Insert(Scoring::PackKey(7,0,1));
+    EXPECT_FALSE(copy.HasDirectIndex());
+    EXPECT_TRUE(direct.HasDirectIndex());
+    EXPECT_EQ(copy.Find(Scoring::PackKey(7,0,1)), &copy[keys.size()]);
+}
+
+// The sparse layout keeps the hashed lookup
+TEST(VoxelHitMapTest, SparseLayoutKeepsHashed){
+    VoxelHitMap map;
+    map.Insert(Scoring::PackKey(0,0,0));
+    map.Insert(Scoring::PackKey(100,100,100,10,10,10));
+    map.BuildDirectIndex();
+    EXPECT_FALSE(map.HasDirectIndex());
+    EXPECT_EQ(map.Find(Scoring::PackKey(100,100,100,10,10,10)), &map[1]);
+    EXPECT_EQ(map.Find(Scoring::PackKey(1,0,0)), nullptr);
+}
@@ -463,12 +463,11 @@ void PatientGeometry::ExportDoseToCsvCT(const G4Run* runPtr) const {
   for(auto& scoring_map: scoring_maps){
     for(auto& scoring: scoring_map.second){
       auto scoring_type = scoring.first;
-      auto data = scoring.second;
+      const auto& data = scoring.second;
       // Check if the scoring type is voxel
       if(scoring_type==Scoring::Type::Voxel){      
         // Iterate over voxel data
-        for(auto& voxel: data){
-          auto& voxel_data = voxel.second;
+        for(auto& voxel_data: data){
           // Create pairs to check if the pair already exists in the set
           std::pair<double, size_t> pairToCheckX = std::make_pair(
             voxel_data.GetCentre().getX(), 
@@ -507,8 +506,7 @@ void PatientGeometry::ExportDoseToCsvCT(const G4Run* runPtr) const {
       }
       else if(scoring_type==Scoring::Type::Cell){      
         // Iterate over voxel data
-        for(auto& cell: data){
-          auto& cell_data = cell.second;
+        for(auto& cell_data: data){
           // Create pairs to check if the pair already exists in the set
           std::pair<double, size_t> pairToCheckX = std::make_pair(
             cell_data.GetCentre().getX(), std::hash<std::string>{}(
@@ -557,7 +555,7 @@ void PatientGeometry::ExportDoseToCsvCT(const G4Run* runPtr) const {
   std::sort(yMappedVoxels.begin(), yMappedVoxels.end(), compareByFirst);
   std::sort(zMappedVoxels.begin(), zMappedVoxels.end(), compareByFirst);
 
-  const std::map<size_t, VoxelHit>* voxelData = nullptr;
+  const VoxelHitMap* voxelData = nullptr;
   for(auto& scoring_map: scoring_maps){
     for(auto& scoring: scoring_map.second){
       auto scoring_type = scoring.first;
@@ -571,7 +569,7 @@ void PatientGeometry::ExportDoseToCsvCT(const G4Run* runPtr) const {
   std::sort(yMappedCells.begin(), yMappedCells.end(), compareByFirst);
   std::sort(zMappedCells.begin(), zMappedCells.end(), compareByFirst);
 
-  const std::map<size_t, VoxelHit>* cellData = nullptr;
+  const VoxelHitMap* cellData = nullptr;
   for(auto& scoring_map: scoring_maps){
     for(auto& scoring: scoring_map.second){
       auto scoring_type = scoring.first;
@@ -632,12 +630,11 @@ void PatientGeometry::ExportDoseToCsvCT(const G4Run* runPtr) const {
     }
 
     if (type == Scoring::Type::Voxel) {
-      return &voxelData->find(std::hash<std::string>{}(std::to_string(closestX.first)+std::to_string(closestY.first)+
-                                    std::to_string(closestZ.first)+std::to_string(closestX.second)+
-                                    std::to_string(closestY.second)+std::to_string(closestZ.second)))->second;}
+      return voxelData->Find(Scoring::PackKey(closestX.first,closestY.first,closestZ.first,
+                                              closestX.second,closestY.second,closestZ.second));}
     if (type == Scoring::Type::Cell) {
-      return &cellData->find(std::hash<std::string>{}(std::to_string(closestX.first)+std::to_string(closestY.first)+
-                                    std::to_string(closestZ.first)))->second;}
+      return cellData->Find(Scoring::PackKey(closestX.first,closestY.first,closestZ.first));}
+    return nullptr;
     
   };
 
@@ -1,46 +1,80 @@
 #include "IaeaPrimaryGenerator.hh"
 #include "G4IAEAphspReader.hh"
+#include "PhspFieldFilter.hh"
 #include "Services.hh"
 #include "PrimariesAnalysis.hh"
 #include "G4Event.hh"
+#include "G4Threading.hh"
+#include <algorithm>
+#ifdef G4MULTITHREADED
+  #include "G4MTRunManager.hh"
+#endif
 
 
-G4IAEAphspReader* IaeaPrimaryGenerator::m_iaeaFileReader = nullptr;
-
 ////////////////////////////////////////////////////////////////////////////////
 ///
 IaeaPrimaryGenerator::IaeaPrimaryGenerator(const G4String& fileName) {
+  m_iaeaFileReader = new G4IAEAphspReader(fileName.data());
+
+  // the phsp file is divided into history-aligned chunks by the master (see SetUpChunks);
+  // see GeneratePrimaryVertexVector for the chunk selection during the run
+  auto id_thread = G4Threading::G4GetThreadId();
+  if(id_thread >= 0 && id_thread < G4IAEAphspReader::GetTotalParallelRuns())
+    m_iaeaFileReader->SetParallelRun(1 + id_thread);
 
-  if(!m_iaeaFileReader){ 
+  auto readerType = Service<ConfigSvc>()->GetValue<std::string>("RunSvc", "PhspReaderType");
+  if(readerType == "mmap"){
+    m_iaeaFileReader->SetBufferType(G4IAEAphspReader::BufferType::MemoryMapped);
+  } else if(readerType != "stream"){
+    G4ExceptionDescription msg;
+    msg << "Phase space reader type '" << readerType << "' is not defined (stream or mmap)";
+    G4Exception("IaeaPrimaryGenerator", "IaeaPrimaryGenerator", FatalErrorInArgument, msg);
+  }
 
-    // auto id_thread = G4Threading::G4GetThreadId();
-    // // auto max_thread = G4Threading::GetNumberOfRunningWorkerThreads();
-    // auto max_thread = Service<ConfigSvc>()->GetValue<int>("RunSvc", "NumberOfThreads");
+  // the chunks are split by histories according to the .IAEAindex sidecar (built once if missing)
+  auto indexStride = Service<ConfigSvc>()->GetValue<int>("RunSvc", "PhspHistoryIndexStride");
+  if(indexStride > 0)
+    m_iaeaFileReader->UseHistoryIndex(indexStride);
 
-    m_iaeaFileReader = new G4IAEAphspReader(fileName.data());
-    // m_iaeaFileReader->SetParallelRun(1 + id_thread);
-    // m_iaeaFileReader->SetTotalParallelRuns(max_thread);
+  // the angle and field cuts applied before the vertices are created
+  m_preFiltered = Service<ConfigSvc>()->GetValue<bool>("RunSvc", "PhspPreFilter");
+  if(m_preFiltered)
+    m_iaeaFileReader->AddFilter(new PhspFieldFilter());
 
-    m_iaeaFileReader->SetTimesRecycled(0); // default -> 0 
+  m_iaeaFileReader->SetTimesRecycled(0); // default -> 0 
 
+  // // TODO: Check these func!!!
+  // m_iaeaFileReader->SetGantryAngle();
+  // m_iaeaFileReader->SetCollimatorAngle();
+  // m_iaeaFileReader->SetIsocenterPosition();
 
-    // // TODO: Check these func!!!
-    // m_iaeaFileReader->SetGantryAngle();
-    // m_iaeaFileReader->SetCollimatorAngle();
-    // m_iaeaFileReader->SetIsocenterPosition();
+  // // TODO: Check how to setup multiple PHSP files!
 
-    // // TODO: Check how to setup multiple PHSP files!
-    
+  // define the position of the isocenter
+  // it’s mandatory before rotations around this point
+  m_iaeaFileReader->SetIsocenterPosition(G4ThreeVector(0., 0., 0. * cm));
 
-    // define the position of the isocenter
-    // it’s mandatory before rotations around this point
-    m_iaeaFileReader->SetIsocenterPosition(G4ThreeVector(0., 0., 0. * cm));
-  
-    // phase-space plane shift
-    m_phspShiftZ = Service<ConfigSvc>()->GetValue<double>("RunSvc", "phspShiftZ");
-    m_iaeaFileReader->SetGlobalPhspTranslation(G4ThreeVector(0.,0.,-m_phspShiftZ));
-    G4cout << "[INFO]:: IaeaPrimaryGenerator:: Setting phase space Z position " << m_phspShiftZ / cm  << " [cm]"<< G4endl;
-  }
+  // phase-space plane shift
+  m_phspShiftZ = Service<ConfigSvc>()->GetValue<double>("RunSvc", "phspShiftZ");
+  m_iaeaFileReader->SetGlobalPhspTranslation(G4ThreeVector(0.,0.,-m_phspShiftZ));
+  G4cout << "[INFO]:: IaeaPrimaryGenerator:: Setting phase space Z position " << m_phspShiftZ / cm  << " [cm]"<< G4endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+IaeaPrimaryGenerator::~IaeaPrimaryGenerator() {
+  delete m_iaeaFileReader;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+void IaeaPrimaryGenerator::SetUpChunks(int nChunks, bool rewind) {
+  G4IAEAphspReader::SetTotalParallelRuns(std::max(1, nChunks));
+  // the control points distributed over the processes read the chunks from their beginning,
+  // thus the histories they get don't depend on the control points run before in the same pool;
+  // otherwise the reading goes on, i.e. the consecutive control points don't share the histories
+  if(rewind)
+    G4IAEAphspReader::RewindChunks();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -52,6 +86,18 @@ void IaeaPrimaryGenerator::GeneratePrimaryVertex(G4Event *evt) {
 
 ////////////////////////////////////////////////////////////////////////////////
 ///
+/// The chunk is selected with the bunch of events this event belongs to (see UIManager
+/// setting the event modulo and the number of chunks: a chunk per bunch), hence the given
+/// event is always reading the same histories, whatever thread is processing it. The bunch
+/// is processed by a single thread, thus the chunk is never read by two threads at once.
 std::vector<G4PrimaryVertex*> IaeaPrimaryGenerator::GeneratePrimaryVertexVector(G4Event *evt) {
+  #ifdef G4MULTITHREADED
+  auto nChunks = G4IAEAphspReader::GetTotalParallelRuns();
+  if(nChunks > 1){
+    auto evtModulo = G4MTRunManager::GetMasterRunManager()->GetEventModulo();
+    if(evtModulo > 0)
+      m_iaeaFileReader->SetParallelRun(1 + (evt->GetEventID() / evtModulo) % nChunks);
+  }
+  #endif
   return m_iaeaFileReader->ReadThisEventPrimaryVertexVector(evt->GetEventID());
 }
\ No newline at end of file
@@ -25,18 +25,29 @@ class IaeaPrimaryGenerator : public G4VPrimaryGenerator {
     explicit IaeaPrimaryGenerator(const G4String& fileName);
 
     ///
-    ~IaeaPrimaryGenerator() = default;
+    ~IaeaPrimaryGenerator();
 
     ///
     void GeneratePrimaryVertex(G4Event*) override;
     std::vector<G4PrimaryVertex*> GeneratePrimaryVertexVector(G4Event *evt);
 
+    /// Divide the phsp file into the chunks, each one is read by a single thread at a time.
+    /// To be called by the master before each run: the chunks ownership is released and,
+    /// if requested, the chunks are rewound, i.e. the phsp histories are re-used by each control point
+    static void SetUpChunks(int nChunks, bool rewind = false);
+
+    /// The generated vertices have passed the angle and field cuts already (see PhspFieldFilter)
+    bool IsPreFiltered() const { return m_preFiltered; }
+
   private:
-    ///
-    static G4IAEAphspReader* m_iaeaFileReader;
+    /// Each worker owns its reader (and IAEA source), reading its own fragment of the file
+    G4IAEAphspReader* m_iaeaFileReader = nullptr;
 
     ///
     G4double m_phspShiftZ = 0;
+
+    ///
+    bool m_preFiltered = false;
 };
 
 #endif  // PHSIAEAPRIMARYGENERATOR_HH
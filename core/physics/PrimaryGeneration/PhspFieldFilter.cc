@@ -0,0 +1,38 @@
+#include "PhspFieldFilter.hh"
+#include "G4IAEAphspKinematics.hh"
+#include "BeamCollimation.hh"
+#include "ControlPoint.hh"
+#include "Services.hh"
+#include "G4SystemOfUnits.hh"
+#include <cmath>
+
+////////////////////////////////////////////////////////////////////////////////
+///
+PhspFieldFilter::PhspFieldFilter(){
+  m_cos_angle_treshold = std::cos(BeamCollimation::ParticleAngleTreshold * deg);
+  m_field_cut = Service<GeoSvc>()->GetMlcModel() == EMlcModel::Simplified;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// theta > treshold <=> cos(theta) < cos(treshold), the momentum magnitude is kept on the right side
+void PhspFieldFilter::Apply(G4IAEAphspKinematics& kinematics){
+  auto nRead = kinematics.GetNumberOfSelected();
+  auto cosTreshold = m_cos_angle_treshold;
+  kinematics.Select([&kinematics,cosTreshold](G4long j){
+    auto px = kinematics.GetPx(j);
+    auto py = kinematics.GetPy(j);
+    auto pz = kinematics.GetPz(j);
+    return !(pz < cosTreshold * std::sqrt(px*px + py*py + pz*pz));
+  });
+
+  auto current_cp = Service<RunSvc>()->CurrentControlPoint();
+  if(m_field_cut && kinematics.GetNumberOfSelected() > 0){
+    auto mlc = current_cp->MLC();
+    kinematics.Select([&kinematics,mlc](G4long j){
+      return mlc->IsInField(VMlc::GetPositionInMaskPlane(kinematics.GetPosition(j),kinematics.GetMomentum(j)));
+    });
+  }
+
+  auto nAccepted = kinematics.GetNumberOfSelected();
+  current_cp->GetRun()->CountFilteredPrimaries(nAccepted, nRead - nAccepted);
+}
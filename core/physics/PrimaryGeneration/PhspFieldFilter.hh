@@ -0,0 +1,28 @@
+#ifndef PHSPFIELDFILTER_HH
+#define PHSPFIELDFILTER_HH
+
+#include "G4IAEAphspFilter.hh"
+#include "globals.hh"
+
+///\class PhspFieldFilter
+///\brief The BeamCollimation::FilterPrimaries cuts (the particle angle treshold and the field
+/// aperture of the simplified MLC) applied on the phase-space reader records, before the
+/// G4PrimaryVertex objects are created. The accepted/rejected numbers are counted within
+/// the current control point run.
+class PhspFieldFilter : public G4IAEAphspFilter {
+  public:
+    ///
+    PhspFieldFilter();
+
+    ///
+    void Apply(G4IAEAphspKinematics& kinematics) override;
+
+  private:
+    ///
+    G4double m_cos_angle_treshold;
+
+    ///
+    G4bool m_field_cut = false;
+};
+
+#endif  // PHSPFIELDFILTER_HH
@@ -0,0 +1,179 @@
+#include "gtest/gtest.h"
+#include "G4IAEAphspReader.hh"
+#include "G4IAEAphspFilter.hh"
+#include "G4IAEAphspKinematics.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4SystemOfUnits.hh"
+#include "iaea_phsp.h"
+#include <atomic>
+#include <cmath>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+
+namespace {
+    std::string TempFile(const std::string& name){
+        return (std::filesystem::temp_directory_path() / name).string();
+    }
+
+    // Synthetic phsp of nHistories photons histories with 1+h%3 particles each,
+    // the particle (h,p) is stored at x = h cm, y = p cm, thus each record is identified by its vertex
+    std::string WritePhsp(const std::string& name, int nHistories){
+        auto fileName = TempFile(name);
+        std::filesystem::remove(fileName + ".IAEAindex");
+        IAEA_I32 source = -1, access = 2, result;
+        iaea_new_source(&source, const_cast<char*>(fileName.c_str()), &access, &result, fileName.size() + 1);
+        IAEA_I32 nExtraFloats = 0, nExtraInts = 0;
+        iaea_set_extra_numbers(&source, &nExtraFloats, &nExtraInts);
+        for(int h = 0; h < nHistories; ++h){
+            for(int p = 0; p < 1 + h % 3; ++p){
+                IAEA_I32 nStat = p == 0 ? 1 : 0, type = 1;
+                IAEA_Float energy = 1, weight = 1, x = h, y = p, z = 0, u = 0, v = 0, w = 1;
+                iaea_write_particle(&source, &nStat, &type, &energy, &weight, &x, &y, &z, &u, &v, &w, nullptr, nullptr);
+            }
+        }
+        IAEA_I64 nOriginal = nHistories;
+        iaea_set_total_original_particles(&source, &nOriginal);
+        iaea_update_header(&source, &result);
+        iaea_destroy_source(&source, &result);
+        return fileName;
+    }
+
+    std::pair<int,int> RecordId(const G4PrimaryVertex* vertex){
+        return {static_cast<int>(std::lround(vertex->GetX0() / cm)), static_cast<int>(std::lround(vertex->GetY0() / cm))};
+    }
+
+    class RejectAllFilter : public G4IAEAphspFilter {
+      public:
+        explicit RejectAllFilter(int& nApplied) : m_nApplied(nApplied) {}
+        void Apply(G4IAEAphspKinematics& kinematics) override {
+            ++m_nApplied;
+            kinematics.Select([](G4long){ return false; });
+        }
+      private:
+        int& m_nApplied;
+    };
+}
+
+// All the records are read once per pass over the file
+TEST(IaeaPhspReaderTest, ReadsAllRecords){
+    auto fileName = WritePhsp("IaeaPhspReaderTest_All", 100);
+    G4IAEAphspReader::SetTotalParallelRuns(1);
+    G4IAEAphspReader reader(fileName);
+    std::set<std::pair<int,int>> records;
+    for(int evt = 0; evt < 100; ++evt){
+        auto vertices = reader.ReadThisEventPrimaryVertexVector(evt);
+        EXPECT_EQ(vertices.size(), 1u + evt % 3);
+        for(auto vertex : vertices){
+            EXPECT_TRUE(records.insert(RecordId(vertex)).second);
+            delete vertex;
+        }
+    }
+    EXPECT_EQ(records.size(), 199u);
+}
+
+// The mapped records (the phsp stream released) are the same as the streamed ones, also when recycled
+TEST(IaeaPhspReaderTest, MappedMatchesStream){
+    auto fileName = WritePhsp("IaeaPhspReaderTest_Mapped", 50);
+    G4IAEAphspReader::SetTotalParallelRuns(1);
+    G4IAEAphspReader::RewindChunks();
+    std::vector<std::pair<int,int>> streamed, mapped;
+    {
+        G4IAEAphspReader reader(fileName);
+        for(int evt = 0; evt < 80; ++evt){
+            for(auto vertex : reader.ReadThisEventPrimaryVertexVector(evt)){
+                streamed.push_back(RecordId(vertex));
+                delete vertex;
+            }
+        }
+    }
+    G4IAEAphspReader::RewindChunks();
+    G4IAEAphspReader reader(fileName);
+    reader.SetBufferType(G4IAEAphspReader::BufferType::MemoryMapped);
+    for(int evt = 0; evt < 80; ++evt){
+        for(auto vertex : reader.ReadThisEventPrimaryVertexVector(evt)){
+            mapped.push_back(RecordId(vertex));
+            delete vertex;
+        }
+    }
+    EXPECT_EQ(streamed.size(), 99u + 60u); // 50 histories, then the first 30 ones recycled
+    EXPECT_EQ(mapped, streamed);
+}
+
+// The filter rejecting everything doesn't make the reader loop forever (recycling the file)
+TEST(IaeaPhspReaderTest, RejectAllFilterTerminates){
+    auto fileName = WritePhsp("IaeaPhspReaderTest_RejectAll", 10);
+    G4IAEAphspReader::SetTotalParallelRuns(1);
+    G4IAEAphspReader::RewindChunks();
+    G4IAEAphspReader reader(fileName);
+    int nApplied = 0;
+    reader.AddFilter(new RejectAllFilter(nApplied));
+    reader.SetMaxRejectedHistories(25);
+    for(int evt = 0; evt < 3; ++evt)
+        EXPECT_TRUE(reader.ReadThisEventPrimaryVertexVector(evt).empty());
+    EXPECT_EQ(nApplied, 3 * 25);
+}
+
+// Each run (control point) reads the same histories once the chunks are rewound,
+// whatever has been read before
+TEST(IaeaPhspReaderTest, RewoundChunksRepeatTheRun){
+    auto fileName = WritePhsp("IaeaPhspReaderTest_Rewind", 100);
+    G4IAEAphspReader reader(fileName);
+    std::vector<std::vector<std::pair<int,int>>> runs;
+    for(int nEvents : {10, 25, 10}){
+        G4IAEAphspReader::SetTotalParallelRuns(2);
+        G4IAEAphspReader::RewindChunks();
+        reader.SetParallelRun(2);
+        runs.emplace_back();
+        for(int evt = 0; evt < nEvents; ++evt){
+            for(auto vertex : reader.ReadThisEventPrimaryVertexVector(evt)){
+                runs.back().push_back(RecordId(vertex));
+                delete vertex;
+            }
+        }
+    }
+    EXPECT_EQ(runs.front(), runs.back());
+    EXPECT_EQ(runs.front().front(), std::make_pair(50, 0));
+}
+
+// Tasking: the bunches of events are taken by whichever thread is free, each bunch reads its own chunk
+// (as set up by UIManager and IaeaPrimaryGenerator), thus no record is read twice within the run
+TEST(IaeaPhspReaderTest, TaskingBunchesReadDisjointRecords){
+    auto fileName = WritePhsp("IaeaPhspReaderTest_Tasking", 120);
+    int nEvents = 100, eventsPerTask = 5, nThreads = 4;
+    int nBunches = (nEvents + eventsPerTask - 1) / eventsPerTask;
+    G4IAEAphspReader::SetTotalParallelRuns(nBunches);
+    G4IAEAphspReader::RewindChunks();
+
+    std::atomic<int> nextBunch{0};
+    std::mutex recordsMutex;
+    std::map<std::pair<int,int>, int> records;
+    std::vector<std::thread> workers;
+    for(int t = 0; t < nThreads; ++t){
+        workers.emplace_back([&](){
+            G4IAEAphspReader reader(fileName);
+            reader.UseHistoryIndex(4);
+            for(int bunch = nextBunch++; bunch < nBunches; bunch = nextBunch++){
+                for(int evt = bunch * eventsPerTask; evt < std::min(nEvents, (bunch + 1) * eventsPerTask); ++evt){
+                    reader.SetParallelRun(1 + (evt / eventsPerTask) % nBunches); // IaeaPrimaryGenerator
+                    for(auto vertex : reader.ReadThisEventPrimaryVertexVector(evt)){
+                        std::lock_guard<std::mutex> lock(recordsMutex);
+                        ++records[RecordId(vertex)];
+                        delete vertex;
+                    }
+                }
+            }
+        });
+    }
+    for(auto& worker : workers)
+        worker.join();
+
+    std::size_t nParticles = 0;
+    for(int h = 0; h < nEvents; ++h) // the first histories of the chunks, i.e. 5 of 6
+        nParticles += 1 + (h + h / eventsPerTask) % 3;
+    for(const auto& record : records)
+        EXPECT_EQ(record.second, 1) << "record " << record.first.first << "," << record.first.second << " read twice";
+    EXPECT_EQ(records.size(), nParticles);
+}
@@ -13,9 +13,11 @@
 #include "colors.hh"
 #include "G4RotationMatrix.hh"
 #include "TFileMerger.h"
+#include "RunOutputWriter.hh"
 #ifdef G4MULTITHREADED
   #include "G4Threading.hh"
   #include "G4MTRunManager.hh"
+  #include "G4RunManagerFactory.hh"
 #endif
 #include "PatientGeometry.hh"
 #include "D3DDetector.hh"
@@ -23,6 +25,10 @@
 #include "TGeoVolume.h"
 #include "TFile.h"
 #include "TTree.h"
+#include <filesystem>
+#include <mutex>
+#include <set>
+#include <stdexcept>
 
 ////////////////////////////////////////////////////////////////////////////////
 ///
@@ -40,6 +46,34 @@ RunSvc::~RunSvc() {
   configSvc()->Unregister(thisConfig()->GetName());
 }
 
+namespace {
+  /// The targets merged into by this process already (the incremental merge is being done in the writer thread)
+  std::mutex MergeTargetsMutex;
+  std::set<std::string> MergeTargets;
+
+  /// The first merge into the target (in this process) recreates it, thus the file left
+  /// by an earlier job in the same OutputDir isn't merged into; the following ones
+  /// (the incremental merge) update it, its objects are merged with the input ones
+  bool MergeIntoFile(const std::string& target, const std::vector<std::string>& files){
+    if(files.empty())
+      return true;
+    bool update = false;
+    {
+      std::lock_guard<std::mutex> lock(MergeTargetsMutex);
+      update = !MergeTargets.insert(target).second;
+    }
+    TFileMerger fm(kFALSE);
+    fm.OutputFile(target.c_str(), update ? "UPDATE" : "RECREATE");
+    for(const auto& file : files){
+      LOGSVC_DEBUG("AddFile: {}",file);
+      fm.AddFile(file.c_str());
+    }
+    if(!update)
+      return fm.Merge();
+    return fm.PartialMerge(TFileMerger::kAll | TFileMerger::kIncremental);
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 ///
 RunSvc *RunSvc::GetInstance() {
@@ -74,6 +108,9 @@ void RunSvc::Configure() {
 #ifdef G4MULTITHREADED
   DefineUnit<int>("MaxNumberOfThreads");
 #endif
+  DefineUnit<int>("ControlPointProcesses"); // Number of processes the control points are distributed over
+  DefineUnit<std::string>("RunManagerType"); // Serial, MT or Tasking
+  DefineUnit<int>("EventsPerTask");          // Tasking run manager grain, 0 - the Geant4 default
   DefineUnit<long>("RNGSeed");            // Random Number Generator seed
 
   // PRIMARY GENERATOR
@@ -89,6 +126,9 @@ void RunSvc::Configure() {
   DefineUnit<bool>("SavePhSp");
   DefineUnit<std::string>("PhspInputFileName");
   DefineUnit<int>("PhspEvtVrtxMultiplicityTreshold");
+  DefineUnit<std::string>("PhspReaderType");  // stream or mmap
+  DefineUnit<int>("PhspHistoryIndexStride");  // 0 - the .IAEAindex is not used
+  DefineUnit<bool>("PhspPreFilter");
   // DefineUnit<std::string>("PhspInputPosition");
   DefineUnit<std::string>("PhspOutputFileName");
 
@@ -99,11 +139,21 @@ void RunSvc::Configure() {
   DefineUnit<bool>("PrimariesAnalysis");
   DefineUnit<bool>("BeamAnalysis");
 
+  // SCORING MANAGEMENT
+  DefineUnit<bool>("DenseScoring");       // Flat per-thread edep arrays instead of per-step VoxelHit updates
+  DefineUnit<double>("TargetDoseUncertainty");  // Relative dose uncertainty stopping the CP run, 0 - disabled
+  DefineUnit<double>("TargetDoseThreshold");    // Fraction of the max dose above which the uncertainty is checked
+  DefineUnit<int>("ConvergenceCheckInterval");  // Number of events (per thread) between the uncertainty checks
 
   // DICOM OUTPUT MANAGEMENT
   DefineUnit<bool>("GenerateCT");
 
   DefineUnit<std::string>("OutputDir");
+  DefineUnit<int>("OutputQueueSize");     // Control points buffered by the background output writer, 0 - synchronous
+  DefineUnit<std::string>("DoseOutputFormat"); // The per-voxel dose table: csv, binary (.dose) or both
+  DefineUnit<bool>("IncrementalOutputMerge"); // The control point .root files merged as soon as they are written
+  DefineUnit<double>("FieldMaskResolution"); // The plan field mask pixel pitch [mm]
+  DefineUnit<std::string>("NTupleLayout"); // The event ntuple rows: hit (row per voxel hit) or event (row per event, hits in vectors)
 
   Configurable::DefaultConfig();   // setup the default configuration for all defined units/parameters
   // Configurable::PrintConfig();
@@ -191,6 +241,15 @@ void RunSvc::DefaultConfig(const std::string &unit) {
   if (unit.compare("PhspOutputFileName") == 0) 
     thisConfig()->SetValue(unit, std::string("phasespaces"));
 
+  if (unit.compare("PhspReaderType") == 0) 
+    thisConfig()->SetTValue<std::string>(unit, std::string("mmap")); // stream or mmap
+
+  if (unit.compare("PhspHistoryIndexStride") == 0) 
+    thisConfig()->SetTValue<int>(unit, int(1024));
+
+  if (unit.compare("PhspPreFilter") == 0) 
+    thisConfig()->SetTValue<bool>(unit, true);
+
   if (unit.compare("DICOM") == 0) 
     thisConfig()->SetTValue<bool>(unit, false);
 
@@ -210,12 +269,48 @@ void RunSvc::DefaultConfig(const std::string &unit) {
   if (unit.compare("PrimariesAnalysis") == 0) 
     thisConfig()->SetTValue<bool>(unit, false);
 
+  if (unit.compare("DenseScoring") == 0) 
+    thisConfig()->SetTValue<bool>(unit, false);
+
+  if (unit.compare("ControlPointProcesses") == 0)
+    thisConfig()->SetTValue<int>(unit, int(1));
+
+  if (unit.compare("RunManagerType") == 0)
+    thisConfig()->SetTValue<std::string>(unit, std::string("MT"));
+
+  if (unit.compare("EventsPerTask") == 0)
+    thisConfig()->SetTValue<int>(unit, int(0));
+
+  if (unit.compare("TargetDoseUncertainty") == 0)
+    thisConfig()->SetTValue<double>(unit, 0.);
+
+  if (unit.compare("TargetDoseThreshold") == 0)
+    thisConfig()->SetTValue<double>(unit, 0.5);
+
+  if (unit.compare("ConvergenceCheckInterval") == 0)
+    thisConfig()->SetTValue<int>(unit, int(10000));
+
   if (unit.compare("GenerateCT") == 0) 
     thisConfig()->SetTValue<bool>(unit, false);
 
   if (unit.compare("OutputDir") == 0) 
     thisConfig()->SetTValue<std::string>(unit, std::string());
 
+  if (unit.compare("OutputQueueSize") == 0)
+    thisConfig()->SetTValue<int>(unit, int(2));
+
+  if (unit.compare("DoseOutputFormat") == 0)
+    thisConfig()->SetTValue<std::string>(unit, std::string("csv"));
+
+  if (unit.compare("IncrementalOutputMerge") == 0)
+    thisConfig()->SetTValue<bool>(unit, true);
+
+  if (unit.compare("NTupleLayout") == 0)
+    thisConfig()->SetTValue<std::string>(unit, std::string("hit"));
+
+  if (unit.compare("FieldMaskResolution") == 0)
+    thisConfig()->SetTValue<double>(unit, 0.5);
+
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -274,7 +369,21 @@ void RunSvc::Initialize(WorldConstruction* world) {
     
  
 #ifdef G4MULTITHREADED
-    m_g4RunManager = new G4MTRunManager();
+    auto runManagerType = m_configSvc->GetValue<std::string>("RunSvc", "RunManagerType");
+    LOGSVC_INFO("Launching {} run manager",runManagerType);
+    if(runManagerType == "Serial"){
+      m_g4RunManager = G4RunManagerFactory::CreateRunManager(G4RunManagerType::SerialOnly);
+      SetNofThreads(1);
+    }
+    else if(runManagerType == "MT")
+      m_g4RunManager = G4RunManagerFactory::CreateRunManager(G4RunManagerType::MTOnly);
+    else if(runManagerType == "Tasking")
+      m_g4RunManager = G4RunManagerFactory::CreateRunManager(G4RunManagerType::TaskingOnly);
+    else {
+      G4String msg = "Unknown RunManagerType: "+runManagerType+" (Serial, MT or Tasking)";
+      LOGSVC_CRITICAL(msg.data());
+      G4Exception("RunSvc", "Initialize", FatalErrorInArgument, msg);
+    }
 #else
     m_g4RunManager = new G4RunManager();
 #endif
@@ -510,7 +619,9 @@ void RunSvc::FullSimulationMode() {
 
   #ifdef G4MULTITHREADED
     auto NofThreads = m_configSvc->GetValue<int>("RunSvc", "NumberOfThreads");
-    dynamic_cast<G4MTRunManager *>(m_g4RunManager)->SetNumberOfThreads(NofThreads);
+    auto mtRunManager = dynamic_cast<G4MTRunManager *>(m_g4RunManager); // MT and Tasking
+    if(mtRunManager)
+      mtRunManager->SetNumberOfThreads(NofThreads); // the thread pool size for the Tasking one
   #endif
 
   UserG4Initialization();
@@ -575,13 +686,11 @@ void RunSvc::WriteGeometryData() const {
 ////////////////////////////////////////////////////////////////////////////////
 ///
 void RunSvc::MergeOutput(bool cleanUp) const {
-  auto output_dir = thisConfig()->GetValue<std::string>("OutputDir");
-  LOGSVC_INFO("Job output dir: {}",output_dir);
-  auto output_file = output_dir+"/"+GetJobNameLabel()+".root";
-  TFileMerger fm(kFALSE);
-  fm.OutputFile(output_file.c_str());
+  RunOutputWriter::GetInstance()->Flush(); // all the control point files have to be written already
+  auto output_file = GetMergeTarget();
+  LOGSVC_INFO("Job output dir: {}",thisConfig()->GetValue<std::string>("OutputDir"));
   // __________________________________________________________________________
-  // Handle .root output files - merge them all
+  // Handle .root output files - merge them all (the ones not merged incrementally, the pools outputs)
   auto sim_dir = ControlPoint::GetOutputDir();
   auto files_to_merge = svc::getFilesInDir(sim_dir,".root");
   auto geo_dir = GeoSvc::GetOutputDir();
@@ -591,11 +700,10 @@ void RunSvc::MergeOutput(bool cleanUp) const {
     files_to_merge.insert(std::end(files_to_merge), std::begin(additional_files_to_merge), std::end(additional_files_to_merge));
   }
   files_to_merge.insert(std::end(files_to_merge), std::begin(files_to_merge_geo), std::end(files_to_merge_geo));
-  for(const auto& file : files_to_merge){
-    LOGSVC_DEBUG("AddFile: {}",file);
-    fm.AddFile((file).c_str());
+  if(!MergeIntoFile(output_file,files_to_merge)){
+    LOGSVC_ERROR("Merging to file: {} - failed, the input files are kept!",output_file);
+    return;
   }
-  fm.Merge();
   LOGSVC_INFO("Merging to file: {} - done!",output_file);
 
   if(cleanUp){
@@ -605,3 +713,38 @@ void RunSvc::MergeOutput(bool cleanUp) const {
     }
   }
 }
+
+////////////////////////////////////////////////////////////////////////////////
+///
+std::string RunSvc::GetMergeTarget() const {
+  if(m_output_pool > 0)
+    return ControlPoint::GetOutputDir()+"/pool-"+std::to_string(m_output_pool)+".root";
+  return thisConfig()->GetValue<std::string>("OutputDir")+"/"+GetJobNameLabel()+".root";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+void RunSvc::MergeControlPointOutput(const ControlPoint& cp) const {
+  if(!thisConfig()->GetValue<bool>("IncrementalOutputMerge"))
+    return;
+  // The paths are resolved here, the writer thread doesn't touch the configuration
+  auto target = GetMergeTarget();
+  auto sim_dir = ControlPoint::GetOutputDir();
+  auto prefix = "cp-"+std::to_string(cp.GetId())+"_";
+  RunOutputWriter::GetInstance()->Submit([this, target, sim_dir, prefix](){
+    // Only the files of this control point (closed already), the next one is being written meanwhile
+    std::vector<std::string> files_to_merge;
+    for(const auto& dir : {sim_dir, sim_dir+"/subjobs"}){
+      if(!std::filesystem::is_directory(dir))
+        continue;
+      for(const auto& file : svc::getFilesInDir(dir,".root"))
+        if(std::filesystem::path(file).filename().string().rfind(prefix,0) == 0)
+          files_to_merge.emplace_back(file);
+    }
+    if(!MergeIntoFile(target,files_to_merge))
+      throw std::runtime_error("merging "+prefix+"* files into "+target+" failed");
+    for(const auto& file : files_to_merge)
+      svc::deleteFileIfExists(file);
+    LOGSVC_INFO("Merging {} #{} files to {} - done!",prefix,files_to_merge.size(),target);
+  });
+}
@@ -76,6 +76,9 @@ class RunSvc : public TomlConfigurable, Logable {
   ///
   ControlPoint* m_current_control_point = nullptr;
 
+  ///\brief The control points pool run by this process (0 - the calling one), see ControlPointScheduler
+  int m_output_pool = 0;
+
   ///\brief Virtual method implementation defining the list of configuration units for this module.
   void Configure() override;
 
@@ -92,6 +95,10 @@ class RunSvc : public TomlConfigurable, Logable {
   ///
   void MergeOutput(bool cleanUp=true) const;
 
+  ///\brief The file the control points output is merged into by this process: the job output,
+  /// or the pool one (being merged into the job output by the calling process, see MergeOutput)
+  std::string GetMergeTarget() const;
+
   ///
   void DefineControlPoints();
 
@@ -164,6 +171,14 @@ class RunSvc : public TomlConfigurable, Logable {
   ///
   void WriteGeometryData() const;
 
+  ///
+  void SetOutputPool(int pool) { m_output_pool = pool; }
+
+  ///\brief Schedule the incremental merge of the control point .root files into the merge target,
+  /// being done in the RunOutputWriter thread (after the control point outputs are written),
+  /// the merged files are removed, hence the disk usage is bounded to about one control point.
+  void MergeControlPointOutput(const ControlPoint& cp) const;
+
   ///
   const std::set<Scoring::Type>& GetScoringTypes() const { return m_scoring_types; }
   std::set<Scoring::Type>& GetScoringTypes() { return m_scoring_types; }
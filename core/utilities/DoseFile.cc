@@ -0,0 +1,182 @@
+#include "DoseFile.hh"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    ///
+    bool IsLittleEndian(){
+        const std::uint16_t probe = 1;
+        return *reinterpret_cast<const std::uint8_t*>(&probe) == 1;
+    }
+
+    ///
+    std::uint64_t Aligned(std::uint64_t offset){
+        return (offset + DoseFile::Alignment - 1) / DoseFile::Alignment * DoseFile::Alignment;
+    }
+
+    ///
+    template <typename T> void WriteValue(std::ostream& out, const char* data, std::uint64_t i){
+        T value;
+        std::memcpy(&value, data + i * sizeof(T), sizeof(T));
+        out << value;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+std::size_t DoseFile::SizeOf(DType type){
+    switch(type){
+        case DType::Int32:   return sizeof(std::int32_t);
+        case DType::Int64:   return sizeof(std::int64_t);
+        case DType::Float32: return sizeof(float);
+        case DType::Float64: return sizeof(double);
+    }
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+void DoseFile::Write(const std::string& path, Header header, const std::vector<ColumnData>& columns){
+    if(!IsLittleEndian())
+        throw std::runtime_error("DoseFile::Write:: the big-endian host is not supported");
+    std::memcpy(header.m_magic, Magic, sizeof(Magic));
+    header.m_version = Version;
+    header.m_n_columns = static_cast<std::uint32_t>(columns.size());
+    header.m_n_entries = columns.empty() ? 0 : columns.front().m_count;
+
+    std::vector<Column> directory(columns.size());
+    auto offset = Aligned(sizeof(Header) + columns.size() * sizeof(Column));
+    for(std::size_t i = 0; i < columns.size(); ++i){
+        const auto& column = columns[i];
+        if(column.m_count != header.m_n_entries)
+            throw std::runtime_error("DoseFile::Write:: the column '"+column.m_name+"' size differs from the others");
+        if(column.m_name.size() >= sizeof(Column::m_name))
+            throw std::runtime_error("DoseFile::Write:: the column name '"+column.m_name+"' is too long");
+        std::strncpy(directory[i].m_name, column.m_name.c_str(), sizeof(Column::m_name) - 1);
+        directory[i].m_dtype = static_cast<std::uint32_t>(column.m_dtype);
+        directory[i].m_offset = offset;
+        directory[i].m_count = column.m_count;
+        offset = Aligned(offset + column.m_count * SizeOf(column.m_dtype));
+    }
+
+    std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if(!file)
+        throw std::runtime_error("DoseFile::Write:: couldn't open "+path);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    file.write(reinterpret_cast<const char*>(directory.data()), directory.size() * sizeof(Column));
+    const char padding[Alignment] = {};
+    auto position = static_cast<std::uint64_t>(sizeof(Header) + directory.size() * sizeof(Column));
+    for(std::size_t i = 0; i < columns.size(); ++i){
+        file.write(padding, directory[i].m_offset - position);
+        auto bytes = columns[i].m_count * SizeOf(columns[i].m_dtype);
+        file.write(static_cast<const char*>(columns[i].m_data), bytes); // single write per column
+        position = directory[i].m_offset + bytes;
+    }
+    if(!file)
+        throw std::runtime_error("DoseFile::Write:: writing to "+path+" failed");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+DoseFile::Reader::Reader(const std::string& path) : m_path(path){
+    auto fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0)
+        throw std::runtime_error("DoseFile::Reader:: couldn't open "+path);
+    struct stat st;
+    if(fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(Header)){
+        close(fd);
+        throw std::runtime_error("DoseFile::Reader:: "+path+" is too short to be the dose file");
+    }
+    m_size = static_cast<std::size_t>(st.st_size);
+    auto data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(data == MAP_FAILED)
+        throw std::runtime_error("DoseFile::Reader:: couldn't map "+path);
+    m_data = static_cast<const char*>(data);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+DoseFile::Reader::~Reader(){
+    if(m_data)
+        munmap(const_cast<char*>(m_data), m_size);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+std::vector<std::string> DoseFile::Reader::Validate() const {
+    std::vector<std::string> problems;
+    const auto& header = GetHeader();
+    if(std::memcmp(header.m_magic, Magic, sizeof(Magic)) != 0){
+        problems.emplace_back("wrong magic, not the dose file");
+        return problems;
+    }
+    if(header.m_version != Version){
+        problems.emplace_back("not supported version "+std::to_string(header.m_version));
+        return problems;
+    }
+    if(!IsLittleEndian())
+        problems.emplace_back("the big-endian host is not supported");
+    if(sizeof(Header) + header.m_n_columns * sizeof(Column) > m_size){
+        problems.emplace_back("truncated columns directory");
+        return problems;
+    }
+    for(std::size_t i = 0; i < header.m_n_columns; ++i){
+        const auto& column = GetColumn(i);
+        std::string name(column.m_name, strnlen(column.m_name, sizeof(Column::m_name)));
+        if(name.empty() || name.size() == sizeof(Column::m_name))
+            problems.emplace_back("column #"+std::to_string(i)+": wrong name");
+        auto size = SizeOf(static_cast<DType>(column.m_dtype));
+        if(size == 0){
+            problems.emplace_back("column '"+name+"': unknown data type "+std::to_string(column.m_dtype));
+            continue;
+        }
+        if(column.m_count != header.m_n_entries)
+            problems.emplace_back("column '"+name+"': "+std::to_string(column.m_count)+" entries, "
+                                  +std::to_string(header.m_n_entries)+" expected");
+        if(column.m_offset % Alignment != 0)
+            problems.emplace_back("column '"+name+"': not aligned offset");
+        if(column.m_offset < sizeof(Header) + header.m_n_columns * sizeof(Column) || column.m_offset > m_size ||
+           column.m_count > (m_size - column.m_offset) / size) // no overflow of the data end for the damaged count
+            problems.emplace_back("column '"+name+"': data out of the file");
+    }
+    return problems;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+const DoseFile::Column* DoseFile::Reader::FindColumn(const std::string& name) const {
+    for(std::size_t i = 0; i < GetHeader().m_n_columns; ++i)
+        if(name == std::string(GetColumn(i).m_name, strnlen(GetColumn(i).m_name, sizeof(Column::m_name))))
+            return &GetColumn(i);
+    return nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+void DoseFile::Reader::ToCsv(std::ostream& out) const {
+    const auto& header = GetHeader();
+    for(std::size_t c = 0; c < header.m_n_columns; ++c)
+        out << (c > 0 ? "," : "") << std::string(GetColumn(c).m_name, strnlen(GetColumn(c).m_name, sizeof(Column::m_name)));
+    out << '\n';
+    for(std::uint64_t i = 0; i < header.m_n_entries; ++i){
+        for(std::size_t c = 0; c < header.m_n_columns; ++c){
+            const auto& column = GetColumn(c);
+            if(c > 0)
+                out << ",";
+            auto data = m_data + column.m_offset;
+            switch(static_cast<DType>(column.m_dtype)){
+                case DType::Int32:   WriteValue<std::int32_t>(out, data, i); break;
+                case DType::Int64:   WriteValue<std::int64_t>(out, data, i); break;
+                case DType::Float32: WriteValue<float>(out, data, i); break;
+                case DType::Float64: WriteValue<double>(out, data, i); break;
+            }
+        }
+        out << '\n';
+    }
+}
@@ -0,0 +1,134 @@
+#ifndef Dose3D_DOSEFILE_H
+#define Dose3D_DOSEFILE_H
+
+#include <cstdint>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+///\brief Binary, self-describing columnar dose file (.dose), alternative to the per-voxel CSV.
+/// Layout (little-endian):
+///   Header               - fixed 256 bytes: magic, version, grid/control point metadata, #columns/#entries
+///   Column[m_n_columns]  - fixed 64 bytes each: name (the CSV header label), data type, offset, count
+///   column data          - contiguous arrays, each starting at 64 bytes aligned offset
+/// Each column is written with a single write, the reader maps the file (no parsing),
+/// hence the column arrays can be used in place (e.g. numpy.memmap with the offsets).
+namespace DoseFile {
+
+    ///
+    constexpr char Magic[8] = {'G','4','R','T','D','O','S','E'};
+    constexpr std::uint32_t Version = 1;
+    constexpr std::uint64_t Alignment = 64;
+
+    ///
+    enum class DType : std::uint32_t { Int32 = 1, Int64 = 2, Float32 = 3, Float64 = 4 };
+
+    ///
+    std::size_t SizeOf(DType type);
+
+    ///
+    template <typename T> constexpr DType DTypeOf() {
+        static_assert(std::is_same_v<T,std::int32_t> || std::is_same_v<T,std::int64_t> ||
+                      std::is_same_v<T,float> || std::is_same_v<T,double>, "DoseFile:: not supported column type");
+        if constexpr (std::is_same_v<T,std::int32_t>) return DType::Int32;
+        else if constexpr (std::is_same_v<T,std::int64_t>) return DType::Int64;
+        else if constexpr (std::is_same_v<T,float>) return DType::Float32;
+        else return DType::Float64;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    ///
+    struct Header {
+        char m_magic[8] = {};
+        std::uint32_t m_version = Version;
+        std::uint32_t m_n_columns = 0;
+        std::uint64_t m_n_entries = 0;
+        std::int64_t m_n_histories = 0;
+        std::int32_t m_cp_id = -1;
+        std::int32_t m_voxelised = 0;       // the voxel ids columns are present
+        std::int32_t m_cell_shape[3] = {};  // the number of cells along X,Y,Z
+        std::int32_t m_voxel_shape[3] = {}; // the number of voxels (per cell) along X,Y,Z
+        double m_pitch[3] = {};             // the smallest spacing of the centres along X,Y,Z [mm], 0 - single
+        double m_origin[3] = {};            // the lowest centre coordinates [mm]
+        double m_rotation = 0.;             // the control point rotation [deg]
+        char m_collection[64] = {};         // the run collection name
+        char m_scoring_type[16] = {};       // Cell / Voxel
+        char m_reserved[56] = {};
+    };
+    static_assert(sizeof(Header) == 256, "DoseFile::Header has to be 256 bytes");
+
+    ///
+    struct Column {
+        char m_name[40] = {};
+        std::uint32_t m_dtype = 0;
+        std::uint32_t m_reserved = 0;
+        std::uint64_t m_offset = 0;
+        std::uint64_t m_count = 0;
+    };
+    static_assert(sizeof(Column) == 64, "DoseFile::Column has to be 64 bytes");
+
+    ////////////////////////////////////////////////////////////////////////////
+    ///\brief Non-owning view of the column data to be written
+    struct ColumnData {
+        std::string m_name;
+        DType m_dtype;
+        const void* m_data;
+        std::uint64_t m_count;
+
+        template <typename T> static ColumnData Of(const std::string& name, const std::vector<T>& data) {
+            return {name, DTypeOf<T>(), data.data(), data.size()};
+        }
+    };
+
+    /// Write the file (the header counts/magic/version are filled here), throws std::runtime_error
+    void Write(const std::string& path, Header header, const std::vector<ColumnData>& columns);
+
+    ////////////////////////////////////////////////////////////////////////////
+    ///\brief Read-only memory mapped dose file
+    class Reader {
+        private:
+            ///
+            std::string m_path;
+            const char* m_data = nullptr;
+            std::size_t m_size = 0;
+
+            ///
+            const Column* FindColumn(const std::string& name) const;
+
+        public:
+            /// Map the file, throws std::runtime_error if it can't be opened
+            explicit Reader(const std::string& path);
+
+            ///
+            ~Reader();
+
+            /// Delete the copy and move constructors
+            Reader(const Reader&) = delete;
+            Reader& operator=(const Reader&) = delete;
+
+            /// Verify the file structure, the problems found are returned (empty - the file is valid)
+            std::vector<std::string> Validate() const;
+
+            ///
+            const Header& GetHeader() const { return *reinterpret_cast<const Header*>(m_data); }
+
+            ///
+            const Column& GetColumn(std::size_t i) const { return reinterpret_cast<const Column*>(m_data + sizeof(Header))[i]; }
+
+            /// The column data in place, throws std::runtime_error for not existing column or other type
+            template <typename T> const T* Data(const std::string& name) const {
+                auto column = FindColumn(name);
+                if(!column || column->m_dtype != static_cast<std::uint32_t>(DTypeOf<T>()))
+                    throw std::runtime_error("DoseFile::Reader:: no '"+name+"' column of the requested type in "+m_path);
+                return reinterpret_cast<const T*>(m_data + column->m_offset);
+            }
+
+            /// Write the entries in the CsvRunAnalysis layout (the column names are the header labels)
+            void ToCsv(std::ostream& out) const;
+    };
+}
+
+#endif //Dose3D_DOSEFILE_H
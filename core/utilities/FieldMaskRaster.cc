@@ -0,0 +1,58 @@
+#include "FieldMaskRaster.hh"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+////////////////////////////////////////////////////////////////////////////////
+///
+std::vector<FieldMaskRaster::Point2D> FieldMaskRaster::Rasterize(double min_y, double max_y, double pitch, const RowSpans& rowSpans){
+    if(!(pitch > 0.))
+        throw std::invalid_argument("FieldMaskRaster::Rasterize:: the pitch has to be positive");
+    std::vector<Point2D> pixels;
+    Spans spans;
+    auto centre = [pitch](long i){ return (static_cast<double>(i) + 0.5) * pitch; };
+    auto j_end = static_cast<long>(std::floor(max_y / pitch - 0.5));
+    for(auto j = static_cast<long>(std::ceil(min_y / pitch - 0.5)); j <= j_end; ++j){
+        auto y = centre(j);
+        spans.clear();
+        rowSpans(y, spans);
+        for(const auto& span : spans){
+            auto i = static_cast<long>(std::ceil(span.first / pitch - 0.5));
+            if(centre(i) < span.first) // rounding
+                ++i;
+            for(; centre(i) < span.second; ++i)
+                pixels.emplace_back(centre(i), y);
+        }
+    }
+    return pixels;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+void FieldMaskRaster::PolygonSpans(const Polygon& polygon, double y, Spans& spans){
+    // The crossing x is evaluated as in the point in polygon test: the point is inside once
+    // the number of crossings to the right of it is odd, i.e. x in [c0,c1), [c2,c3), ...
+    thread_local std::vector<double> crossings;
+    crossings.clear();
+    for(std::size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++){
+        const auto& pi = polygon[i];
+        const auto& pj = polygon[j];
+        if((pi.second > y) != (pj.second > y))
+            crossings.push_back((pj.first - pi.first) * (y - pi.second) / (pj.second - pi.second) + pi.first);
+    }
+    std::sort(crossings.begin(), crossings.end());
+    for(std::size_t k = 0; k + 1 < crossings.size(); k += 2)
+        if(crossings[k] < crossings[k+1])
+            spans.emplace_back(crossings[k], crossings[k+1]);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+std::vector<FieldMaskRaster::Point2D> FieldMaskRaster::Rasterize(const Polygon& polygon, double pitch){
+    if(polygon.size() < 3)
+        return {};
+    auto [min_it, max_it] = std::minmax_element(polygon.begin(), polygon.end(),
+                                [](const Point2D& a, const Point2D& b){ return a.second < b.second; });
+    return Rasterize(min_it->second, max_it->second, pitch,
+                     [&polygon](double y, Spans& spans){ PolygonSpans(polygon, y, spans); });
+}
@@ -0,0 +1,35 @@
+#ifndef Dose3D_FIELDMASKRASTER_H
+#define Dose3D_FIELDMASKRASTER_H
+
+#include <functional>
+#include <utility>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+///\brief Deterministic scanline rasterization of the field aperture (the plan field mask).
+/// The pixel centres are placed on the fixed grid (i+0.5)*pitch, (j+0.5)*pitch, hence
+/// the mask doesn't depend on the aperture extent, and each pixel is visited once.
+/// The row is covered by the half-open spans [begin,end), the pixel is inside
+/// once its centre falls in any of them.
+namespace FieldMaskRaster {
+
+    ///
+    using Point2D = std::pair<double,double>;
+    using Polygon = std::vector<Point2D>;
+    using Spans = std::vector<std::pair<double,double>>;
+
+    /// Fill the spans of the row at the given y (the spans are cleared by the caller)
+    using RowSpans = std::function<void(double y, Spans& spans)>;
+
+    /// The pixel centres within the rows of [min_y, max_y], throws std::invalid_argument for pitch <= 0
+    std::vector<Point2D> Rasterize(double min_y, double max_y, double pitch, const RowSpans& rowSpans);
+
+    /// The even-odd spans of the polygon row, the same edge rule as the point in polygon test
+    /// (MlcSimplified::IsInField), thus the raster agrees exactly with it at the pixel centres
+    void PolygonSpans(const Polygon& polygon, double y, Spans& spans);
+
+    ///
+    std::vector<Point2D> Rasterize(const Polygon& polygon, double pitch);
+}
+
+#endif //Dose3D_FIELDMASKRASTER_H
@@ -3,7 +3,18 @@
 #include "G4Timer.hh"
 #include "toml.hh"
 #include "PrimaryGenerationAction.hh"
+#include "IaeaPrimaryGenerator.hh"
+#include "DoseConvergenceMonitor.hh"
+#include "ControlPointScheduler.hh"
+#include "RunOutputWriter.hh"
+#include <cmath>
+#include <numeric>
 #include "LogSession.hh"
+#include <pybind11/embed.h>
+#ifdef G4MULTITHREADED
+  #include "G4MTRunManager.hh"
+  #include "G4TaskRunManager.hh"
+#endif
 ////////////////////////////////////////////////////////////////////////////////
 ///
 UIManager::UIManager()
@@ -111,7 +122,20 @@ void UIManager::UserRunInitialization() {
   // }
 
 
-  for(auto& cp : controPoints){
+  // The control points can be distributed over the independent processes
+  auto nProcesses = Service<ConfigSvc>()->GetValue<int>("RunSvc", "ControlPointProcesses");
+  ControlPointScheduler scheduler(nProcesses);
+  std::vector<std::size_t> cpIndexes(controPoints.size());
+  std::iota(cpIndexes.begin(), cpIndexes.end(), 0);
+  int pool = 0;
+  if(nProcesses > 1 && controPoints.size() > 1){
+    pool = scheduler.Fork(controPoints); // before the G4 kernel initialization!
+    cpIndexes = scheduler.GetPool(pool);
+    runSvc->SetOutputPool(pool);
+  }
+
+  for(auto cpIdx : cpIndexes){
+    auto& cp = controPoints.at(cpIdx);
     runSvc->CurrentControlPoint(&cp);
     runSvc->LoadSimulationPlan();
     runSvc->G4RunManagerPtr()->SetRunIDCounter(cp.GetId());
@@ -120,8 +144,49 @@ void UIManager::UserRunInitialization() {
     InitializeG4kernel();
     for (auto ic : PreBeamOnCommands) 
       ApplyCommand(ic);
+    auto isIaeaBeam = Service<ConfigSvc>()->GetValue<std::string>("RunSvc", "BeamType") == "IAEA";
+    auto nChunks = 1;
+    #ifdef G4MULTITHREADED
+    // Tasking: the tasks (bunches of events) are taken by whichever thread is free,
+    // hence for IAEA beams there's a phsp chunk per task rather than per thread
+    auto taskRunManager = dynamic_cast<G4TaskRunManager*>(runSvc->G4RunManagerPtr());
+    auto mtRunManager = taskRunManager ? nullptr : dynamic_cast<G4MTRunManager*>(runSvc->G4RunManagerPtr());
+    if(mtRunManager && isIaeaBeam){
+      // Equal, contiguous bunches of events - one per thread and phsp chunk (see IaeaPrimaryGenerator)
+      nChunks = mtRunManager->GetNumberOfThreads();
+      mtRunManager->SetEventModulo(std::max(1, static_cast<int>((cp.GetNEvts() + nChunks - 1) / nChunks)));
+    }
+    auto eventsPerTask = Service<ConfigSvc>()->GetValue<int>("RunSvc", "EventsPerTask");
+    if(taskRunManager && isIaeaBeam && eventsPerTask <= 0) // the Geant4 default, made explicit to size the chunks
+      eventsPerTask = std::max(1, static_cast<int>(std::sqrt(cp.GetNEvts() / taskRunManager->GetNumberOfThreads())));
+    if(taskRunManager && eventsPerTask > 0){
+      // the grain keeps the tasks at least eventsPerTask long, thus Geant4 doesn't cap the event modulo
+      taskRunManager->SetEventModulo(eventsPerTask);
+      taskRunManager->SetGrainsize(std::max(1, static_cast<int>(cp.GetNEvts() / eventsPerTask)));
+      if(isIaeaBeam)
+        nChunks = std::max(1, static_cast<int>((cp.GetNEvts() + eventsPerTask - 1) / eventsPerTask));
+    }
+    #endif
+    // rewound only once the control points are distributed over the processes (pool independent results),
+    // the default workflow keeps reading the phsp on, thus the control points doses aren't correlated
+    if(isIaeaBeam)
+      IaeaPrimaryGenerator::SetUpChunks(nChunks, nProcesses > 1);
+    // nParticles is the upper limit once the uncertainty driven termination is enabled
+    auto convergence = DoseConvergenceMonitor::GetInstance();
+    convergence->Reset(cp.GetId());
+    if(nProcesses > 1)
+      ControlPointScheduler::SeedControlPoint(cp);
     LOGSVC_DEBUG("UIManager::BeamOn({})",cp.GetNEvts());
-    runSvc->G4RunManagerPtr()->BeamOn(cp.GetNEvts());
+    {
+      // No Python within the BeamOn, the GIL is yielded to the RunOutputWriter (field mask PNG)
+      pybind11::gil_scoped_release release;
+      runSvc->G4RunManagerPtr()->BeamOn(cp.GetNEvts());
+    }
+    runSvc->MergeControlPointOutput(cp); // all the control point files are closed at this point
+    convergence->Finish();
+    if(convergence->IsConverged())
+      LOGSVC_INFO("UIManager:: CP-{} stopped at the target uncertainty after #{} of {} events",
+                  cp.GetId(), convergence->GetConvergedHistories(), cp.GetNEvts());
   }
 
   // PostBeamOn commands
@@ -132,6 +197,11 @@ void UIManager::UserRunInitialization() {
     ApplyCommand(ic);
   posttimer.Stop();
   G4cout << "Post-beam elapsed time [s] : " << posttimer.GetRealElapsed() << G4endl;
+
+  RunOutputWriter::GetInstance()->Flush(); // the control points output has to be on the disk before the exit/merge
+  if(pool > 0) // the forked pool process is done here, the output is merged by the parent one
+    ControlPointScheduler::Exit();
+  scheduler.Wait();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,62 @@
+#ifndef DOSE3D_RUNNINGSTATS_HH
+#define DOSE3D_RUNNINGSTATS_HH
+
+#include "globals.hh"
+#include <algorithm>
+#include <limits>
+
+////////////////////////////////////////////////////////////////////////////////
+///\brief Online accumulator of the sample statistics (count, sum, sum of squares, min, max).
+/// Constant memory, any number of the accumulators can be merged into one (e.g. per-thread ones).
+class RunningStats {
+  public:
+  ///
+  void Add(G4double value) {
+    ++m_count;
+    m_sum += value;
+    m_sum2 += value * value;
+    m_min = std::min(m_min, value);
+    m_max = std::max(m_max, value);
+  }
+
+  ///
+  void Merge(const RunningStats& other) {
+    m_count += other.m_count;
+    m_sum += other.m_sum;
+    m_sum2 += other.m_sum2;
+    m_min = std::min(m_min, other.m_min);
+    m_max = std::max(m_max, other.m_max);
+  }
+
+  ///
+  void Reset() { *this = RunningStats(); }
+
+  ///
+  G4long GetCount() const { return m_count; }
+  G4double GetSum() const { return m_sum; }
+  G4double GetSum2() const { return m_sum2; }
+
+  /// The min/max are meaningful only if GetCount() > 0
+  G4double GetMin() const { return m_min; }
+  G4double GetMax() const { return m_max; }
+
+  ///
+  G4double GetMean() const { return m_count > 0 ? m_sum / m_count : 0.; }
+
+  /// Unbiased sample variance, 0 for less than two samples
+  G4double GetVariance() const {
+    if (m_count < 2)
+      return 0.;
+    auto variance = (m_sum2 - m_sum * m_sum / m_count) / (m_count - 1);
+    return variance > 0. ? variance : 0.; // round-off protection
+  }
+
+  private:
+  G4long m_count = 0;
+  G4double m_sum = 0.;
+  G4double m_sum2 = 0.;
+  G4double m_min = std::numeric_limits<G4double>::max();
+  G4double m_max = std::numeric_limits<G4double>::lowest();
+};
+
+#endif //DOSE3D_RUNNINGSTATS_HH
@@ -6,6 +6,8 @@
 #define DOSE3D_TYPES_HH
 
 #include <memory>
+#include <cstdint>
+#include <cassert>
 #include "G4ThreeVector.hh"
 #include "G4VPhysicalVolume.hh"
 #include "G4RotationMatrix.hh"
@@ -55,6 +57,24 @@ namespace Scoring {
     Voxel
   };
   std::string to_string(Scoring::Type type);
+
+  /// Packed (cell, voxel) index: 10 bits per axis, cell indexes in the upper 30 bits.
+  /// The cell scoring uses the cell indexes only (voxel part equal to 0).
+  /// The indexes have to be within [0, KEY_AXIS_MASK], see IsKeyIndex (checked when the scoring template is built).
+  using Key = std::uint64_t;
+  constexpr int KEY_AXIS_BITS = 10;
+  constexpr Key KEY_AXIS_MASK = (Key(1) << KEY_AXIS_BITS) - 1;
+  constexpr bool IsKeyIndex(int idx) { return idx >= 0 && Key(idx) <= KEY_AXIS_MASK; }
+  constexpr Key PackKey(int cellX, int cellY, int cellZ, int voxelX = 0, int voxelY = 0, int voxelZ = 0) {
+    assert(IsKeyIndex(cellX) && IsKeyIndex(cellY) && IsKeyIndex(cellZ) &&
+           IsKeyIndex(voxelX) && IsKeyIndex(voxelY) && IsKeyIndex(voxelZ));
+    return ((Key(cellX) & KEY_AXIS_MASK) << 5*KEY_AXIS_BITS)
+         | ((Key(cellY) & KEY_AXIS_MASK) << 4*KEY_AXIS_BITS)
+         | ((Key(cellZ) & KEY_AXIS_MASK) << 3*KEY_AXIS_BITS)
+         | ((Key(voxelX) & KEY_AXIS_MASK) << 2*KEY_AXIS_BITS)
+         | ((Key(voxelY) & KEY_AXIS_MASK) << KEY_AXIS_BITS)
+         |  (Key(voxelZ) & KEY_AXIS_MASK);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
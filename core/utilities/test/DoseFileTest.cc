@@ -0,0 +1,97 @@
+#include "gtest/gtest.h"
+#include "DoseFile.hh"
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace {
+    std::string TempFile(const std::string& name){
+        return (std::filesystem::temp_directory_path() / name).string();
+    }
+}
+
+// Write and map back the columns, the CSV conversion follows the CsvRunAnalysis layout
+TEST(DoseFileTest, RoundTrip){
+    std::vector<std::int32_t> cell_id = {0, 1, 2};
+    std::vector<double> dose = {1.5, 2.25, 1e-7};
+    std::vector<std::int64_t> steps = {3, 4, 5};
+    DoseFile::Header header;
+    header.m_cp_id = 7;
+    header.m_n_histories = 1000;
+    std::strcpy(header.m_collection, "Dose3D");
+    auto file = TempFile("DoseFileTest_RoundTrip.dose");
+    DoseFile::Write(file, header, {DoseFile::ColumnData::Of("Cell IdX", cell_id),
+                                   DoseFile::ColumnData::Of("Dose", dose),
+                                   DoseFile::ColumnData::Of("Steps", steps)});
+
+    DoseFile::Reader reader(file);
+    EXPECT_TRUE(reader.Validate().empty());
+    EXPECT_EQ(reader.GetHeader().m_cp_id, 7);
+    EXPECT_EQ(reader.GetHeader().m_n_histories, 1000);
+    EXPECT_EQ(reader.GetHeader().m_n_entries, 3u);
+    EXPECT_EQ(reader.GetHeader().m_n_columns, 3u);
+    EXPECT_STREQ(reader.GetHeader().m_collection, "Dose3D");
+    for(std::size_t i = 0; i < reader.GetHeader().m_n_columns; ++i)
+        EXPECT_EQ(reader.GetColumn(i).m_offset % DoseFile::Alignment, 0u);
+    EXPECT_DOUBLE_EQ(reader.Data<double>("Dose")[1], 2.25);
+    EXPECT_EQ(reader.Data<std::int64_t>("Steps")[2], 5);
+    EXPECT_THROW(reader.Data<float>("Dose"), std::runtime_error);
+    EXPECT_THROW(reader.Data<double>("Unknown"), std::runtime_error);
+
+    std::ostringstream csv;
+    reader.ToCsv(csv);
+    EXPECT_EQ(csv.str(), "Cell IdX,Dose,Steps\n0,1.5,3\n1,2.25,4\n2,1e-07,5\n");
+    std::remove(file.c_str());
+}
+
+// The column sizes have to match each other
+TEST(DoseFileTest, InconsistentColumns){
+    std::vector<double> a = {1., 2.};
+    std::vector<double> b = {1.};
+    auto file = TempFile("DoseFileTest_InconsistentColumns.dose");
+    EXPECT_THROW(DoseFile::Write(file, DoseFile::Header(), {DoseFile::ColumnData::Of("A", a), DoseFile::ColumnData::Of("B", b)}),
+                 std::runtime_error);
+    std::remove(file.c_str());
+}
+
+// Damaged files are reported by the validation
+TEST(DoseFileTest, Validate){
+    std::vector<double> dose(100, 1.);
+    auto file = TempFile("DoseFileTest_Validate.dose");
+    DoseFile::Write(file, DoseFile::Header(), {DoseFile::ColumnData::Of("Dose", dose)});
+    std::filesystem::resize_file(file, std::filesystem::file_size(file) - 8); // truncated data
+    {
+        DoseFile::Reader reader(file);
+        EXPECT_FALSE(reader.Validate().empty());
+    }
+    {
+        std::fstream damaged(file, std::ios::in | std::ios::out | std::ios::binary);
+        damaged.write("XXXX", 4); // magic
+    }
+    DoseFile::Reader reader(file);
+    ASSERT_EQ(reader.Validate().size(), 1u);
+    std::remove(file.c_str());
+}
+
+// The damaged entries count making the column end wrap around is reported as out of the file
+TEST(DoseFileTest, ValidateOverflowingCount){
+    std::vector<double> dose(100, 1.);
+    auto file = TempFile("DoseFileTest_Overflow.dose");
+    DoseFile::Write(file, DoseFile::Header(), {DoseFile::ColumnData::Of("Dose", dose)});
+    {
+        std::uint64_t count = std::uint64_t(1) << 61; // * sizeof(double) == 2^64
+        std::fstream damaged(file, std::ios::in | std::ios::out | std::ios::binary);
+        damaged.seekp(offsetof(DoseFile::Header, m_n_entries));
+        damaged.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        damaged.seekp(sizeof(DoseFile::Header) + offsetof(DoseFile::Column, m_count));
+        damaged.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    }
+    DoseFile::Reader reader(file);
+    auto problems = reader.Validate();
+    ASSERT_EQ(problems.size(), 1u);
+    EXPECT_NE(problems.front().find("out of the file"), std::string::npos);
+    std::remove(file.c_str());
+}
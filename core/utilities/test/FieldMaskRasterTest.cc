@@ -0,0 +1,76 @@
+#include "gtest/gtest.h"
+#include "FieldMaskRaster.hh"
+#include <cmath>
+#include <set>
+
+namespace {
+    // The point in polygon test of MlcSimplified::IsInField
+    bool IsPointInPolygon(const FieldMaskRaster::Polygon& polygon, double x, double y){
+        bool inside = false;
+        for (std::size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++) {
+            if ((polygon[i].second > y) != (polygon[j].second > y) &&
+                (x < (polygon[j].first - polygon[i].first) * (y - polygon[i].second) / (polygon[j].second - polygon[i].second) + polygon[i].first))
+                inside = !inside;
+        }
+        return inside;
+    }
+
+    // MLC like aperture: the leaf pairs of 2.5 mm width with the A/B leaf tips (cf. MlcSimplified::SetRunConfiguration)
+    FieldMaskRaster::Polygon LeavesAperture(){
+        std::vector<double> a_tips = {-10., -12.3, -15., -7.75, -3., 0., -1.1};
+        std::vector<double> b_tips = {  8.,  12.3,  10.,  7.75, -3., 5.,  4.4};
+        FieldMaskRaster::Polygon a, b;
+        for(std::size_t i = 0; i < a_tips.size(); ++i){
+            double y = -8.75 + i * 2.5;
+            a.emplace_back(a_tips[i], y - 1.25);
+            a.emplace_back(a_tips[i], y + 1.25);
+            b.emplace_back(b_tips[i], y - 1.25);
+            b.emplace_back(b_tips[i], y + 1.25);
+        }
+        a.insert(a.end(), b.rbegin(), b.rend());
+        return a;
+    }
+}
+
+// The raster equals the point in polygon test evaluated at each pixel centre of the grid
+TEST(FieldMaskRasterTest, PolygonMatchesPointInPolygon){
+    auto polygon = LeavesAperture();
+    for(double pitch : {0.5, 0.37, 1.}){
+        auto pixels = FieldMaskRaster::Rasterize(polygon, pitch);
+        std::set<std::pair<long,long>> raster;
+        for(const auto& pixel : pixels)
+            EXPECT_TRUE(raster.emplace(std::lround(pixel.first / pitch - 0.5), std::lround(pixel.second / pitch - 0.5)).second);
+        std::size_t expected = 0;
+        for(long i = -100; i < 100; ++i){
+            for(long j = -100; j < 100; ++j){
+                auto inside = IsPointInPolygon(polygon, (i + 0.5) * pitch, (j + 0.5) * pitch);
+                expected += inside;
+                EXPECT_EQ(inside, raster.count({i, j}) == 1) << "pitch " << pitch << " pixel " << i << "," << j;
+            }
+        }
+        EXPECT_EQ(expected, pixels.size());
+    }
+}
+
+// Rectangle at the grid boundaries: the half-open spans, the pixel count is exact
+TEST(FieldMaskRasterTest, Rectangle){
+    auto pixels = FieldMaskRaster::Rasterize({{-5.,-2.5},{5.,-2.5},{5.,2.5},{-5.,2.5}}, 0.5);
+    EXPECT_EQ(pixels.size(), 20u * 10u);
+    EXPECT_EQ(pixels, FieldMaskRaster::Rasterize({{-5.,-2.5},{5.,-2.5},{5.,2.5},{-5.,2.5}}, 0.5)); // deterministic
+}
+
+// Custom row spans (the elliptic field) and the degenerated inputs
+TEST(FieldMaskRasterTest, SpansAndDegenerated){
+    double a = 20., b = 10., pitch = 0.5;
+    auto pixels = FieldMaskRaster::Rasterize(-b, b, pitch, [&](double y, FieldMaskRaster::Spans& spans){
+        auto t = 1. - y * y / (b * b);
+        if(t > 0)
+            spans.emplace_back(-a * std::sqrt(t), a * std::sqrt(t));
+    });
+    for(const auto& pixel : pixels)
+        EXPECT_LT(std::pow(pixel.first / a, 2) + std::pow(pixel.second / b, 2), 1.);
+    EXPECT_NEAR(pixels.size() * pitch * pitch, M_PI * a * b, 0.02 * M_PI * a * b);
+
+    EXPECT_TRUE(FieldMaskRaster::Rasterize(FieldMaskRaster::Polygon{{0.,0.},{1.,1.}}, pitch).empty());
+    EXPECT_THROW(FieldMaskRaster::Rasterize(FieldMaskRaster::Polygon{{0.,0.},{1.,0.},{0.,1.}}, 0.), std::invalid_argument);
+}
@@ -0,0 +1,66 @@
+#ifndef CONFIGSVC_CONFIGHANDLE_HH
+#define CONFIGSVC_CONFIGHANDLE_HH
+
+#include <any>
+#include <memory>
+
+////////////////////////////////////////////////////////////////////////////////
+///
+///\class UnitCacheBase
+///\brief Type erased, per-unit cache of the value, being kept up-to-date by the ConfigModule::SetValue.
+class UnitCacheBase {
+    public:
+        ///
+        virtual ~UnitCacheBase() = default;
+
+        ///
+        virtual void Update(const std::any& value) = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+///
+template <typename T> class UnitCache : public UnitCacheBase {
+    public:
+        ///
+        explicit UnitCache(const std::any& value) : m_value(std::any_cast<T>(value)) {}
+
+        ///
+        void Update(const std::any& value) override {
+            m_value = std::any_cast<T>(value);
+        }
+
+        ///
+        T m_value;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+///
+///\class ConfigHandle
+///\brief Typed, pre-resolved access to the value of a single unit of the given module,
+/// see ConfigSvc::GetHandle. The module/unit lookup and the type check are done once, when
+/// the handle is bound, then reading the value is a plain load (intended for the hot paths).
+/// The value follows the ConfigSvc::SetValue updates, these are not synchronized with the
+/// readers, hence the runtime updates are expected in between the runs only.
+template <typename T> class ConfigHandle {
+    private:
+        ///
+        std::shared_ptr<UnitCache<T>> m_cache;
+
+    public:
+        ///
+        ConfigHandle() = default;
+
+        ///
+        explicit ConfigHandle(std::shared_ptr<UnitCache<T>> cache) : m_cache(std::move(cache)) {}
+
+        ///
+        bool IsBound() const { return m_cache != nullptr; }
+
+        ///
+        const T& Get() const { return m_cache->m_value; }
+        const T& operator*() const { return m_cache->m_value; }
+        const T* operator->() const { return &m_cache->m_value; }
+        operator const T&() const { return m_cache->m_value; }
+};
+
+#endif //CONFIGSVC_CONFIGHANDLE_HH
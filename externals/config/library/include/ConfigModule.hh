@@ -11,11 +11,13 @@
 #include <sstream>
 #include <any>
 #include <map>
+#include <mutex>
 #include <tuple>
 #include <vector>
 #include <unordered_map>
 #include <stdexcept>
 #include "UnitState.hh"
+#include "ConfigHandle.hh"
 #include "toml.hh"
 
 class Configurable;
@@ -39,6 +41,12 @@ class ConfigModule {
         /// \brief Store for keep track series of status flag
         std::map<std::string, UnitState> m_units_state;
 
+        /// \brief The values cache of the units bound to ConfigHandle
+        std::map<std::string, std::shared_ptr<UnitCacheBase>> m_unit_caches;
+
+        /// \brief The handles are bound concurrently, e.g. in the worker threads user actions constructors
+        mutable std::mutex m_unit_caches_mutex;
+
         ///
         toml::parse_result* m_toml_config = nullptr;
 
@@ -110,6 +118,9 @@ class ConfigModule {
         ///\brief The direct method for getting the actual value of the particular unit.
         template <typename T> T GetValue(const std::string& unit) const;
 
+        ///\brief Bind the typed handle to the particular unit (the value type is checked once here).
+        template <typename T> ConfigHandle<T> GetHandle(const std::string& unit);
+
         ///
         void Print() const;
 
@@ -140,6 +151,21 @@ template <typename T> T ConfigModule::GetValue(const std::string& unit) const {
     }
 }
 
+template <typename T> ConfigHandle<T> ConfigModule::GetHandle(const std::string& unit) {
+    if (!IsUnitDefined(unit))
+        throw std::invalid_argument("ConfigModule::GetHandle:: "
+                                    "Module( " + m_name + " ): Given unit (" + unit + ") is not defined.");
+    const auto& value = m_units.at(unit);
+    if (value.type() != typeid(T))
+        throw std::invalid_argument("ConfigModule::GetHandle:: "
+                                    "Module( " + m_name + " ): Given unit (" + unit + ") is of different type.");
+    std::lock_guard<std::mutex> lock(m_unit_caches_mutex);
+    auto& cache = m_unit_caches[unit];
+    if (!cache)
+        cache = std::make_shared<UnitCache<T>>(value);
+    return ConfigHandle<T>(std::static_pointer_cast<UnitCache<T>>(cache));
+}
+
 template <typename T> void ConfigModule::DefineUnit(const std::string& unit, bool isPublic){
     m_units.insert(std::make_pair(unit,T()));
     m_units_state.insert(std::make_pair(unit,UnitState()));
@@ -74,6 +74,9 @@ class ConfigSvc {
         ///\brief The main communication method for getting the actual value of the particular unit of a given module.
         template <typename T> T GetValue(const std::string& module, const std::string& unit, const char* caller = __builtin_FUNCTION()) const;
 
+        ///\brief Typed handle to the value of the particular unit of a given module, see ConfigHandle.
+        template <typename T> ConfigHandle<T> GetHandle(const std::string& module, const std::string& unit, const char* caller = __builtin_FUNCTION());
+
         ///\brief The wrapper of the Configuration::GetStatus
         bool GetStatus(const std::string& module) const;
 
@@ -124,6 +127,14 @@ template <typename T> T ConfigSvc::GetValue(const std::string& module, const std
     return m_config_modules.at(module)->thisConfig()->GetValue<T>(unit);
 }
 
+template <typename T> ConfigHandle<T> ConfigSvc::GetHandle(const std::string& module, const std::string& unit, const char* caller) {
+    if (!IsRegistered(module)){
+        auto callStack = static_cast<std::string>(caller)+"() -> ConfigSvc::GetHandle";
+        ConfigSvc::ARGUMENT_ERROR(callStack,module,"is not defined.");
+    }
+    return m_config_modules.at(module)->thisConfig()->GetHandle<T>(unit);
+}
+
 template <typename T> T ConfigSvc::GetTomlValue(const std::string& module, const std::string& unit, T&& none ) const {
     if(m_toml){
         return m_toml_config[module][unit].value_or<T>(std::move(none));
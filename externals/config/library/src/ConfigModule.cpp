@@ -29,6 +29,10 @@ void ConfigModule::SetValue(const std::string& unit, std::any value, bool is_def
             if (m_units[unit].type() == value.type()) {
                 m_units.at(unit) = value;
                 UnitStateUpdate(unit,is_default);
+                std::lock_guard<std::mutex> lock(m_unit_caches_mutex);
+                auto cache = m_unit_caches.find(unit);
+                if (cache != m_unit_caches.end())
+                    cache->second->Update(value);
             } else
                 ConfigSvc::ARGUMENT_ERROR("ConfigModule::SetValue",m_name,"Given unit (\""+ unit+"\" is of wrong type value");
         } else
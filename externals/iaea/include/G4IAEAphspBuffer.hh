@@ -0,0 +1,115 @@
+#ifndef G4IAEAphspBuffer_h
+#define G4IAEAphspBuffer_h 1
+
+#include "iaea_config.h"
+
+#include <vector>
+
+#include "globals.hh"
+
+// Struct-of-arrays buffer of the consecutive particle records of a single IAEA source.
+// The records are read in blocks (up to the buffer capacity) with a single I/O call and
+// decoded into the reusable columns, hence no allocation happens once the buffer is warmed up.
+// The records from the given index onwards can be kept while refilling (see Refill),
+// so that a history is always a contiguous span [begin,end) of the buffer indices.
+class G4IAEAphspBuffer {
+  public:
+  G4IAEAphspBuffer(G4int sourceId, G4int nExtraFloats, G4int nExtraInts, G4long capacity = 8192);
+
+  virtual ~G4IAEAphspBuffer() = default;
+
+  // Position the source at the given record (1-based), the buffer content is dropped
+  void Seek(G4long record);
+
+  // Drop the records before keepFrom index, shift the remaining ones to the front and read
+  // the following records, not further than lastRecord; returns the number of records read
+  G4long Refill(G4long keepFrom, G4long lastRecord);
+
+  inline G4long Size() const { return theSize; }
+
+  inline G4long Capacity() const { return theCapacity; }
+
+  inline G4int GetRecordLength() const { return theRecordLength; }
+
+  // Position (1-based record number) in the file of the given buffer index
+  inline G4long RecordOf(G4long i) const { return theFirstRecord + i; }
+
+  inline IAEA_I32 GetNStat(G4long i) const { return theNStat[i]; }
+
+  inline IAEA_I32 GetType(G4long i) const { return theType[i]; }
+
+  inline IAEA_Float GetEnergy(G4long i) const { return theEnergy[i]; }
+
+  inline IAEA_Float GetWeight(G4long i) const { return theWeight[i]; }
+
+  inline IAEA_Float GetX(G4long i) const { return theX[i]; }
+
+  inline IAEA_Float GetY(G4long i) const { return theY[i]; }
+
+  inline IAEA_Float GetZ(G4long i) const { return theZ[i]; }
+
+  inline IAEA_Float GetU(G4long i) const { return theU[i]; }
+
+  inline IAEA_Float GetV(G4long i) const { return theV[i]; }
+
+  inline IAEA_Float GetW(G4long i) const { return theW[i]; }
+
+  inline const IAEA_Float *GetExtraFloats(G4long i) const { return theExtraFloats.data() + i * theNumberOfExtraFloats; }
+
+  inline const IAEA_I32 *GetExtraInts(G4long i) const { return theExtraInts.data() + i * theNumberOfExtraInts; }
+
+  // Raw columns, for the batched processing (see G4IAEAphspKinematics)
+  inline const IAEA_I32 *GetTypeData() const { return theType.data(); }
+
+  inline const IAEA_Float *GetEnergyData() const { return theEnergy.data(); }
+
+  inline const IAEA_Float *GetXData() const { return theX.data(); }
+
+  inline const IAEA_Float *GetYData() const { return theY.data(); }
+
+  inline const IAEA_Float *GetZData() const { return theZ.data(); }
+
+  inline const IAEA_Float *GetUData() const { return theU.data(); }
+
+  inline const IAEA_Float *GetVData() const { return theV.data(); }
+
+  inline const IAEA_Float *GetWData() const { return theW.data(); }
+
+  protected:
+  // Move the underlying source to the given record (1-based)
+  virtual void SetSourcePosition(G4long record);
+
+  // Read and decode nRecords records following the already buffered ones into the columns
+  // starting at the dst index; returns the number of records read
+  virtual G4long ReadBlock(G4long nRecords, G4long dst);
+
+  // Decode nRecords raw records into the columns starting at the dst index
+  void Decode(const char *raw, G4long nRecords, G4long dst);
+
+  G4int theSourceReadId;
+  G4int theRecordLength;
+  G4int theNumberOfExtraFloats;
+  G4int theNumberOfExtraInts;
+
+  private:
+  void Grow(G4long capacity);
+
+  void Shift(G4long from, G4long n);
+
+  G4long theCapacity;
+  G4long theSize = 0;
+  G4long theFirstRecord = 1;
+
+  std::vector<char> theRawRecords;
+
+  std::vector<IAEA_I32> theNStat;
+  std::vector<IAEA_I32> theType;
+  std::vector<IAEA_Float> theEnergy;
+  std::vector<IAEA_Float> theWeight;
+  std::vector<IAEA_Float> theX, theY, theZ;
+  std::vector<IAEA_Float> theU, theV, theW;
+  std::vector<IAEA_Float> theExtraFloats;
+  std::vector<IAEA_I32> theExtraInts;
+};
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef G4IAEAphspFilter_h
+#define G4IAEAphspFilter_h 1
+
+class G4IAEAphspKinematics;
+
+// Stage of the reader pipeline selecting the phsp particles before any Geant4 object is created:
+// it's applied to the converted history (see G4IAEAphspKinematics::Convert) and it's expected
+// to narrow the selected records with G4IAEAphspKinematics::Select. The filters are applied
+// in the order they have been added to the reader (see G4IAEAphspReader::AddFilter).
+class G4IAEAphspFilter {
+  public:
+  virtual ~G4IAEAphspFilter() = default;
+
+  virtual void Apply(G4IAEAphspKinematics &kinematics) = 0;
+};
+
+#endif
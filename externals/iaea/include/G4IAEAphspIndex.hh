@@ -0,0 +1,73 @@
+#ifndef G4IAEAphspIndex_h
+#define G4IAEAphspIndex_h 1
+
+#include <memory>
+#include <vector>
+
+#include "G4String.hh"
+#include "globals.hh"
+
+class G4IAEAphspBuffer;
+
+// History index of the IAEA phase-space file, persisted in the <filename>.IAEAindex sidecar.
+// A new history is marked only by the nStat flag of its first record, thus splitting the file
+// by histories requires a sequential scan; the scan is done once and every stride-th history
+// start is stored together with the cumulative counts preceding it. Any history can be then
+// reached by seeking to the nearest entry and skipping at most stride-1 histories.
+class G4IAEAphspIndex {
+  public:
+  struct Entry {
+    G4long offset;             // byte offset of the history first record in the .IAEAphsp file
+    G4long particles;          // number of particles (records) stored before this history
+    G4long originalHistories;  // sum of the nStat increments before this history
+  };
+
+  static const G4int DefaultStride = 1024;
+
+  // Scan the nRecords records of the source with the given buffer, the buffer content is dropped
+  G4IAEAphspIndex(G4IAEAphspBuffer &buffer, G4long nRecords, G4int stride = DefaultStride);
+
+  // Read the sidecar of the given file ('filename' without the extension);
+  // returns nullptr if it does not exist or is outdated wrt. the .IAEAphsp file
+  static std::unique_ptr<G4IAEAphspIndex> Load(const G4String &filename, G4long nRecords, G4int recordLength);
+
+  // Write the sidecar of the given file, returns false if it could not be written
+  G4bool Save(const G4String &filename) const;
+
+  // The index of the given file loaded from its sidecar, or built (and saved) if it's missing;
+  // the index is shared by all the readers of the file within the process
+  static std::shared_ptr<const G4IAEAphspIndex> Get(const G4String &filename, G4IAEAphspBuffer &buffer,
+                                                    G4long nRecords, G4int stride = DefaultStride);
+
+  // Record (1-based) opening the given history (0-based), -1 if there's no such a history;
+  // the buffer is positioned at the nearest entry, hence its content is dropped
+  G4long FindHistory(G4long history, G4IAEAphspBuffer &buffer) const;
+
+  inline G4long GetNumberOfHistories() const { return theNumberOfHistories; }
+
+  inline G4long GetOriginalHistories() const { return theOriginalHistories; }
+
+  inline G4long GetNumberOfEntries() const { return static_cast<G4long>(theEntries.size()); }
+
+  // The i-th entry describes the history i*stride
+  inline const Entry &GetEntry(G4long i) const { return theEntries[i]; }
+
+  // First record (1-based) of the history described by the i-th entry
+  inline G4long GetEntryRecord(G4long i) const { return theEntries[i].particles + 1; }
+
+  inline G4int GetStride() const { return theStride; }
+
+  private:
+  G4IAEAphspIndex() = default;
+
+  static G4String SidecarName(const G4String &filename) { return filename + ".IAEAindex"; }
+
+  G4int theStride = DefaultStride;
+  G4int theRecordLength = 0;
+  G4long theTotalRecords = 0;
+  G4long theNumberOfHistories = 0;
+  G4long theOriginalHistories = 0;
+  std::vector<Entry> theEntries;
+};
+
+#endif
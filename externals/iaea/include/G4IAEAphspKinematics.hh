@@ -0,0 +1,88 @@
+#ifndef G4IAEAphspKinematics_h
+#define G4IAEAphspKinematics_h 1
+
+#include <vector>
+
+#include "G4RotationMatrix.hh"
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+class G4IAEAphspBuffer;
+class G4ParticleDefinition;
+
+// Batched conversion of the buffered phsp records into the primaries kinematics.
+// The global translation, the global rotations and the isocentric (collimator, gantry)
+// rotations compose into a single affine transformation, computed once per batch, which
+// is applied over the struct-of-arrays columns in branch-free loops (auto-vectorized).
+// The records passing the selection are listed in the selected indices, the G4PrimaryVertex
+// objects are to be created for these only.
+class G4IAEAphspKinematics {
+  public:
+  G4IAEAphspKinematics();
+
+  ~G4IAEAphspKinematics() = default;
+
+  // The transformation: position' = rotation * (position + translation) + offset, momentum' = rotation * momentum
+  void SetTransformation(const G4RotationMatrix &rotation, const G4ThreeVector &translation,
+                         const G4ThreeVector &offset);
+
+  // Convert the [begin,end) span of the buffer records, returns the number of the selected ones
+  G4long Convert(const G4IAEAphspBuffer &buffer, G4long begin, G4long end);
+
+  inline G4long GetNumberOfSelected() const { return static_cast<G4long>(theSelected.size()); }
+
+  // Index (relative to the converted span begin) of the s-th selected record
+  inline G4long GetSelected(G4long s) const { return theSelected[s]; }
+
+  // Keep selected only the records for which accept(j) is true, returns the number of the selected ones
+  template <typename Predicate>
+  G4long Select(Predicate accept) {
+    G4long nSelected = 0;
+    for (auto j : theSelected)
+      if (accept(j)) theSelected[nSelected++] = j;
+    theSelected.resize(nSelected);
+    return nSelected;
+  }
+
+  // Values of the j-th record of the converted span (Geant4 units)
+  inline G4ThreeVector GetPosition(G4long j) const { return G4ThreeVector(theX[j], theY[j], theZ[j]); }
+
+  inline G4ThreeVector GetMomentum(G4long j) const { return G4ThreeVector(thePx[j], thePy[j], thePz[j]); }
+
+  inline G4ParticleDefinition *GetDefinition(G4long j) const { return theDefinitions[theType[j]]; }
+
+  // IAEA particle code, 0 - not supported
+  inline G4int GetType(G4long j) const { return theType[j]; }
+
+  inline G4double GetX(G4long j) const { return theX[j]; }
+
+  inline G4double GetY(G4long j) const { return theY[j]; }
+
+  inline G4double GetZ(G4long j) const { return theZ[j]; }
+
+  inline G4double GetPx(G4long j) const { return thePx[j]; }
+
+  inline G4double GetPy(G4long j) const { return thePy[j]; }
+
+  inline G4double GetPz(G4long j) const { return thePz[j]; }
+
+  private:
+  void Resize(G4long n);
+
+  // Indexed with the IAEA particle code, 0 - not supported code
+  static const G4int NumberOfTypes = 6;
+  G4ParticleDefinition *theDefinitions[NumberOfTypes];
+  G4double theMasses[NumberOfTypes];
+
+  // Row-major rotation (the positions one includes the cm units of the IAEA file)
+  G4double thePositionRotation[9];
+  G4double theMomentumRotation[9];
+  G4double theOffset[3];
+
+  std::vector<G4int> theType;
+  std::vector<G4double> theX, theY, theZ;
+  std::vector<G4double> thePx, thePy, thePz;
+  std::vector<G4long> theSelected;
+};
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef G4IAEAphspMappedBuffer_h
+#define G4IAEAphspMappedBuffer_h 1
+
+#include "G4IAEAphspBuffer.hh"
+
+#include "G4String.hh"
+
+// Memory-mapped backend of the phsp records buffer: the .IAEAphsp file is mapped read-only
+// and the records are decoded directly from the mapped pages (no stream, no fread copy).
+// The phsp file stream of the source is released once mapped, the source keeps the header only.
+// The page cache is shared by all the readers mapping the same file, also across processes.
+class G4IAEAphspMappedBuffer : public G4IAEAphspBuffer {
+  public:
+  // 'filename' must include the path if needed, but NOT the extension
+  G4IAEAphspMappedBuffer(const G4String &filename, G4int sourceId, G4int nExtraFloats, G4int nExtraInts,
+                         G4long nRecords, G4long capacity = 8192);
+
+  ~G4IAEAphspMappedBuffer() override;
+
+  protected:
+  void SetSourcePosition(G4long record) override;
+
+  G4long ReadBlock(G4long nRecords, G4long dst) override;
+
+  private:
+  const char *theMappedFile = nullptr;
+  size_t theMappedSize = 0;
+  G4long theTotalRecords;
+};
+
+#endif
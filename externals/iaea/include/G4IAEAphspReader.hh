@@ -53,11 +53,30 @@
  *
  **********************************************************************************
  * NOTE by B.Rachwal & J.Hajduga:
- * Currenttly this reader is refactored to being run in single thread, or within the
- * lock meachanism, e.g. 
- * G4Mutex PrimGenMutex = G4MUTEX_INITIALIZER;
- * G4AutoLock lock(&PrimGenMutex);
- * ...
+ * Each reader instance owns its own IAEA source (the source id is assigned by
+ * iaea_new_source), hence the instances can be used concurrently, one per worker thread.
+ * Only opening and closing of the source is serialized internally, since it modifies
+ * the global bookkeeping of the IAEA routines. A single instance is not thread safe.
+ *
+ * The PSF is divided into theTotalParallelRuns contiguous chunks of records. A chunk
+ * starts with the first history starting at/after its nominal first record, and ends
+ * right before the first history starting after its nominal last record, hence the
+ * chunks are history-aligned and disjoint. With the history index in use (see
+ * UseHistoryIndex and G4IAEAphspIndex) the chunks are split by the number of histories
+ * and their bounds are sought with the index (G4IAEAphspIndex::FindHistory), thus they start
+ * exactly at a history start. The range of a chunk is found once and kept with its cursor. The reading position (cursor) and the number
+ * of passes over each chunk are shared between the readers, so the chunk can be taken
+ * over by another thread; once the chunk is exhausted it is recycled (wrapped around)
+ * independently of the other chunks.
+ *
+ * The cursors are not locked, instead each chunk is owned by a single reader at a time:
+ * the reader claims the chunk when it moves there, and gives it up when it moves to
+ * another chunk or it's deleted. Claiming a chunk owned by another reader is a fatal
+ * error, hence the caller has to map the events onto the chunks such that a chunk is
+ * never read by two threads at once (see IaeaPrimaryGenerator). The claim/release pair
+ * hands the cursor over to the next owner. The chunks layout (SetTotalParallelRuns) is
+ * common to all the readers, it's set by the master in between the runs only, and it
+ * releases all the chunks.
  * 
  **********************************************************************************/
 #ifndef G4IAEAphspReader_h
@@ -67,6 +86,8 @@
 
 #include "iaea_phsp.h"
 
+#include <atomic>
+#include <memory>
 #include <vector>
 
 #include "G4ThreeVector.hh"
@@ -74,6 +95,10 @@
 
 class G4Event;
 class G4PrimaryVertex;
+class G4IAEAphspBuffer;
+class G4IAEAphspIndex;
+class G4IAEAphspKinematics;
+class G4IAEAphspFilter;
 
 class G4IAEAphspReader : public G4VPrimaryGenerator {
   // ========== Constructors and destructors ==========
@@ -96,6 +121,9 @@ class G4IAEAphspReader : public G4VPrimaryGenerator {
   // ========== Class Methods ==========
 
   public:
+  // Backend of the records buffer, see G4IAEAphspBuffer and G4IAEAphspMappedBuffer
+  enum class BufferType { Stream, MemoryMapped };
+
   void GeneratePrimaryVertex(G4Event *evt) override;  // Mandatory
   std::vector<G4PrimaryVertex*> ReadThisEventPrimaryVertexVector(G4int evtId);
 
@@ -104,31 +132,60 @@ class G4IAEAphspReader : public G4VPrimaryGenerator {
 
   void ReadAndStoreFirstParticle();
 
-  void PrepareThisEvent();
-
   void ReadThisEvent();
 
   std::vector<G4PrimaryVertex*> FillThisEventPrimaryVertexVector(G4int evtId); 
 
-  void PerformRotations(G4ThreeVector &mom);
+  // Compose the translation and rotations into the transformation of theKinematics
+  void UpdateTransformation();
+
+  void LoadChunkCursor();
+
+  void StoreChunkCursor();
+
+  // Claim the ownership of the chunk cursor, fatal if it's owned by another reader
+  void AcquireChunk(G4int chunk);
 
-  void PerformGlobalRotations(G4ThreeVector &mom);
+  void ReleaseChunk();
 
-  void PerformHeadRotations(G4ThreeVector &mom);
+  void OpenSourceFile();
 
-  void RestartSourceFile();
+  void CloseSourceFile();
 
   // ========== Set/Get inline methods ==========
 
   public:
-  // inline void SetTotalParallelRuns(G4int nParallelRuns) { theTotalParallelRuns = nParallelRuns; }
+  // The chunks layout shared by all the readers: to be called by the master before the run,
+  // while no reader is reading. The cursors are kept unless the number of chunks changes.
+  static void SetTotalParallelRuns(G4int nParallelRuns);
+
+  // Move all the chunk cursors back to the chunks beginning, the passes are cleared;
+  // to be called by the master before the run (after SetTotalParallelRuns)
+  static void RewindChunks();
+
+  inline void SetParallelRun(G4int parallelRun) {
+    if (parallelRun > theTotalParallelRuns || parallelRun < 1)
+      G4Exception("G4IAEAReader::SetParallelRun()", "IAEAreader002", FatalErrorInArgument,
+                  "Error in G4IAEAphspReader::SetParallelRun()");
+    theParallelRun = parallelRun;
+  }
+
+  // To be called before the first event is read
+  void SetBufferType(BufferType type);
+
+  // Append the stage selecting the particles before the vertices are created, the reader takes the ownership
+  inline void AddFilter(G4IAEAphspFilter *filter) { theFilters.push_back(filter); }
 
-  // inline void SetParallelRun(G4int parallelRun) {
-  //   if (parallelRun > theTotalParallelRuns && parallelRun < 1)
-  //     G4Exception("G4IAEAReader::SetParallelRun()", "IAEAreader002", FatalErrorInArgument,
-  //                 "Error in G4IAEAphspReader::SetParallelRun()");
-  //   theParallelRun = parallelRun;
-  // }
+  // Load the history index from the .IAEAindex sidecar (it's built and written if missing),
+  // the chunks are then split by the number of histories. To be called before the first event is read
+  void UseHistoryIndex(G4int stride);
+
+  // The number of histories in a row with all the particles filtered out, after which
+  // ReadThisEventPrimaryVertexVector gives up and returns the empty vector
+  inline void SetMaxRejectedHistories(G4int nHistories) { theMaxRejectedHistories = nHistories; }
+
+  // The chunk reading progress (every 10%) is printed for the verbose level > 0 only
+  inline void SetVerboseLevel(G4int level) { theVerboseLevel = level; }
 
   inline void SetTimesRecycled(G4int ntimes) { theTimesRecycled = ntimes; }
 
@@ -174,23 +231,23 @@ class G4IAEAphspReader : public G4VPrimaryGenerator {
 
   G4double GetConstantVariable(const G4int index) const;
 
-  inline const std::vector<G4int>& GetParticleTypeVector() const { return theParticleTypeVector; }
-
-  inline const std::vector<G4double>& GetEnergyVector() const { return theEnergyVector; }
+  // The current history is the [begin,end) span of the buffer records
+  inline const G4IAEAphspBuffer* GetBuffer() const { return theBuffer; }
 
-  inline const std::vector<G4ThreeVector>& GetPositionVector() const { return thePositionVector; }
+  inline G4long GetHistoryBegin() const { return theHistoryBegin; }
 
-  inline const std::vector<G4ThreeVector>& GetMomentumVector() const { return theMomentumVector; }
+  inline G4long GetHistoryEnd() const { return theHistoryEnd; }
 
-  inline const std::vector<G4double>& GetWeightVector() const { return theWeightVector; }
+  // nullptr if the index is not in use (see UseHistoryIndex)
+  inline const G4IAEAphspIndex* GetHistoryIndex() const { return theHistoryIndex.get(); }
 
-  inline const std::vector<std::vector<G4double> >& GetExtraFloatsVector() const { return theExtraFloatsVector; }
+  static inline G4int GetTotalParallelRuns() { return theTotalParallelRuns; }
 
-  inline const std::vector<std::vector<G4long> >& GetExtraIntsVector() const { return theExtraIntsVector; }
+  inline G4int GetParallelRun() const { return theParallelRun; }
 
-  // inline G4int GetTotalParallelRuns() const { return theTotalParallelRuns; }
+  inline G4int GetChunkPasses() const { return theChunkPasses; }
 
-  // inline G4int GetParallelRun() const { return theParallelRun; } 
+  inline G4int GetMaxRejectedHistories() const { return theMaxRejectedHistories; }
 
   inline G4int GetTimesRecycled() const { return theTimesRecycled; }
 
@@ -224,9 +281,8 @@ class G4IAEAphspReader : public G4VPrimaryGenerator {
   G4String theFileName;
   // Must include the path, but NOT the IAEA extension
 
-  // TODO: create setter. For multiple file & pararel readout?  
-  static const G4int theSourceReadId = 0; 
-  // The Id the file source has for the IAEA routines
+  G4int theSourceReadId = -1;
+  // The Id the file source has for the IAEA routines (assigned by iaea_new_source)
 
   static const G4int theAccessRead = 1;
   // A value needed to open the file in the IAEA codes
@@ -248,23 +304,64 @@ class G4IAEAphspReader : public G4VPrimaryGenerator {
   // PARTICLE PROPERTIES
   // ---------------------
 
-  std::vector<G4int> theParticleTypeVector;
-  std::vector<G4double> theEnergyVector;// =  new std::vector<G4double>;
-  std::vector<G4ThreeVector> thePositionVector;// = new std::vector<G4ThreeVector>;
-  std::vector<G4ThreeVector> theMomentumVector;// = new std::vector<G4ThreeVector>;
-  std::vector<G4double> theWeightVector;// = new std::vector<G4double>;
-  std::vector<std::vector<G4double> > theExtraFloatsVector;// = new std::vector<std::vector<G4double> >;
-  std::vector<std::vector<G4long> > theExtraIntsVector;// = new std::vector<std::vector<G4long> >;
+  G4IAEAphspBuffer *theBuffer = nullptr;
+  // Records read in blocks, decoded into the struct of arrays
+
+  G4IAEAphspKinematics *theKinematics = nullptr;
+  // Transformed positions and momenta of the current history, computed in a batch
+
+  std::vector<G4IAEAphspFilter*> theFilters;
+  // Applied to the converted history, the vertices are created for the selected particles only
+
+  std::shared_ptr<const G4IAEAphspIndex> theHistoryIndex;
+  // Offsets of every stride-th history start, shared by the readers of the file
+
+  G4long theHistoryBegin = 0;
+  G4long theHistoryEnd = 0;
+  // Span of the buffer records of the current history,
+  // the record at theHistoryEnd opens the next one (see thePendingParticle)
 
   // -------------------
   // COUNTERS AND FLAGS
   // -------------------
 
-  // G4int theTotalParallelRuns;
-  // // For parallel runs, number of fragments in which the PSF is divided into
+  static G4int theTotalParallelRuns;
+  // For parallel runs, number of fragments in which the PSF is divided into
+
+  G4int theParallelRun = 1;
+  // Sets the fragment of PSF where the particles must be read from
+
+  G4int theCurrentChunk = 0;
+  // The fragment of PSF the source is currently positioned in (0 - none)
+
+  G4long theChunkFirstParticle = 1;
+  G4long theChunkLastParticle = -1;
+  // Range of records (1-based) of the current fragment, nominal or sought with the history index
+
+  G4int theChunkPasses = 0;
+  // Number of times the current fragment has been already fully read
+
+  struct ChunkCursor {
+    G4long nextParticle = 0;  // record opening the next history, 0 - the chunk beginning
+    G4int passes = 0;
+    G4long firstParticle = 0;  // range of the chunk records, 0 - not found yet
+    G4long lastParticle = 0;
+    std::atomic<const G4IAEAphspReader*> owner{nullptr};  // the only reader using the cursor
+  };
+  static std::vector<ChunkCursor> theChunkCursors;
+  // Reading position of each fragment, shared by all the readers
+
+  static G4int theChunksLayout;
+  // Incremented with each SetTotalParallelRuns call, the ownership of the former layout is void
+
+  G4int theOwnedChunk = 0;
+  G4int theOwnedLayout = -1;
+  // The fragment (0 - none) this reader owns the cursor of, and the layout it belongs to
+
+  G4int theMaxRejectedHistories = 1000;
+  // Bounds the skipping of the filtered out histories within a single read
 
-  // G4int theParallelRun;
-  // // Sets the fragment of PSF where the particles must be read from
+  G4int theVerboseLevel = 0;
 
   G4int theTimesRecycled = 0;
   // Set the number of times that each particle is recycled (not repeated)
@@ -276,11 +373,11 @@ class G4IAEAphspReader : public G4VPrimaryGenerator {
   G4long theCurrentParticle = 0;
   // Number to store the current particle position in PSF
 
-  G4bool theEndOfFile = false;
-  // Flag active when the file has reached the end
+  G4bool thePendingParticle = false;
+  // Flag active when the last stored particle opens the next history
 
   G4bool theLastGenerated = true; // MAC to make the file 'restart' in the first event.
-  // Flag active only when the last particle has been simulated
+  // Flag active only when the last history of the current chunk has been read
 
   // ------------------------
   // SPATIAL TRANSFORMATIONS
@@ -331,6 +331,58 @@ IAEA_EXTERN_C IAEA_EXPORT void iaea_get_particle(const IAEA_I32 *id, IAEA_I32 *n
                                                  IAEA_Float *w, /* direction in cartesian coordinates*/
                                                  IAEA_Float *extra_floats, IAEA_I32 *extra_ints);
 
+/**************************************************************************
+* Record length
+*
+* Set record_length to the number of bytes of a single particle record
+* stored in the phase space file of the source with Id id.
+* Set record_length to -1, if a source with Id id does not exist.
+**************************************************************************/
+IAEA_EXTERN_C IAEA_EXPORT void iaea_get_record_length(const IAEA_I32 *id, IAEA_I32 *record_length);
+
+/**************************************************************************
+* Read a block of records
+*
+* Read up to n_max consecutive raw particle records from the current position
+* of the source with Id id into buffer (n_max*record_length bytes at least)
+* with a single I/O call. n_read is set to the number of complete records read
+* (0 at the end of file), or to -1 if a source with Id id does not exist.
+**************************************************************************/
+IAEA_EXTERN_C IAEA_EXPORT void iaea_read_records(const IAEA_I32 *id, char *buffer, const IAEA_I64 *n_max,
+                                                 IAEA_I64 *n_read);
+
+/**************************************************************************
+* Release the phase space file stream
+*
+* Close the phase space file stream of the read-only source with Id id,
+* the header information is kept (e.g. to decode the records accessed
+* otherwise, see iaea_decode_particles). Any further stream access of the
+* source (iaea_set_record, iaea_read_records, ...) is then invalid.
+* result is set to 0 if successful (or already released), or to -1 if
+* a source with Id id does not exist.
+**************************************************************************/
+IAEA_EXTERN_C IAEA_EXPORT void iaea_release_phsp_file(const IAEA_I32 *id, IAEA_I32 *result);
+
+/**************************************************************************
+* Decode a block of records
+*
+* Decode n_particles consecutive raw records (as stored in the phase space
+* file of the source with Id id) from buffer into the arrays of n_particles
+* elements, following the iaea_get_particle conventions. The extra variables
+* are stored particle by particle, i.e. extra_floats[i*n_extra_float+j].
+* The header counters are not updated.
+**************************************************************************/
+IAEA_EXTERN_C IAEA_EXPORT void iaea_decode_particles(const IAEA_I32 *id, const char *buffer,
+                                                     const IAEA_I64 *n_particles, IAEA_I32 *n_stat,
+                                                     IAEA_I32 *type, /* particle type */
+                                                     IAEA_Float *E,  /* kinetic energy in MeV */
+                                                     IAEA_Float *wt, /* statistical weight */
+                                                     IAEA_Float *x, IAEA_Float *y,
+                                                     IAEA_Float *z, /* position in cartesian coordinates*/
+                                                     IAEA_Float *u, IAEA_Float *v,
+                                                     IAEA_Float *w, /* direction in cartesian coordinates*/
+                                                     IAEA_Float *extra_floats, IAEA_I32 *extra_ints);
+
 /**************************************************************************
 * Write a particle
 * n_stat = 0 for a secondary particle
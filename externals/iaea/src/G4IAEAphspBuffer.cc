@@ -0,0 +1,143 @@
+#include "G4IAEAphspBuffer.hh"
+
+#include "iaea_phsp.h"
+
+#include <algorithm>
+
+// ==================================================================================
+//  G4IAEAphspBuffer::G4IAEAphspBuffer(G4int sourceId, ...)
+// ==================================================================================
+
+G4IAEAphspBuffer::G4IAEAphspBuffer(G4int sourceId, G4int nExtraFloats, G4int nExtraInts, G4long capacity)
+  : theSourceReadId(sourceId), theNumberOfExtraFloats(nExtraFloats), theNumberOfExtraInts(nExtraInts),
+    theCapacity(0) {
+  IAEA_I32 sourceRead = static_cast<IAEA_I32>(theSourceReadId);
+  IAEA_I32 recordLength;
+  iaea_get_record_length(&sourceRead, &recordLength);
+  if (recordLength <= 0)
+    G4Exception("G4IAEAphspBuffer::G4IAEAphspBuffer()", "IAEAbuffer001", FatalException,
+                "Could not get the record length of the IAEA source");
+  theRecordLength = static_cast<G4int>(recordLength);
+  Grow(std::max(capacity, G4long(1)));
+}
+
+// ==================================================================================
+//  void G4IAEAphspBuffer::Seek(G4long record)
+// ==================================================================================
+
+void G4IAEAphspBuffer::Seek(G4long record) {
+  SetSourcePosition(record);
+  theFirstRecord = record;
+  theSize = 0;
+}
+
+// ==================================================================================
+//  void G4IAEAphspBuffer::SetSourcePosition(G4long record)
+// ==================================================================================
+
+void G4IAEAphspBuffer::SetSourcePosition(G4long record) {
+  IAEA_I32 sourceRead = static_cast<IAEA_I32>(theSourceReadId);
+  IAEA_I64 recordNum = static_cast<IAEA_I64>(record);
+  IAEA_I32 result;
+  iaea_set_record(&sourceRead, &recordNum, &result);
+  if (result != 0)
+    G4Exception("G4IAEAphspBuffer::SetSourcePosition()", "IAEAbuffer002", RunMustBeAborted,
+                "Could not set the position in the IAEA source file");
+}
+
+// ==================================================================================
+//  G4long G4IAEAphspBuffer::Refill(G4long keepFrom, G4long lastRecord)
+// ==================================================================================
+
+G4long G4IAEAphspBuffer::Refill(G4long keepFrom, G4long lastRecord) {
+  keepFrom = std::min(std::max(keepFrom, G4long(0)), theSize);
+  G4long kept = theSize - keepFrom;
+  if (keepFrom > 0 && kept > 0) Shift(keepFrom, kept);
+  theFirstRecord += keepFrom;
+  theSize = kept;
+
+  // a single history larger than the buffer
+  if (theSize == theCapacity) Grow(2 * theCapacity);
+
+  G4long nRecords = std::min(theCapacity - theSize, lastRecord - RecordOf(theSize) + 1);
+  if (nRecords <= 0) return 0;
+
+  G4long nRead = ReadBlock(nRecords, theSize);
+  theSize += nRead;
+  return nRead;
+}
+
+// ==================================================================================
+//  G4long G4IAEAphspBuffer::ReadBlock(G4long nRecords, G4long dst)
+// ==================================================================================
+
+G4long G4IAEAphspBuffer::ReadBlock(G4long nRecords, G4long dst) {
+  IAEA_I32 sourceRead = static_cast<IAEA_I32>(theSourceReadId);
+  IAEA_I64 nMax = static_cast<IAEA_I64>(nRecords);
+  IAEA_I64 nRead;
+  // the staging area of the raw records is needed only here (the mapped records are decoded in place)
+  if (theRawRecords.size() < static_cast<size_t>(theCapacity * theRecordLength))
+    theRawRecords.resize(theCapacity * theRecordLength);
+  iaea_read_records(&sourceRead, theRawRecords.data(), &nMax, &nRead);
+  if (nRead < 0)
+    G4Exception("G4IAEAphspBuffer::ReadBlock()", "IAEAbuffer003", RunMustBeAborted, "Cannot find source file");
+
+  Decode(theRawRecords.data(), static_cast<G4long>(nRead), dst);
+  return static_cast<G4long>(nRead);
+}
+
+// ==================================================================================
+//  void G4IAEAphspBuffer::Decode(const char *raw, G4long nRecords, G4long dst)
+// ==================================================================================
+
+void G4IAEAphspBuffer::Decode(const char *raw, G4long nRecords, G4long dst) {
+  if (nRecords <= 0) return;
+  IAEA_I32 sourceRead = static_cast<IAEA_I32>(theSourceReadId);
+  IAEA_I64 n = static_cast<IAEA_I64>(nRecords);
+  iaea_decode_particles(&sourceRead, raw, &n, &theNStat[dst], &theType[dst], &theEnergy[dst], &theWeight[dst],
+                        &theX[dst], &theY[dst], &theZ[dst], &theU[dst], &theV[dst], &theW[dst],
+                        theExtraFloats.data() + dst * theNumberOfExtraFloats,
+                        theExtraInts.data() + dst * theNumberOfExtraInts);
+}
+
+// ==================================================================================
+//  void G4IAEAphspBuffer::Grow(G4long capacity)
+// ==================================================================================
+
+void G4IAEAphspBuffer::Grow(G4long capacity) {
+  theCapacity = capacity;
+  theNStat.resize(theCapacity);
+  theType.resize(theCapacity);
+  theEnergy.resize(theCapacity);
+  theWeight.resize(theCapacity);
+  theX.resize(theCapacity);
+  theY.resize(theCapacity);
+  theZ.resize(theCapacity);
+  theU.resize(theCapacity);
+  theV.resize(theCapacity);
+  theW.resize(theCapacity);
+  theExtraFloats.resize(theCapacity * theNumberOfExtraFloats);
+  theExtraInts.resize(theCapacity * theNumberOfExtraInts);
+}
+
+// ==================================================================================
+//  void G4IAEAphspBuffer::Shift(G4long from, G4long n)
+// ==================================================================================
+
+void G4IAEAphspBuffer::Shift(G4long from, G4long n) {
+  auto shift = [from, n](auto &column, G4long stride) {
+    std::copy(column.begin() + from * stride, column.begin() + (from + n) * stride, column.begin());
+  };
+  shift(theNStat, 1);
+  shift(theType, 1);
+  shift(theEnergy, 1);
+  shift(theWeight, 1);
+  shift(theX, 1);
+  shift(theY, 1);
+  shift(theZ, 1);
+  shift(theU, 1);
+  shift(theV, 1);
+  shift(theW, 1);
+  shift(theExtraFloats, theNumberOfExtraFloats);
+  shift(theExtraInts, theNumberOfExtraInts);
+}
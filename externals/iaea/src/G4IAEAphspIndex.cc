@@ -0,0 +1,205 @@
+#include "G4IAEAphspIndex.hh"
+#include "G4IAEAphspBuffer.hh"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "G4AutoLock.hh"
+
+namespace {
+  // The indices shared within the process, built at most once per file
+  G4Mutex IAEAIndexMutex = G4MUTEX_INITIALIZER;
+  std::map<G4String, std::shared_ptr<const G4IAEAphspIndex>> theIndices;
+
+  // Layout of the sidecar: the header followed by nEntries x (offset, particles, originalHistories),
+  // all the numbers are written in the native byte order (as the phsp records are)
+  const char IndexMagic[8] = {'I', 'A', 'E', 'A', 'I', 'D', 'X', '\0'};
+  const std::int32_t IndexVersion = 1;
+
+  struct SidecarHeader {
+    char magic[8];
+    std::int32_t version;
+    std::int32_t stride;
+    std::int32_t recordLength;
+    std::int32_t reserved;
+    std::int64_t totalRecords;
+    std::int64_t phspFileSize;  // to detect the outdated sidecar
+    std::int64_t nHistories;
+    std::int64_t originalHistories;
+    std::int64_t nEntries;
+  };
+
+  G4bool StatPhspFile(const G4String &filename, struct stat &fileStat) {
+    G4String phspFile = filename + ".IAEAphsp";
+    return stat(phspFile.c_str(), &fileStat) == 0;
+  }
+}
+
+// ==================================================================================
+//  G4IAEAphspIndex::G4IAEAphspIndex(G4IAEAphspBuffer &buffer, ...)
+// ==================================================================================
+
+G4IAEAphspIndex::G4IAEAphspIndex(G4IAEAphspBuffer &buffer, G4long nRecords, G4int stride)
+  : theStride(stride), theRecordLength(buffer.GetRecordLength()), theTotalRecords(nRecords) {
+  if (theStride < 1)
+    G4Exception("G4IAEAphspIndex::G4IAEAphspIndex()", "IAEAindex001", FatalErrorInArgument,
+                "The history index stride must be positive");
+
+  theEntries.reserve(nRecords / theStride + 1);
+  buffer.Seek(1);
+  G4long i = 0;
+  while (true) {
+    if (i >= buffer.Size()) {
+      if (buffer.Refill(i, theTotalRecords) == 0) break;
+      i = 0;
+    }
+    IAEA_I32 nStat = buffer.GetNStat(i);
+    if (nStat > 0) {
+      if (theNumberOfHistories % theStride == 0) {
+        G4long particles = buffer.RecordOf(i) - 1;
+        theEntries.push_back({particles * theRecordLength, particles, theOriginalHistories});
+      }
+      ++theNumberOfHistories;
+      theOriginalHistories += nStat;
+    }
+    ++i;
+  }
+}
+
+// ==================================================================================
+//  std::unique_ptr<G4IAEAphspIndex> G4IAEAphspIndex::Load(const G4String &filename, ...)
+// ==================================================================================
+
+std::unique_ptr<G4IAEAphspIndex> G4IAEAphspIndex::Load(const G4String &filename, G4long nRecords,
+                                                       G4int recordLength) {
+  struct stat phspStat, indexStat;
+  G4String indexFile = SidecarName(filename);
+  if (!StatPhspFile(filename, phspStat) || stat(indexFile.c_str(), &indexStat) != 0) return nullptr;
+  if (indexStat.st_mtime < phspStat.st_mtime) return nullptr;
+
+  std::ifstream file(indexFile, std::ios::binary);
+  SidecarHeader header;
+  if (!file.read(reinterpret_cast<char *>(&header), sizeof(header))) return nullptr;
+  if (std::memcmp(header.magic, IndexMagic, sizeof(IndexMagic)) != 0 || header.version != IndexVersion ||
+      header.stride < 1 || header.recordLength != recordLength || header.totalRecords != nRecords ||
+      header.phspFileSize != static_cast<std::int64_t>(phspStat.st_size) || header.nEntries < 0)
+    return nullptr;
+
+  std::unique_ptr<G4IAEAphspIndex> index(new G4IAEAphspIndex());
+  index->theStride = header.stride;
+  index->theRecordLength = header.recordLength;
+  index->theTotalRecords = header.totalRecords;
+  index->theNumberOfHistories = header.nHistories;
+  index->theOriginalHistories = header.originalHistories;
+  index->theEntries.resize(header.nEntries);
+  for (auto &entry : index->theEntries) {
+    std::int64_t values[3];
+    if (!file.read(reinterpret_cast<char *>(values), sizeof(values))) return nullptr;
+    entry = {values[0], values[1], values[2]};
+  }
+  return index;
+}
+
+// ==================================================================================
+//  G4bool G4IAEAphspIndex::Save(const G4String &filename) const
+// ==================================================================================
+
+G4bool G4IAEAphspIndex::Save(const G4String &filename) const {
+  struct stat phspStat;
+  if (!StatPhspFile(filename, phspStat)) return false;
+
+  SidecarHeader header;
+  std::memcpy(header.magic, IndexMagic, sizeof(IndexMagic));
+  header.version = IndexVersion;
+  header.stride = theStride;
+  header.recordLength = theRecordLength;
+  header.reserved = 0;
+  header.totalRecords = theTotalRecords;
+  header.phspFileSize = static_cast<std::int64_t>(phspStat.st_size);
+  header.nHistories = theNumberOfHistories;
+  header.originalHistories = theOriginalHistories;
+  header.nEntries = static_cast<std::int64_t>(theEntries.size());
+
+  // Written aside and renamed, so that the other processes never read the partial sidecar
+  G4String indexFile = SidecarName(filename);
+  G4String tmpFile = indexFile + ".tmp" + std::to_string(getpid());
+  {
+    std::ofstream file(tmpFile, std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    for (const auto &entry : theEntries) {
+      std::int64_t values[3] = {entry.offset, entry.particles, entry.originalHistories};
+      file.write(reinterpret_cast<const char *>(values), sizeof(values));
+    }
+    if (!file) {
+      file.close();
+      std::remove(tmpFile.c_str());
+      return false;
+    }
+  }
+  if (std::rename(tmpFile.c_str(), indexFile.c_str()) != 0) {
+    std::remove(tmpFile.c_str());
+    return false;
+  }
+  return true;
+}
+
+// ==================================================================================
+//  std::shared_ptr<const G4IAEAphspIndex> G4IAEAphspIndex::Get(const G4String &filename, ...)
+// ==================================================================================
+
+std::shared_ptr<const G4IAEAphspIndex> G4IAEAphspIndex::Get(const G4String &filename, G4IAEAphspBuffer &buffer,
+                                                            G4long nRecords, G4int stride) {
+  G4AutoLock lock(&IAEAIndexMutex);
+  auto cached = theIndices.find(filename);
+  if (cached != theIndices.end()) return cached->second;
+
+  std::shared_ptr<const G4IAEAphspIndex> index = Load(filename, nRecords, buffer.GetRecordLength());
+  if (index) {
+    G4cout << "History index " << SidecarName(filename) << " loaded: " << index->GetNumberOfHistories()
+           << " histories, " << index->GetNumberOfEntries() << " entries." << G4endl;
+  } else {
+    G4cout << "Building history index of " << filename << ".IAEAphsp"
+           << " (every " << stride << " histories)..." << G4endl;
+    auto built = std::make_shared<const G4IAEAphspIndex>(buffer, nRecords, stride);
+    if (built->Save(filename))
+      G4cout << "History index " << SidecarName(filename) << " written: " << built->GetNumberOfHistories()
+             << " histories, " << built->GetNumberOfEntries() << " entries." << G4endl;
+    else
+      G4cout << "WARNING: History index " << SidecarName(filename)
+             << " could not be written, it will be rebuilt on the next run." << G4endl;
+    index = built;
+  }
+  theIndices.emplace(filename, index);
+  return index;
+}
+
+// ==================================================================================
+//  G4long G4IAEAphspIndex::FindHistory(G4long history, G4IAEAphspBuffer &buffer) const
+// ==================================================================================
+
+G4long G4IAEAphspIndex::FindHistory(G4long history, G4IAEAphspBuffer &buffer) const {
+  if (history < 0 || history >= theNumberOfHistories) return -1;
+
+  G4long record = GetEntryRecord(history / theStride);
+  G4long skip = history % theStride;
+  if (skip == 0) return record;
+
+  // Skip the histories following the indexed one
+  buffer.Seek(record + 1);
+  G4long i = 0;
+  while (true) {
+    if (i >= buffer.Size()) {
+      if (buffer.Refill(i, theTotalRecords) == 0) return -1;
+      i = 0;
+    }
+    if (buffer.GetNStat(i) > 0 && --skip == 0) return buffer.RecordOf(i);
+    ++i;
+  }
+}
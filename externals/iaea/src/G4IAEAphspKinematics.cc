@@ -0,0 +1,127 @@
+#include "G4IAEAphspKinematics.hh"
+#include "G4IAEAphspBuffer.hh"
+
+#include <cmath>
+
+#include "G4Electron.hh"
+#include "G4Gamma.hh"
+#include "G4Neutron.hh"
+#include "G4Positron.hh"
+#include "G4Proton.hh"
+
+#include "G4SystemOfUnits.hh"
+
+// ==================================================================================
+//  G4IAEAphspKinematics::G4IAEAphspKinematics()
+// ==================================================================================
+
+G4IAEAphspKinematics::G4IAEAphspKinematics() {
+  theDefinitions[0] = nullptr;
+  theDefinitions[1] = G4Gamma::Definition();
+  theDefinitions[2] = G4Electron::Definition();
+  theDefinitions[3] = G4Positron::Definition();
+  theDefinitions[4] = G4Neutron::Definition();
+  theDefinitions[5] = G4Proton::Definition();
+  theMasses[0] = 0.;
+  for (G4int t = 1; t < NumberOfTypes; ++t) theMasses[t] = theDefinitions[t]->GetPDGMass();
+
+  SetTransformation(G4RotationMatrix(), G4ThreeVector(), G4ThreeVector());
+}
+
+// ==================================================================================
+//  void G4IAEAphspKinematics::SetTransformation(const G4RotationMatrix &rotation, ...)
+// ==================================================================================
+
+void G4IAEAphspKinematics::SetTransformation(const G4RotationMatrix &rotation, const G4ThreeVector &translation,
+                                             const G4ThreeVector &offset) {
+  const G4double r[9] = {rotation.xx(), rotation.xy(), rotation.xz(),
+                         rotation.yx(), rotation.yy(), rotation.yz(),
+                         rotation.zx(), rotation.zy(), rotation.zz()};
+  for (G4int i = 0; i < 9; ++i) {
+    theMomentumRotation[i] = r[i];
+    thePositionRotation[i] = r[i] * cm;  // IAEA file stores in cm
+  }
+  // the translation is performed before the rotations
+  G4ThreeVector shift = rotation * translation + offset;
+  theOffset[0] = shift.x();
+  theOffset[1] = shift.y();
+  theOffset[2] = shift.z();
+}
+
+// ==================================================================================
+//  G4long G4IAEAphspKinematics::Convert(const G4IAEAphspBuffer &buffer, ...)
+// ==================================================================================
+
+G4long G4IAEAphspKinematics::Convert(const G4IAEAphspBuffer &buffer, G4long begin, G4long end) {
+  G4long n = end - begin;
+  Resize(n);
+  theSelected.clear();
+  if (n <= 0) return 0;
+
+  const IAEA_I32 *type = buffer.GetTypeData() + begin;
+  const IAEA_Float *energy = buffer.GetEnergyData() + begin;
+  const IAEA_Float *x = buffer.GetXData() + begin;
+  const IAEA_Float *y = buffer.GetYData() + begin;
+  const IAEA_Float *z = buffer.GetZData() + begin;
+  const IAEA_Float *u = buffer.GetUData() + begin;
+  const IAEA_Float *v = buffer.GetVData() + begin;
+  const IAEA_Float *w = buffer.GetWData() + begin;
+
+  G4int *outType = theType.data();
+  G4double *outX = theX.data(), *outY = theY.data(), *outZ = theZ.data();
+  G4double *outPx = thePx.data(), *outPy = thePy.data(), *outPz = thePz.data();
+  const G4double *pr = thePositionRotation;
+  const G4double *mr = theMomentumRotation;
+  const G4double ox = theOffset[0], oy = theOffset[1], oz = theOffset[2];
+
+  // Particle code, the not supported ones are mapped to 0
+  for (G4long j = 0; j < n; ++j) {
+    G4int t = type[j];
+    outType[j] = (t >= 1 && t < NumberOfTypes) ? t : 0;
+  }
+
+  // Positions
+  for (G4long j = 0; j < n; ++j) {
+    G4double px = x[j], py = y[j], pz = z[j];
+    outX[j] = pr[0] * px + pr[1] * py + pr[2] * pz + ox;
+    outY[j] = pr[3] * px + pr[4] * py + pr[5] * pz + oy;
+    outZ[j] = pr[6] * px + pr[7] * py + pr[8] * pz + oz;
+  }
+
+  // Momenta: the direction cosines scaled with the momentum magnitude, the mass
+  // is selected arithmetically rather than with the table lookup, to keep the loop vectorizable
+  // (the sqrt is vectorized with -fno-math-errno, see CMakeLists.txt)
+  const G4double m1 = theMasses[1], m2 = theMasses[2], m3 = theMasses[3], m4 = theMasses[4], m5 = theMasses[5];
+  for (G4long j = 0; j < n; ++j) {
+    G4int t = outType[j];
+    G4double m = (t == 1) * m1 + (t == 2) * m2 + (t == 3) * m3 + (t == 4) * m4 + (t == 5) * m5;
+    G4double ekin = static_cast<G4double>(energy[j]) * MeV;
+    G4double p = std::sqrt(ekin * (ekin + 2. * m));
+    G4double du = p * u[j], dv = p * v[j], dw = p * w[j];
+    outPx[j] = mr[0] * du + mr[1] * dv + mr[2] * dw;
+    outPy[j] = mr[3] * du + mr[4] * dv + mr[5] * dw;
+    outPz[j] = mr[6] * du + mr[7] * dv + mr[8] * dw;
+  }
+
+  // Selection
+  for (G4long j = 0; j < n; ++j)
+    if (outType[j] != 0) theSelected.push_back(j);
+
+  return GetNumberOfSelected();
+}
+
+// ==================================================================================
+//  void G4IAEAphspKinematics::Resize(G4long n)
+// ==================================================================================
+
+void G4IAEAphspKinematics::Resize(G4long n) {
+  if (n <= static_cast<G4long>(theType.size())) return;
+  theType.resize(n);
+  theX.resize(n);
+  theY.resize(n);
+  theZ.resize(n);
+  thePx.resize(n);
+  thePy.resize(n);
+  thePz.resize(n);
+  theSelected.reserve(n);
+}
@@ -0,0 +1,79 @@
+#include "G4IAEAphspMappedBuffer.hh"
+
+#include "iaea_phsp.h"
+
+#include <algorithm>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ==================================================================================
+//  G4IAEAphspMappedBuffer::G4IAEAphspMappedBuffer(const G4String &filename, ...)
+// ==================================================================================
+
+G4IAEAphspMappedBuffer::G4IAEAphspMappedBuffer(const G4String &filename, G4int sourceId, G4int nExtraFloats,
+                                               G4int nExtraInts, G4long nRecords, G4long capacity)
+  : G4IAEAphspBuffer(sourceId, nExtraFloats, nExtraInts, capacity), theTotalRecords(nRecords) {
+  G4String phspFile = filename + ".IAEAphsp";
+  int fd = open(phspFile.c_str(), O_RDONLY);
+  if (fd < 0)
+    G4Exception("G4IAEAphspMappedBuffer::G4IAEAphspMappedBuffer()", "IAEAbuffer004", FatalException,
+                "Could not open the IAEA phsp file to be mapped");
+
+  struct stat fileStat;
+  if (fstat(fd, &fileStat) != 0 ||
+      static_cast<G4long>(fileStat.st_size) < theTotalRecords * static_cast<G4long>(theRecordLength)) {
+    close(fd);
+    G4Exception("G4IAEAphspMappedBuffer::G4IAEAphspMappedBuffer()", "IAEAbuffer005", FatalException,
+                "The IAEA phsp file size does not match the header");
+  }
+
+  theMappedSize = static_cast<size_t>(fileStat.st_size);
+  void *mapped = mmap(nullptr, theMappedSize, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);  // the mapping is kept valid
+  if (mapped == MAP_FAILED)
+    G4Exception("G4IAEAphspMappedBuffer::G4IAEAphspMappedBuffer()", "IAEAbuffer006", FatalException,
+                "Could not map the IAEA phsp file");
+
+  // each reader is going through its chunk sequentially
+  madvise(mapped, theMappedSize, MADV_SEQUENTIAL);
+  theMappedFile = static_cast<const char *>(mapped);
+
+  // the source stream isn't used anymore, only the header is needed to decode the records
+  IAEA_I32 sourceRead = static_cast<IAEA_I32>(theSourceReadId);
+  IAEA_I32 result;
+  iaea_release_phsp_file(&sourceRead, &result);
+}
+
+// ==================================================================================
+//  G4IAEAphspMappedBuffer::~G4IAEAphspMappedBuffer()
+// ==================================================================================
+
+G4IAEAphspMappedBuffer::~G4IAEAphspMappedBuffer() {
+  if (theMappedFile) munmap(const_cast<char *>(theMappedFile), theMappedSize);
+}
+
+// ==================================================================================
+//  void G4IAEAphspMappedBuffer::SetSourcePosition(G4long record)
+// ==================================================================================
+
+void G4IAEAphspMappedBuffer::SetSourcePosition(G4long record) {
+  // nothing to be done, the records are addressed directly (see ReadBlock)
+  if (record < 1 || record > theTotalRecords + 1)
+    G4Exception("G4IAEAphspMappedBuffer::SetSourcePosition()", "IAEAbuffer002", RunMustBeAborted,
+                "Could not set the position in the IAEA source file");
+}
+
+// ==================================================================================
+//  G4long G4IAEAphspMappedBuffer::ReadBlock(G4long nRecords, G4long dst)
+// ==================================================================================
+
+G4long G4IAEAphspMappedBuffer::ReadBlock(G4long nRecords, G4long dst) {
+  G4long first = RecordOf(dst);
+  nRecords = std::min(nRecords, theTotalRecords - first + 1);
+  if (nRecords <= 0) return 0;
+  Decode(theMappedFile + (first - 1) * static_cast<G4long>(theRecordLength), nRecords, dst);
+  return nRecords;
+}
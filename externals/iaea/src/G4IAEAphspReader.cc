@@ -55,6 +55,11 @@
  **********************************************************************************/
 
 #include "G4IAEAphspReader.hh"
+#include "G4IAEAphspBuffer.hh"
+#include "G4IAEAphspFilter.hh"
+#include "G4IAEAphspIndex.hh"
+#include "G4IAEAphspKinematics.hh"
+#include "G4IAEAphspMappedBuffer.hh"
 
 #include "iaea_phsp.h"
 #include "iaea_record.h"
@@ -62,19 +67,25 @@
 #include <cstdlib>
 #include <vector>
 
-#include "G4Electron.hh"
 #include "G4Event.hh"
-#include "G4Gamma.hh"
-#include "G4Neutron.hh"
-#include "G4Positron.hh"
 #include "G4PrimaryParticle.hh"
 #include "G4PrimaryVertex.hh"
-#include "G4Proton.hh"
+#include "G4RotationMatrix.hh"
 #include "G4String.hh"
 #include "G4ThreeVector.hh"
 
 #include "G4PhysicalConstants.hh"
 #include "G4SystemOfUnits.hh"
+#include "G4AutoLock.hh"
+
+namespace {
+  // iaea_new_source/iaea_destroy_source modify the global sources bookkeeping
+  G4Mutex IAEASourceMutex = G4MUTEX_INITIALIZER;
+}
+
+G4int G4IAEAphspReader::theTotalParallelRuns = 1;
+std::vector<G4IAEAphspReader::ChunkCursor> G4IAEAphspReader::theChunkCursors = std::vector<G4IAEAphspReader::ChunkCursor>(1);
+G4int G4IAEAphspReader::theChunksLayout = 0;
 
 // ==================================================================================
 //  G4IAEAphspReader::G4IAEAphspReader(char* filename, const G4int sourceId)
@@ -85,6 +96,8 @@ G4IAEAphspReader::G4IAEAphspReader(char *filename, G4int sourceId) {
   G4VPrimaryGenerator::particle_time = 0.0;
   G4VPrimaryGenerator::particle_position = G4ThreeVector();
   InitializeSource(filename);
+  theBuffer = new G4IAEAphspBuffer(theSourceReadId, theNumberOfExtraFloats, theNumberOfExtraInts);
+  theKinematics = new G4IAEAphspKinematics();
 }
 
 // ===================================================================================
@@ -99,36 +112,56 @@ G4IAEAphspReader::G4IAEAphspReader(G4String filename, G4int sourceId)
 // =============================================
 
 G4IAEAphspReader::~G4IAEAphspReader() {
-  // clear and delete the vectors
-  theParticleTypeVector.clear();
-  theEnergyVector.clear();
-  thePositionVector.clear();
-  theMomentumVector.clear();
-  theWeightVector.clear();
-
-  if (theNumberOfExtraFloats > 0) {
-    theExtraFloatsVector.clear();
-    theExtraFloatsTypes.clear();
-  }
+  // the chunk can be taken over by another reader
+  ReleaseChunk();
 
-  if (theNumberOfExtraInts > 0) {
-    theExtraIntsVector.clear();
-    theExtraIntsTypes.clear();
-  }
+  // clear and delete the buffers
+  delete theBuffer;
+  delete theKinematics;
+  for (auto filter : theFilters) delete filter;
+  theExtraFloatsTypes.clear();
+  theExtraIntsTypes.clear();
 
   // IAEA file have to be closed
+  CloseSourceFile();
+}
+
+// =========================================================
+//  void G4IAEAphspReader::OpenSourceFile()
+// =========================================================
+
+void G4IAEAphspReader::OpenSourceFile() {
+  G4AutoLock lock(&IAEASourceMutex);
+  char *filename = const_cast<char*>(theFileName.data());
+  IAEA_I32 sourceRead = static_cast<IAEA_I32>(theSourceReadId);
+  const IAEA_I32 accessRead = static_cast<const IAEA_I32>(theAccessRead);
+  IAEA_I32 result;
+
+  iaea_new_source(&sourceRead, filename, &accessRead, &result, theFileName.size() + 1);
+  if (sourceRead < 0)
+    G4Exception("G4IAEAphspReader::OpenSourceFile()", "IAEAreader002", RunMustBeAborted,
+                "Could not open IAEA source file to read");
+  theSourceReadId = static_cast<G4int>(sourceRead);
+}
+
+// =========================================================
+//  void G4IAEAphspReader::CloseSourceFile()
+// =========================================================
+
+void G4IAEAphspReader::CloseSourceFile() {
+  if (theSourceReadId < 0) return;
+
+  G4AutoLock lock(&IAEASourceMutex);
   const IAEA_I32 sourceRead = static_cast<const IAEA_I32>(theSourceReadId);
   IAEA_I32 result;
 
   iaea_destroy_source(&sourceRead, &result);
+  theSourceReadId = -1;
 
   if (result > 0) {
     G4cout << "File " << theFileName << ".IAEAphsp closed successfully!" << G4endl;
-  } else if (result == -2) {
-    G4Exception("G4IAEAphspReader::PerformGlobalRotations", "IAEAreader018", JustWarning,
-                "IAEAphsp may be closed bo other thread");
   } else {
-    G4Exception("G4IAEAphspReader::~G4IAEAphspReader()", "IAEAreader001", FatalException,
+    G4Exception("G4IAEAphspReader::CloseSourceFile()", "IAEAreader001", FatalException,
                 "IAEA file not closed properly");
   }
 }
@@ -139,17 +172,11 @@ G4IAEAphspReader::~G4IAEAphspReader() {
 
 void G4IAEAphspReader::InitializeSource(char *filename) {
   // Now try to open file, and check if all it's OK
-  // TODO - dodać możliwość wprowadzania do tej funkcji theSourceReadId - można będzie zakolejkować 2, 3, 5 phsp. 
+  OpenSourceFile();
 
   IAEA_I32 sourceRead = static_cast<IAEA_I32>(theSourceReadId);
-  const IAEA_I32 accessRead = static_cast<const IAEA_I32>(theAccessRead);
   IAEA_I32 result;
 
-  iaea_new_source(&sourceRead, filename, &accessRead, &result, theFileName.size() + 1);
-  if (sourceRead < 0)
-    G4Exception("G4IAEAphspReader::InitializeSource()", "IAEAreader002", RunMustBeAborted,
-                "Could not open IAEA source file to read");
-
   iaea_check_file_size_byte_order(&sourceRead, &result);
   switch (result) {
     case -1:
@@ -246,225 +273,257 @@ void G4IAEAphspReader::GeneratePrimaryVertex(G4Event *evt) {
 //  std::vector<G4PrimaryVertex*>  G4IAEAphspReader::GeneratePrimaryVertex(G4int evtId)
 // ==============================================================================
 std::vector<G4PrimaryVertex*> G4IAEAphspReader::ReadThisEventPrimaryVertexVector(G4int evtId) {
-  if (theLastGenerated) {
-    RestartSourceFile();
-    ReadAndStoreFirstParticle();
+  // the histories with all the particles filtered out are skipped, up to theMaxRejectedHistories
+  // in a row; then the empty vector is returned, it's up to the caller to give up or try again
+  std::vector<G4PrimaryVertex*> vertex_vector;
+  for (G4int nRejected = 0; vertex_vector.empty() && nRejected < theMaxRejectedHistories; ++nRejected) {
+    if (theLastGenerated || theCurrentChunk != theParallelRun || theOwnedLayout != theChunksLayout) {
+      LoadChunkCursor();
+      ReadAndStoreFirstParticle();
+    }
+    ReadThisEvent();
+    StoreChunkCursor();
+    vertex_vector = FillThisEventPrimaryVertexVector(evtId);
   }
-  ReadThisEvent();
-  return FillThisEventPrimaryVertexVector(evtId);
-
+  return vertex_vector;
 }
 
 // ==============================================================================
-//  void G4IAEAphspReader::RestartSourceFile()
+//  void G4IAEAphspReader::SetBufferType(BufferType type)
 // ==============================================================================
-void G4IAEAphspReader::RestartSourceFile() {
-  // Restart counters and flags
-  theCurrentParticle = 0;
-  theEndOfFile = false;
-  theLastGenerated = false;
+void G4IAEAphspReader::SetBufferType(BufferType type) {
+  if (theCurrentChunk != 0)
+    G4Exception("G4IAEAReader::SetBufferType()", "IAEAreader021", FatalException,
+                "The buffer type cannot be changed once the reading has started");
+
+  delete theBuffer;
+  switch (type) {
+    case BufferType::MemoryMapped:
+      theBuffer = new G4IAEAphspMappedBuffer(theFileName, theSourceReadId, theNumberOfExtraFloats,
+                                             theNumberOfExtraInts, theTotalParticles);
+      break;
+    case BufferType::Stream:
+    default:
+      theBuffer = new G4IAEAphspBuffer(theSourceReadId, theNumberOfExtraFloats, theNumberOfExtraInts);
+      break;
+  }
+}
 
-  // Clear all the vectors
-  theParticleTypeVector.clear();
-  theEnergyVector.clear();
-  thePositionVector.clear();
-  theMomentumVector.clear();
-  theWeightVector.clear();
-  if (theNumberOfExtraFloats) theExtraFloatsVector.clear();
-  if (theNumberOfExtraInts) theExtraIntsVector.clear();
+// ==============================================================================
+//  void G4IAEAphspReader::UseHistoryIndex(G4int stride)
+// ==============================================================================
+void G4IAEAphspReader::UseHistoryIndex(G4int stride) {
+  if (theCurrentChunk != 0)
+    G4Exception("G4IAEAReader::UseHistoryIndex()", "IAEAreader022", FatalException,
+                "The history index cannot be enabled once the reading has started");
 
-  // Close and open the IAEA source
-  char *filename = const_cast<char*>(theFileName.data());
-  IAEA_I32 accessRead = static_cast<IAEA_I32>(theAccessRead);
-  IAEA_I32 sourceRead = static_cast<IAEA_I32>(theSourceReadId);
-  IAEA_I32 result;
-  iaea_destroy_source(&sourceRead, &result);
-  iaea_new_source(&sourceRead, filename, &accessRead, &result, theFileName.size());
+  // Building the index moves the source, it's positioned again in LoadChunkCursor
+  theHistoryIndex = G4IAEAphspIndex::Get(theFileName, *theBuffer, theTotalParticles, stride);
 }
 
-// ===============================================================
-//  void G4IAEAphspReader::ReadAndStoreFirstParticle()
-// ===============================================================
-void G4IAEAphspReader::ReadAndStoreFirstParticle() {
-  // Particle properties
-  IAEA_I32 type, nStat=0;
-  IAEA_Float E, wt, x, y, z, u, v, w;
-  IAEA_Float extraFloats[NUM_EXTRA_FLOAT];
-  IAEA_I32 extraInts[NUM_EXTRA_LONG];
-
-  IAEA_I32 sourceRead = static_cast<IAEA_I32>(theSourceReadId);
+// ==============================================================================
+//  void G4IAEAphspReader::SetTotalParallelRuns(G4int nParallelRuns)
+// ==============================================================================
+void G4IAEAphspReader::SetTotalParallelRuns(G4int nParallelRuns) {
+  if (nParallelRuns < 1)
+    G4Exception("G4IAEAReader::SetTotalParallelRuns()", "IAEAreader020", FatalErrorInArgument,
+                "Error in G4IAEAphspReader::SetTotalParallelRuns()");
+
+  // No reader is reading at this point, the cursors (atomic owners) cannot be resized, but replaced
+  if (nParallelRuns != theTotalParallelRuns)
+    theChunkCursors = std::vector<ChunkCursor>(nParallelRuns);
+  else
+    for (auto& cursor : theChunkCursors) cursor.owner.store(nullptr, std::memory_order_release);
+  theTotalParallelRuns = nParallelRuns;
+  ++theChunksLayout;
+}
 
-  while(nStat!=1){          // unitl particle fron new history is read-in
-    theCurrentParticle++;   // linearized position of this particle in the PSF
-    iaea_get_particle(&sourceRead, &nStat, &type, &E, &wt, &x, &y, &z, &u, &v, &w, extraFloats, extraInts);
-    if (nStat == -1) {
-      G4Exception("G4IAEAphspReader::ReadAndStoreFirstParticle()", "IAEAreader009", RunMustBeAborted,
-                  "Cannot find source file");
-    } 
+// ==============================================================================
+//  void G4IAEAphspReader::RewindChunks()
+// ==============================================================================
+void G4IAEAphspReader::RewindChunks() {
+  // The readers reload the cursors, since the layout has been renewed with SetTotalParallelRuns
+  for (auto& cursor : theChunkCursors) {
+    cursor.nextParticle = 0;
+    cursor.passes = 0;
   }
+}
 
-  // -------------------------------------------------
-  //  Store the information into the data members
-  // -------------------------------------------------
-
-  theParticleTypeVector.push_back(static_cast<G4int>(type));
-  theEnergyVector.push_back(static_cast<G4double>(E));
-
-  G4ThreeVector pos, mom;
-  pos.set(static_cast<G4double>(x), static_cast<G4double>(y), static_cast<G4double>(z));
-
-  mom.set(static_cast<G4double>(u), static_cast<G4double>(v), static_cast<G4double>(w));
-
-  thePositionVector.push_back(pos);
-  theMomentumVector.push_back(mom);
-
-  theWeightVector.push_back(static_cast<G4double>(wt));
+// ==============================================================================
+//  void G4IAEAphspReader::AcquireChunk(G4int chunk)
+// ==============================================================================
+void G4IAEAphspReader::AcquireChunk(G4int chunk) {
+  const G4IAEAphspReader* noOwner = nullptr;
+  if (!theChunkCursors.at(chunk - 1).owner.compare_exchange_strong(noOwner, this, std::memory_order_acq_rel)) {
+    G4ExceptionDescription msg;
+    msg << "The phase-space chunk " << chunk << "/" << theTotalParallelRuns
+        << " is being read by another reader, the chunk cursor cannot be shared";
+    G4Exception("G4IAEAphspReader::AcquireChunk()", "IAEAreader023", FatalException, msg);
+  }
+  theOwnedChunk = chunk;
+  theOwnedLayout = theChunksLayout;
+}
 
-  if (theNumberOfExtraFloats > 0) {
-    std::vector<G4double> vExtraFloats;
-    vExtraFloats.reserve(theNumberOfExtraFloats);
+// ==============================================================================
+//  void G4IAEAphspReader::ReleaseChunk()
+// ==============================================================================
+void G4IAEAphspReader::ReleaseChunk() {
+  // the cursor is stored after each history already, the release publishes it to the next owner
+  if (theOwnedChunk > 0 && theOwnedLayout == theChunksLayout)
+    theChunkCursors.at(theOwnedChunk - 1).owner.store(nullptr, std::memory_order_release);
+  theOwnedChunk = 0;
+}
 
-    for (G4int j = 0; j < theNumberOfExtraFloats; j++) {
-      vExtraFloats.push_back(static_cast<G4double>(extraFloats[j]));
-    }
-    theExtraFloatsVector.push_back(vExtraFloats);
+// ==============================================================================
+//  void G4IAEAphspReader::LoadChunkCursor()
+// ==============================================================================
+void G4IAEAphspReader::LoadChunkCursor() {
+  // The chunk is kept while it's being recycled
+  if (theOwnedChunk != theParallelRun || theOwnedLayout != theChunksLayout) {
+    ReleaseChunk();
+    AcquireChunk(theParallelRun);
   }
 
-  if (theNumberOfExtraInts > 0) {
-    std::vector<G4long> vExtraInts;
-    vExtraInts.reserve(theNumberOfExtraInts);
-
-    for (G4int i = 0; i < theNumberOfExtraInts; i++) {
-      vExtraInts.push_back(static_cast<G4long>(extraInts[i]));
+  // Restart counters and flags
+  theCurrentChunk = theParallelRun;
+  theLastGenerated = false;
+  thePendingParticle = false;
+
+  auto& cursor = theChunkCursors.at(theCurrentChunk - 1);
+  if (cursor.firstParticle == 0) {
+    // The range is found once by the first owner, the restarts and takeovers reuse it
+    G4long nHistories = theHistoryIndex ? theHistoryIndex->GetNumberOfHistories() : 0;
+    if (nHistories >= theTotalParallelRuns) {
+      // Exact range of the chunk: the histories are split evenly, the bounds are sought with the index
+      G4long firstHistory = (theCurrentChunk - 1) * nHistories / theTotalParallelRuns;
+      G4long endHistory = theCurrentChunk * nHistories / theTotalParallelRuns;
+      cursor.firstParticle = theHistoryIndex->FindHistory(firstHistory, *theBuffer);
+      cursor.lastParticle = endHistory < nHistories ? theHistoryIndex->FindHistory(endHistory, *theBuffer) - 1
+                                                    : theTotalParticles;
+      if (cursor.firstParticle < 1 || cursor.lastParticle < cursor.firstParticle)
+        G4Exception("G4IAEAphspReader::LoadChunkCursor()", "IAEAreader024", FatalException,
+                    "The history index does not match the phase-space file");
+    } else {
+      // Nominal range of the chunk, the last one takes the remainder
+      G4long chunkSize = theTotalParticles / theTotalParallelRuns;
+      cursor.firstParticle = (theCurrentChunk - 1) * chunkSize + 1;
+      cursor.lastParticle = theCurrentChunk == theTotalParallelRuns ? theTotalParticles : theCurrentChunk * chunkSize;
     }
-    theExtraIntsVector.push_back(vExtraInts);
   }
+  theChunkFirstParticle = cursor.firstParticle;
+  theChunkLastParticle = cursor.lastParticle;
+
+  theChunkPasses = cursor.passes;
+  if (cursor.nextParticle == 0 && theChunkPasses > 0)
+    G4cout << "WARNING: Phase-space chunk " << theCurrentChunk << "/" << theTotalParallelRuns
+           << " is being recycled (pass no.: " << theChunkPasses << ")." << G4endl;
+
+  // Move the source to the reading position of this chunk, the buffered records are dropped
+  G4long record = cursor.nextParticle > 0 ? cursor.nextParticle : theChunkFirstParticle;
+  theBuffer->Seek(record);
+  theHistoryBegin = 0;
+  theHistoryEnd = 0;
+  theCurrentParticle = record - 1;
+}
 
-  //  Update theUsedOriginalParticles
-  // ---------------------------------
-
-  IAEA_I64 nUsedOriginal;
-  iaea_get_used_original_particles(&sourceRead, &nUsedOriginal);
-  theUsedOriginalParticles = static_cast<G4long>(nUsedOriginal);
+// ==============================================================================
+//  void G4IAEAphspReader::StoreChunkCursor()
+// ==============================================================================
+void G4IAEAphspReader::StoreChunkCursor() {
+  // Only the reader owning the chunk is updating its cursor
+  auto& cursor = theChunkCursors.at(theCurrentChunk - 1);
+  if (theLastGenerated) {
+    cursor.nextParticle = 0;
+    cursor.passes = theChunkPasses + 1;
+  } else {
+    cursor.nextParticle = theCurrentParticle;
+    cursor.passes = theChunkPasses;
+  }
 }
 
 // ===============================================================
-//  void G4IAEAphspReader::PrepareThisEvent()
+//  void G4IAEAphspReader::ReadAndStoreFirstParticle()
 // ===============================================================
-void G4IAEAphspReader::PrepareThisEvent() {
-  // A new event begins
-  // Geant4 Event is binded to single history from PHSP
-  // while single history can contain number of particles
-  // which here are emplaced into number of vertexes
-  // each one with single particle
-  // - this is important to calculate correlations properly
-
-
-  // Erase all the elements but the last in the vectors
-  // In case that the size of the lists is just 1, there's no need
-  // to clean up.
-
-  G4int listSizes = theParticleTypeVector.size();
-
-  if (listSizes > 1) {
-    theParticleTypeVector.erase(theParticleTypeVector.begin(), theParticleTypeVector.end() - 1);
-    theEnergyVector.erase(theEnergyVector.begin(), theEnergyVector.end() - 1);
-    thePositionVector.erase(thePositionVector.begin(), thePositionVector.end() - 1);
-    theMomentumVector.erase(theMomentumVector.begin(), theMomentumVector.end() - 1);
-    theWeightVector.erase(theWeightVector.begin(), theWeightVector.end() - 1);
-
-    if (theNumberOfExtraFloats > 0)
-      theExtraFloatsVector.erase(theExtraFloatsVector.begin(), theExtraFloatsVector.end() - 1);
-
-    if (theNumberOfExtraInts > 0)
-      theExtraIntsVector.erase(theExtraIntsVector.begin(), theExtraIntsVector.end() - 1);
+void G4IAEAphspReader::ReadAndStoreFirstParticle() {
+  // Skip the records until the particle from new history is read-in,
+  // it's kept in the buffer as the opening record of the next event
+  G4long i = theHistoryEnd;
+  while (true) {
+    if (i >= theBuffer->Size()) {
+      if (theBuffer->Refill(i, theTotalParticles) == 0)
+        G4Exception("G4IAEAphspReader::ReadAndStoreFirstParticle()", "IAEAreader009", RunMustBeAborted,
+                    "Cannot find new history in the source file");
+      i = 0;
+    }
+    if (theBuffer->GetNStat(i) > 0) break;
+    ++i;
   }
+  theHistoryBegin = i;
+  theHistoryEnd = i;
+  thePendingParticle = true;
+  theCurrentParticle = theBuffer->RecordOf(i);  // linearized position of this particle in the PSF
 }
 
 // ===============================================================
 //  void G4IAEAphspReader::ReadThisEvent()
 // ===============================================================
-
+// A new event begins
+// Geant4 Event is binded to single history from PHSP
+// while single history can contain number of particles
+// which here are emplaced into number of vertexes
+// each one with single particle
+// - this is important to calculate correlations properly
 void G4IAEAphspReader::ReadThisEvent() {
-  PrepareThisEvent();
-  // Particle properties
-  IAEA_I32 type, nStat = 0;
-  IAEA_Float E, wt, x, y, z, u, v, w;
-  IAEA_I32 extraInts[NUM_EXTRA_LONG];
-  IAEA_Float extraFloats[NUM_EXTRA_FLOAT];
-
-  IAEA_I32 sourceRead = static_cast<IAEA_I32>(theSourceReadId);
-
-  // the position of the last particle in this chunk
-  theTotalParticles;
-
-  // -------------------------------------------------
-  //  Obtain all the information needed from the file
-  // -------------------------------------------------
-  while ((nStat!=1) && !theEndOfFile) {
-    //  Read next IAEA particle
-    // -------------------------
-    theCurrentParticle++;
-    iaea_get_particle(&sourceRead, &nStat, &type, &E, &wt, &x, &y, &z, &u, &v, &w, extraFloats, extraInts);
-    if (nStat == -1) {
-      G4Exception("G4IAEAphspReader::ReadThisEvent()", "IAEAreader010", RunMustBeAborted, "Cannot find source file");
-    } 
-
-    //  Store the information into the data members
-    // ---------------------------------------------
-
-    theParticleTypeVector.push_back(static_cast<G4int>(type));
-    theEnergyVector.push_back(static_cast<G4double>(E));
-
-    G4ThreeVector pos, mom;
-    pos.set(static_cast<G4double>(x), static_cast<G4double>(y), static_cast<G4double>(z));
-
-    mom.set(static_cast<G4double>(u), static_cast<G4double>(v), static_cast<G4double>(w));
-
-    thePositionVector.push_back(pos);
-    theMomentumVector.push_back(mom);
-
-    theWeightVector.push_back(static_cast<G4double>(wt));
-
-    if (theNumberOfExtraFloats > 0) {
-      std::vector<G4double> vExtraFloats;
-      vExtraFloats.reserve(theNumberOfExtraFloats);
-      for (G4int j = 0; j < theNumberOfExtraFloats; j++) {
-        vExtraFloats.push_back(static_cast<G4double>(extraFloats[j]));
+  // The history starts with the particle opening it (read in the previous call),
+  // the buffer is refilled keeping this history records, so the history is a contiguous span
+  G4long begin = theHistoryEnd;
+  G4long i = begin + 1;
+  G4long previousParticle = theCurrentParticle;
+  thePendingParticle = false;
+  theUsedOriginalParticles += theBuffer->GetNStat(begin);
+
+  while (true) {
+    //  The end of file closes the last history of the last chunk
+    // -----------------------------------------------------------
+    if (theBuffer->RecordOf(i) > theTotalParticles) {
+      theLastGenerated = true;
+      break;
+    }
+    if (i >= theBuffer->Size()) {
+      theBuffer->Refill(begin, theTotalParticles);
+      i -= begin;
+      begin = 0;
+      if (i >= theBuffer->Size()) {  // nothing more could be read
+        theLastGenerated = true;
+        break;
       }
-      theExtraFloatsVector.push_back(vExtraFloats);
     }
 
-    if (theNumberOfExtraInts > 0) {
-      std::vector<G4long> vExtraInts;
-      vExtraInts.reserve(theNumberOfExtraInts);
-      for (G4int i = 0; i < theNumberOfExtraInts; i++) {
-        vExtraInts.push_back(static_cast<G4long>(extraInts[i]));
+    //  Check whether the particle opens the next history,
+    //  and whether this history belongs to the next chunk already
+    // ------------------------------------------------------------
+    if (theBuffer->GetNStat(i) > 0) {
+      thePendingParticle = true;
+      if (theBuffer->RecordOf(i) > theChunkLastParticle) {
+        theLastGenerated = true;
+        G4cout << "WARNING: End of Phase-space chunk " << theCurrentChunk << "/" << theTotalParallelRuns
+               << " reached during history no: " << theUsedOriginalParticles << "." << G4endl;
       }
-      theExtraIntsVector.push_back(vExtraInts);
+      break;
     }
-
-    //  Update theUsedOriginalParticles
-    // ---------------------------------
-
-    IAEA_I64 nUsedOriginal;
-    iaea_get_used_original_particles(&sourceRead, &nUsedOriginal);
-    theUsedOriginalParticles = static_cast<G4long>(nUsedOriginal);
-
-    if ((theCurrentParticle%int(theTotalParticles/10))==0){
-      std::cout << "The " << int(theCurrentParticle/(theTotalParticles/100)) << " % of the phsp file has already been read" << std::endl;
+    ++i;
+  }
+  theHistoryBegin = begin;
+  theHistoryEnd = i;
+  theCurrentParticle = thePendingParticle ? theBuffer->RecordOf(i) : theBuffer->RecordOf(i - 1);
+
+  G4long chunkSize = theChunkLastParticle - theChunkFirstParticle + 1;
+  if (theVerboseLevel > 0 && chunkSize >= 10) {
+    G4long decile = (theCurrentParticle - theChunkFirstParticle + 1) * 10 / chunkSize;
+    if (decile > (previousParticle - theChunkFirstParticle + 1) * 10 / chunkSize) {
+      G4cout << "The " << 10 * decile << " % of the phsp chunk " << theCurrentChunk << "/"
+             << theTotalParallelRuns << " has already been read" << G4endl;
     }
-
-    //  Check whether the end of file has been reached
-    //  endBuffor -> EOF is reached with the value of endBuffor particles before the actuale end.
-    // -------------------------------------------------
-    G4int endBuffor = 5;
-    if ((theCurrentParticle + endBuffor )>= theTotalParticles){
-      theEndOfFile = true;
-      theLastGenerated = true;
-      G4cout << "WARNING: End of Phase-space file reached during history no: " << theUsedOriginalParticles << "." << G4endl;
-    }  
-
   }
 }
 
@@ -472,195 +531,119 @@ void G4IAEAphspReader::ReadThisEvent() {
 //
 std::vector<G4PrimaryVertex*> G4IAEAphspReader::FillThisEventPrimaryVertexVector(G4int evtId) {
 
-  G4int listSize = theParticleTypeVector.size() -1 ; // The last particle belongs to a later event
   if(theLastGenerated){
     // Throw a warning due to the following restarting
-    G4cout << "WARNING: End of Phase-space file reached during event " << evtId << "." << G4endl;
-    G4cout << "WARNING: End of Phase-space file reached particle no.: " << theCurrentParticle << "." << G4endl;
+    G4cout << "WARNING: End of Phase-space chunk reached during event " << evtId << "." << G4endl;
+    G4cout << "WARNING: End of Phase-space chunk reached particle no.: " << theCurrentParticle << "." << G4endl;
 
   }
 
-  // loop over all the particles obtained from PSF
-  // ---------------------------------------------
-  std::vector<G4PrimaryVertex*> vertex_vector;
-  // G4cout << "G4IAEAphspReader::nVertex: "<< listSize << G4endl;
-  for (G4int k = 0; k < listSize; k++) { // 
-    // First: Particle Definition
-    // --------------------------
-
-    G4ParticleDefinition *partDef = 0;
-    switch (theParticleTypeVector.at(k)) {
-      case 1:
-        partDef = G4Gamma::Definition();
-        break;
-      case 2:
-        partDef = G4Electron::Definition();
-        break;
-      case 3:
-        partDef = G4Positron::Definition();
-        break;
-      case 4:
-        partDef = G4Neutron::Definition();
-        break;
-      case 5:
-        partDef = G4Proton::Definition();
-      default:
-        G4cout << "Exception occurred at event " << evtId << "\n"
-               << "reading particle code " << theParticleTypeVector.at(k) << "." << G4endl;
-        G4Exception("G4IAEAphspReader::FillThisEventPrimaryVertexVector()", "IAEAreader011", EventMustBeAborted,
-                    "Unknown particle code in IAEA file");
+  // convert all the particles of the history at once
+  // -------------------------------------------------
+  UpdateTransformation();
+  G4long nSelected = theKinematics->Convert(*theBuffer, theHistoryBegin, theHistoryEnd);
+
+  if (nSelected < theHistoryEnd - theHistoryBegin) {
+    for (G4long k = theHistoryBegin; k < theHistoryEnd; k++) {
+      if (theKinematics->GetType(k - theHistoryBegin) != 0) continue;
+      G4cout << "Exception occurred at event " << evtId << "\n"
+             << "reading particle code " << theBuffer->GetType(k) << "." << G4endl;
+      G4Exception("G4IAEAphspReader::FillThisEventPrimaryVertexVector()", "IAEAreader011", EventMustBeAborted,
+                  "Unknown particle code in IAEA file");
     }
+  }
 
-    // Second: Particle position, time and momentum
-    // --------------------------------------------
-
-    particle_position = thePositionVector.at(k);
-    particle_position *= cm;  // IAEA file stores in cm
-
-    G4double partMass = partDef->GetPDGMass();
-    G4double partEnergy = static_cast<G4double>(theEnergyVector.at(k)) * MeV + partMass;
-    G4double partMom = std::sqrt(partEnergy * partEnergy - partMass * partMass);
-
-    G4ThreeVector partMomVect;
-    partMomVect = theMomentumVector.at(k); // this is only a direction in cartesian coordinates
-    partMomVect *= partMom;
-
-    // Third: Translation and rotations
-    // ---------------------------------
+  // the filters are narrowing the selection on the converted records
+  for (auto filter : theFilters) {
+    if (nSelected == 0) break;
+    filter->Apply(*theKinematics);
+    nSelected = theKinematics->GetNumberOfSelected();
+  }
 
-    // Translation is performed before rotations
-    particle_position += theGlobalPhspTranslation;
-    PerformRotations(partMomVect);
+  // -------------------------------------------------------------------
+  //  Creation of the new primary particles and vertices, selected only
+  // -------------------------------------------------------------------
+  std::vector<G4PrimaryVertex*> vertex_vector;
+  vertex_vector.reserve(nSelected * (theTimesRecycled + 1));
+  for (G4long s = 0; s < nSelected; s++) {
+    G4long j = theKinematics->GetSelected(s);
+    G4ParticleDefinition *partDef = theKinematics->GetDefinition(j);
+    G4ThreeVector position = theKinematics->GetPosition(j);
+    G4ThreeVector momentum = theKinematics->GetMomentum(j);
+    G4double weight = static_cast<G4double>(theBuffer->GetWeight(theHistoryBegin + j));
 
-    // -------------------------------------------------
-    //  Creation of the new primary particle and vertex
-    // -------------------------------------------------
     // loop to take care of recycling
     for (G4int r = 0; r <= theTimesRecycled; r++) {
-      // Create the new primary particle
-      G4PrimaryParticle *particle = new G4PrimaryParticle(partDef, partMomVect.x(), partMomVect.y(), partMomVect.z());
-      
-      // TODO: Filtering logic to placed here. Note, that if the particle vector
-      // auto pEnergy = particle->GetKineticEnergy();
-      // auto pTheta = particle->GetMomentum().theta();
-      // auto x = particle_position.getX();
-      // auto y = particle_position.getY();
-      // auto pName = partDef->GetParticleName();
-      // 
-      // if(pTheta<0.2){
-      // if(pName =="gamma"){
-      // if( x > -30 && x < 30 && y > -30 && y < 30) ...
-
-      particle->SetWeight(theWeightVector.at(k));
+      G4PrimaryParticle *particle = new G4PrimaryParticle(partDef, momentum.x(), momentum.y(), momentum.z());
+      particle->SetWeight(weight);
 
       // Create the new primary vertex and set the primary to it
-      vertex_vector.push_back(new G4PrimaryVertex(particle_position, particle_time));
+      vertex_vector.push_back(new G4PrimaryVertex(position, particle_time));
       vertex_vector.back()->SetPrimary(particle);
     }
   }
-   // after filtering if is empty the ReadThisEvent method should be called again;
-  if (vertex_vector.size()<1){
-    ReadThisEvent();
-    return FillThisEventPrimaryVertexVector(evtId);
-  }
+  // after filtering if is empty the next history is read (see ReadThisEventPrimaryVertexVector)
   return vertex_vector;
 }
 
 // ==========================================================================
-//  void G4IAEAphspReader::PerformRotations(G4ThreeVector & mom)
+//  void G4IAEAphspReader::UpdateTransformation()
 // ==========================================================================
 
-void G4IAEAphspReader::PerformRotations(G4ThreeVector &mom) {
-  PerformGlobalRotations(mom);
-  PerformHeadRotations(mom);
-}
-
-// ============================================================================
-//  void G4IAEAphspReader::PerformGlobalRotations(G4ThreeVector & momentum)
-// ============================================================================
-
-void G4IAEAphspReader::PerformGlobalRotations(G4ThreeVector &momentum) {
+void G4IAEAphspReader::UpdateTransformation() {
+  // Global rotations, performed after the global translation
+  G4RotationMatrix global;
   switch (theRotationOrder) {
     case 123:
-      particle_position.rotateX(theAlpha);
-      particle_position.rotateY(theBeta);
-      particle_position.rotateZ(theGamma);
-      momentum.rotateX(theAlpha);
-      momentum.rotateY(theBeta);
-      momentum.rotateZ(theGamma);
+      global.rotateX(theAlpha);
+      global.rotateY(theBeta);
+      global.rotateZ(theGamma);
       break;
 
     case 132:
-      particle_position.rotateX(theAlpha);
-      particle_position.rotateZ(theGamma);
-      particle_position.rotateY(theBeta);
-      momentum.rotateX(theAlpha);
-      momentum.rotateZ(theGamma);
-      momentum.rotateY(theBeta);
+      global.rotateX(theAlpha);
+      global.rotateZ(theGamma);
+      global.rotateY(theBeta);
       break;
 
     case 213:
-      particle_position.rotateY(theBeta);
-      particle_position.rotateX(theAlpha);
-      particle_position.rotateZ(theGamma);
-      momentum.rotateY(theBeta);
-      momentum.rotateX(theAlpha);
-      momentum.rotateZ(theGamma);
+      global.rotateY(theBeta);
+      global.rotateX(theAlpha);
+      global.rotateZ(theGamma);
       break;
 
     case 231:
-      particle_position.rotateY(theBeta);
-      particle_position.rotateZ(theGamma);
-      particle_position.rotateX(theAlpha);
-      momentum.rotateY(theBeta);
-      momentum.rotateZ(theGamma);
-      momentum.rotateX(theAlpha);
+      global.rotateY(theBeta);
+      global.rotateZ(theGamma);
+      global.rotateX(theAlpha);
       break;
 
     case 312:
-      particle_position.rotateZ(theGamma);
-      particle_position.rotateX(theAlpha);
-      particle_position.rotateY(theBeta);
-      momentum.rotateZ(theGamma);
-      momentum.rotateX(theAlpha);
-      momentum.rotateY(theBeta);
+      global.rotateZ(theGamma);
+      global.rotateX(theAlpha);
+      global.rotateY(theBeta);
       break;
 
     case 321:
-      particle_position.rotateZ(theGamma);
-      particle_position.rotateY(theBeta);
-      particle_position.rotateX(theAlpha);
-      momentum.rotateZ(theGamma);
-      momentum.rotateY(theBeta);
-      momentum.rotateX(theAlpha);
+      global.rotateZ(theGamma);
+      global.rotateY(theBeta);
+      global.rotateX(theAlpha);
       break;
 
     default:
-      G4Exception("G4IAEAphspReader::PerformGlobalRotations", "IAEAreader017", JustWarning,
+      G4Exception("G4IAEAphspReader::UpdateTransformation", "IAEAreader017", JustWarning,
                   "invalid combination in G4IAEAphspReader::theRotationOrder\nso no global rotations are performed");
   }
-}
-
-// ==========================================================================
-//  void G4IAEAphspReader::PerformHeadRotations(G4ThreeVector & mom)
-// ==========================================================================
-
-void G4IAEAphspReader::PerformHeadRotations(G4ThreeVector &momentum) {
-  // First we need the position related to the isocenter
-  particle_position -= theIsocenterPosition;
-
-  // And now comes both rotations whose axis contain the isocenter
-
-  // First is the rotation of the collimator around its defined axis
-  particle_position.rotate(theCollimatorRotAxis, theCollimatorAngle);
-  momentum.rotate(theCollimatorRotAxis, theCollimatorAngle);
 
-  // The rotation of the complete machine is applied afterwards
-  particle_position.rotate(theGantryRotAxis, theGantryAngle);
-  momentum.rotate(theGantryRotAxis, theGantryAngle);
+  // Isocentric rotations, the collimator ALWAYS rotates first, then the complete machine
+  G4RotationMatrix head;
+  head.rotate(theCollimatorAngle, theCollimatorRotAxis);
+  head.rotate(theGantryAngle, theGantryRotAxis);
 
-  // And finally, restore the position to the global coordinate system
-  particle_position += theIsocenterPosition;
+  // The head rotations are performed wrt. the isocenter:
+  // x' = head * (global * (x + T) - I) + I = (head * global) * (x + T) + (I - head * I)
+  theKinematics->SetTransformation(head * global, theGlobalPhspTranslation,
+                                   theIsocenterPosition - head * theIsocenterPosition);
 }
 
 // =================================================================================
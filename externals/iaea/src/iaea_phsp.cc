@@ -148,8 +148,8 @@ IAEA_EXTERN_C IAEA_EXPORT void iaea_new_source(IAEA_I32 *source_ID, char *header
       return;
     }
     sid = __iaea_n_source - 1;
-    *source_ID = sid;
   }
+  *source_ID = sid;  // reused spots have to be reported back as well
   __iaea_source_used[sid] = true;
 
   // int ilen = strlen(header_file);
@@ -1314,6 +1314,126 @@ IAEA_EXTERN_C IAEA_EXPORT void IAEA_GET_PARTICLE__(const IAEA_I32 *id, IAEA_I32
   iaea_get_particle(id, n_stat, type, E, wt, x, y, z, u, v, w, extra_floats, extra_ints);
 }
 
+/**************************************************************************
+* Record length
+**************************************************************************/
+IAEA_EXTERN_C IAEA_EXPORT void iaea_get_record_length(const IAEA_I32 *id, IAEA_I32 *record_length) {
+  if (p_iaea_header[*id]->fheader == NULL) {
+    *record_length = -1;
+    return;
+  }
+  *record_length = p_iaea_header[*id]->record_length;
+}
+
+/**************************************************************************
+* Read a block of records
+**************************************************************************/
+IAEA_EXTERN_C IAEA_EXPORT void iaea_read_records(const IAEA_I32 *id, char *buffer, const IAEA_I64 *n_max,
+                                                 IAEA_I64 *n_read) {
+  if (p_iaea_header[*id]->fheader == NULL) {
+    *n_read = -1;
+    return;
+  }
+  size_t record_length = (size_t) p_iaea_header[*id]->record_length;
+  *n_read = (IAEA_I64) fread(buffer, record_length, (size_t) *n_max, p_iaea_record[*id]->p_file);
+}
+
+/**************************************************************************
+* Release the phase space file stream
+**************************************************************************/
+IAEA_EXTERN_C IAEA_EXPORT void iaea_release_phsp_file(const IAEA_I32 *id, IAEA_I32 *result) {
+  if (p_iaea_header[*id]->fheader == NULL) {
+    *result = -1;
+    return;
+  }
+  *result = 0;
+  if (p_iaea_record[*id]->p_file == NULL) return;  // already released
+  fclose(p_iaea_record[*id]->p_file);
+  p_iaea_record[*id]->p_file = NULL;
+}
+
+/**************************************************************************
+* Decode a block of records
+*
+* The decoding follows iaea_record_type::read_particle and iaea_get_particle
+**************************************************************************/
+IAEA_EXTERN_C IAEA_EXPORT void iaea_decode_particles(const IAEA_I32 *id, const char *buffer,
+                                                     const IAEA_I64 *n_particles, IAEA_I32 *n_stat,
+                                                     IAEA_I32 *type, /* particle type */
+                                                     IAEA_Float *E,  /* kinetic energy in MeV */
+                                                     IAEA_Float *wt, /* statistical weight */
+                                                     IAEA_Float *x, IAEA_Float *y,
+                                                     IAEA_Float *z, /* position in cartesian coordinates*/
+                                                     IAEA_Float *u, IAEA_Float *v,
+                                                     IAEA_Float *w, /* direction in cartesian coordinates*/
+                                                     IAEA_Float *extra_floats, IAEA_I32 *extra_ints) {
+  const iaea_record_type *p = p_iaea_record[*id];
+  const iaea_header_type *h = p_iaea_header[*id];
+  const size_t record_length = (size_t) h->record_length;
+
+  // number of floats stored per record (energy is always stored)
+  int n_float = 1 + (p->ix > 0) + (p->iy > 0) + (p->iz > 0) + (p->iu > 0) + (p->iv > 0) + (p->iweight > 0);
+  n_float += p->iextrafloat;
+
+  // extra long holding the incremental number of histories (if any)
+  int history_long = -1;
+  for (int j = 0; j < p->iextralong; j++)
+    if (h->extralong_contents[j] == 1) history_long = j;
+
+  float floatArray[NUM_EXTRA_FLOAT + 7];
+  IAEA_I32 longArray[NUM_EXTRA_LONG + 7];
+
+  for (IAEA_I64 k = 0; k < *n_particles; k++) {
+    const char *record = buffer + k * record_length;
+
+    short particle = (short) (signed char) record[0];
+    int is = 1;  // getting sign of Z director cosine w
+    if (particle < 0) {
+      is = -1;
+      particle = -particle;
+    }
+    memcpy(floatArray, record + sizeof(char), n_float * sizeof(float));
+    if (p->iextralong > 0)
+      memcpy(longArray, record + sizeof(char) + n_float * sizeof(float), p->iextralong * sizeof(IAEA_I32));
+
+    n_stat[k] = floatArray[0] < 0 ? 1 : 0;  // like egsnrc
+    if (history_long >= 0) n_stat[k] = longArray[history_long];
+
+    type[k] = particle;
+    E[k] = fabs(floatArray[0]);
+
+    int i = 0;
+    float xk = p->ix > 0 ? floatArray[++i] : h->record_constant[0];
+    float yk = p->iy > 0 ? floatArray[++i] : h->record_constant[1];
+    float zk = p->iz > 0 ? floatArray[++i] : h->record_constant[2];
+    float uk = p->iu > 0 ? floatArray[++i] : h->record_constant[3];
+    float vk = p->iv > 0 ? floatArray[++i] : h->record_constant[4];
+    float wk = h->record_constant[5];
+    wt[k] = p->iweight > 0 ? floatArray[++i] : h->record_constant[6];
+    for (int j = 0; j < p->iextrafloat; j++) extra_floats[k * p->iextrafloat + j] = floatArray[++i];
+    for (int j = 0; j < p->iextralong; j++) extra_ints[k * p->iextralong + j] = longArray[j];
+
+    if (p->iw > 0) {
+      wk = 0.f;
+      double aux = (uk * uk + vk * vk);
+      if (aux <= 1.0)
+        wk = (float) (is * sqrt((float) (1.0 - aux)));
+      else {
+        aux = sqrt((float) aux);
+        uk /= (float) aux;
+        vk /= (float) aux;
+      }
+    }
+
+    x[k] = xk;
+    y[k] = yk;
+    z[k] = zk;
+    u[k] = uk;
+    v[k] = vk;
+    w[k] = wk;
+  }
+}
+
 /**************************************************************************
 * Write a particle
 * n_stat = 0 for a secondary particle
@@ -1458,8 +1578,8 @@ IAEA_EXTERN_C IAEA_EXPORT void iaea_destroy_source(const IAEA_I32 *source_ID, IA
   // Deallocating IAEA phsp header
   free(p_iaea_header[*source_ID]);
 
-  // Closing phsp file
-  fclose(p_iaea_record[*source_ID]->p_file);
+  // Closing phsp file (unless already released, see iaea_release_phsp_file)
+  if (p_iaea_record[*source_ID]->p_file != NULL) fclose(p_iaea_record[*source_ID]->p_file);
   // Deallocating IAEA record
   free(p_iaea_record[*source_ID]);
 
@@ -0,0 +1,43 @@
+#!/bin/bash
+#
+# Primary generation scaling benchmark: runs the same job with 1..N threads
+# and reports the wall time, the events rate and the speedup wrt. single thread.
+#
+# usage: ./phsp_scaling.sh <job.toml> [max threads (nproc)] [events per run (100000)] [g4rt executable]
+#
+# The per-thread generation statistics are taken from the PrimaryGenerationAction log lines.
+
+JOB=$1
+MAX_THREADS=${2:-$(nproc)}
+NEVT=${3:-100000}
+G4RT=${4:-g4rt}
+
+if [ -z "${JOB}" ] || [ ! -f "${JOB}" ]; then
+    echo "usage: $0 <job.toml> [max threads] [events per run] [g4rt executable]"
+    exit 1
+fi
+
+OUTDIR=$(mktemp -d -t g4rt_scaling_XXXX)
+printf "%8s %12s %12s %10s %16s\n" "threads" "wall [s]" "evt/s" "speedup" "gen evt/s/thread"
+
+# powers of two up to the requested maximum, the maximum itself included
+THREADS=""
+for (( N=1; N<MAX_THREADS; N*=2 )); do THREADS="${THREADS} ${N}"; done
+THREADS="${THREADS} ${MAX_THREADS}"
+
+T1=""
+for N in ${THREADS}; do
+    LOG=${OUTDIR}/scaling_j${N}.log
+    START=$(date +%s.%N)
+    ${G4RT} -f -t ${JOB} -j ${N} -n ${NEVT} -o ${OUTDIR}/j${N} > ${LOG} 2>&1
+    END=$(date +%s.%N)
+    WALL=$(echo "${END} - ${START}" | bc -l)
+    [ -z "${T1}" ] && T1=${WALL}
+    RATE=$(echo "${NEVT} / ${WALL}" | bc -l)
+    SPEEDUP=$(echo "${T1} / ${WALL}" | bc -l)
+    GEN=$(grep "PrimaryGenerationAction:: thread" ${LOG} | sed -n 's/.*(\([0-9.]*\) evt\/s).*/\1/p' \
+          | awk '{s+=$1; n++} END {if(n>0) printf "%.1f", s/n; else printf "n/a"}')
+    printf "%8d %12.2f %12.1f %10.2f %16s\n" ${N} ${WALL} ${RATE} ${SPEEDUP} ${GEN}
+done
+
+echo "Logs and outputs: ${OUTDIR}"